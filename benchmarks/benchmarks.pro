@@ -24,7 +24,11 @@ TEMPLATE = subdirs
 
 SUBDIRS = \
     bm_qtcontacts_trackerplugin_batchsaving.pro \
+    bm_qtcontacts_trackerplugin_export.pro \
     bm_qtcontacts_trackerplugin_fetch.pro \
+    bm_qtcontacts_trackerplugin_keypad.pro \
+    bm_qtcontacts_trackerplugin_mergedcontacts.pro \
+    bm_qtcontacts_trackerplugin_phoneutils.pro \
     bm_qtcontacts_trackerplugin_wordcompletion.pro \
     bm_qtcontacts_trackerplugin_merge.pro
 
@@ -42,7 +42,8 @@ class Benchmark : public QObject
 public:
     Benchmark(unsigned int contactsCount, unsigned int groupsCount,
               unsigned int contactsPerGroupCount, unsigned int bsizeCount, bool fullDetails,
-              bool overwriteContacts, const QStringList &detailMask, QObject *parent = 0)
+              bool overwriteContacts, const QStringList &detailMask, bool throughput,
+              QObject *parent = 0)
         : QObject(parent)
         , m_contactCount(contactsCount)
         , m_groupsCount(groupsCount)
@@ -51,6 +52,7 @@ public:
         , m_full(fullDetails)
         , m_overwrite(overwriteContacts)
         , m_detailMask(detailMask)
+        , m_throughput(throughput)
     {
         QMap<QString, QString> params;
         params[QLatin1String("debug")] = QLatin1String("no-nagging");
@@ -163,6 +165,11 @@ public:
         unsigned int todo = groupsCount * m_contactsPerGroupCount;
         unsigned int bsize;
 
+        if (m_throughput) {
+            performHasMemberThroughput(todo);
+            return;
+        }
+
          while (0 < todo) {
             bsize = (todo > m_batchSize) ? m_batchSize : todo;
 
@@ -189,6 +196,68 @@ public:
         };
     }
 
+    /// Measures how many relationships per second get saved, and then removed again,
+    /// without the per batch logging of the regular mode getting into the numbers.
+    void performHasMemberThroughput(unsigned int relationshipCount)
+    {
+        const QList<QContactRelationship> relationships = generateRelationships(relationshipCount);
+        const int batchSize = qMax(1u, m_batchSize);
+
+        QElapsedTimer timer;
+        timer.start();
+
+        for(int i = 0; i < relationships.count(); i += batchSize) {
+            QContactRelationshipSaveRequest request;
+            request.setRelationships(relationships.mid(i, batchSize));
+            request.setManager(m_manager);
+            request.start();
+            request.waitForFinished();
+
+            if (request.error() != QContactManager::NoError) {
+                qWarning("Saving relationships failed: error %d", request.error());
+            }
+        }
+
+        reportThroughput("relationships", "saved", relationships.count(), timer.elapsed());
+
+        timer.start();
+
+        for(int i = 0; i < relationships.count(); i += batchSize) {
+            QContactRelationshipRemoveRequest request;
+            request.setRelationships(relationships.mid(i, batchSize));
+            request.setManager(m_manager);
+            request.start();
+            request.waitForFinished();
+
+            if (request.error() != QContactManager::NoError) {
+                qWarning("Removing relationships failed: error %d", request.error());
+            }
+        }
+
+        reportThroughput("relationships", "removed", relationships.count(), timer.elapsed());
+    }
+
+    static void reportThroughput(const char *items, const char *action, int count, qint64 elapsed)
+    {
+        qDebug("%d %s %s in %.3fs (%.1f %s/s)", count, items, action, elapsed / 1000.0,
+               elapsed > 0 ? count * 1000.0 / elapsed : 0.0, items);
+    }
+
+    /// Removes the contacts with a single remove request and reports how long that took.
+    void removeContacts(const char *items, const QList<QContactLocalId> &localIds)
+    {
+        qDebug() << "Removing" << items << localIds.size();
+
+        QElapsedTimer timer;
+        timer.start();
+
+        if (not m_manager->removeContacts(localIds)) {
+            qWarning("Removing %s failed: error %d", items, m_manager->error());
+        }
+
+        reportThroughput(items, "removed", localIds.size(), timer.elapsed());
+    }
+
     void performCleanup()
     {
         QList<QContactLocalId> localIds;
@@ -200,8 +269,7 @@ public:
         }
 
         if (not localIds.isEmpty()) {
-            qDebug() << "Removing groups:" << localIds.size();
-            m_manager->removeContacts(localIds);
+            removeContacts("groups", localIds);
         }
 
         localIds.clear();
@@ -213,8 +281,7 @@ public:
         }
 
         if (not localIds.isEmpty()) {
-            qDebug() << "Removing contacts:" << localIds.size();
-            m_manager->removeContacts(localIds);
+            removeContacts("contacts", localIds);
         }
     }
 
@@ -493,6 +560,7 @@ private:
     bool m_full;
     bool m_overwrite;
     QStringList m_detailMask;
+    bool m_throughput;
 };
 
 #include "bm_qtcontacts_trackerplugin_batchsaving.moc"
@@ -505,6 +573,7 @@ static const QString overwriteDetailsOption = QString::fromLatin1("--overwrite="
 static const QLatin1String fullContactsOption = QLatin1String("--full");
 static const QLatin1String overwriteContactsOption = QLatin1String("--overwrite");
 static const QLatin1String cleanupAfterOption = QLatin1String("--cleanup");
+static const QLatin1String throughputOption = QLatin1String("--throughput");
 
 int main(int argc, char* argv[])
 {
@@ -526,6 +595,7 @@ int main(int argc, char* argv[])
     bool full = false;
     bool overwrite = false;
     bool cleanupAfter = false;
+    bool throughput = false;
 
     foreach (const QString& argument, QCoreApplication::arguments()) {
         if (argument == QCoreApplication::arguments()[0]) {
@@ -557,6 +627,8 @@ int main(int argc, char* argv[])
             overwrite = true;
         } else if (argument == cleanupAfterOption) {
             cleanupAfter = true;
+        } else if (argument == throughputOption) {
+            throughput = true;
         } else {
             qDebug() << "Error: unknown argument " << argument;
             return 2;
@@ -583,7 +655,7 @@ int main(int argc, char* argv[])
             << (overwrite ? "overwriting" : "new contacts");
 
     Benchmark *bm = new Benchmark(contactCount, groupCount, contactsPerGroupCount,
-                                  batchSize, full, overwrite, detailMask, &app);
+                                  batchSize, full, overwrite, detailMask, throughput, &app);
 
     QTime t;
     t.start();
@@ -0,0 +1,166 @@
+/*********************************************************************************
+ ** This file is part of QtContacts tracker storage plugin
+ **
+ ** Copyright (c) 2011 Nokia Corporation and/or its subsidiary(-ies).
+ **
+ ** Contact:  Nokia Corporation (info@qt.nokia.com)
+ **
+ ** GNU Lesser General Public License Usage
+ ** This file may be used under the terms of the GNU Lesser General Public License
+ ** version 2.1 as published by the Free Software Foundation and appearing in the
+ ** file LICENSE.LGPL included in the packaging of this file.  Please review the
+ ** following information to ensure the GNU Lesser General Public License version
+ ** 2.1 requirements will be met:
+ ** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+ **
+ ** In addition, as a special exception, Nokia gives you certain additional rights.
+ ** These rights are described in the Nokia Qt LGPL Exception version 1.1, included
+ ** in the file LGPL_EXCEPTION.txt in this package.
+ **
+ ** Other Usage
+ ** Alternatively, this file may be used in accordance with the terms and
+ ** conditions contained in a signed written agreement between you and Nokia.
+ *********************************************************************************/
+
+#include <QtCore>
+
+#include <qtcontacts.h>
+#include <qversitcontactexporter.h>
+#include <qversitwriter.h>
+
+QTM_USE_NAMESPACE
+
+static const int DefaultPageSize = 100;
+
+/// Peak resident set size of this process in kB, as reported by the kernel.
+static qint64
+peakMemoryUsage()
+{
+    QFile status(QLatin1String("/proc/self/status"));
+
+    if (not status.open(QFile::ReadOnly)) {
+        return -1;
+    }
+
+    const QRegExp pattern(QLatin1String("^VmHWM:\\s*(\\d+)\\s*kB"));
+
+    forever {
+        const QString line = QString::fromLatin1(status.readLine());
+
+        if (line.isEmpty()) {
+            break;
+        }
+
+        if (-1 != pattern.indexIn(line)) {
+            return pattern.cap(1).toLongLong();
+        }
+    }
+
+    return -1;
+}
+
+static bool
+writeContacts(QIODevice *device, const QList<QContact> &contacts)
+{
+    QVersitContactExporter exporter;
+
+    if (not exporter.exportContacts(contacts)) {
+        return false;
+    }
+
+    QVersitWriter writer(device);
+
+    return (writer.startWriting(exporter.documents()) &&
+            writer.waitForFinished() &&
+            QVersitWriter::NoError == writer.error());
+}
+
+int
+main(int argc, char **argv)
+{
+    QCoreApplication app(argc, argv);
+
+    // load plugin from build directory
+    const QDir appdir = QDir(app.applicationDirPath());
+    const QDir topdir = QDir(appdir.relativeFilePath(QLatin1String("..")));
+    app.setLibraryPaths(QStringList(topdir.absolutePath()) + app.libraryPaths());
+
+    // process command line arguments
+    const QString pageSizeOption = QLatin1String("--page-size=");
+    const QString outputOption = QLatin1String("--output=");
+
+    int pageSize = DefaultPageSize;
+    QString outputFileName = QLatin1String("/dev/null");
+
+    foreach(const QString &argument, app.arguments().mid(1)) {
+        if (argument.startsWith(pageSizeOption)) {
+            bool success = false;
+            pageSize = argument.mid(pageSizeOption.length()).toInt(&success);
+
+            if (not success || pageSize < 0) {
+                qDebug() << "Error: invalid page size" << argument;
+                return 2;
+            }
+        } else if (argument.startsWith(outputOption)) {
+            outputFileName = argument.mid(outputOption.length());
+        } else {
+            qDebug() << "Error: unknown argument " << argument;
+            qDebug() << "Usage:" << argv[0] << "[--page-size=N] [--output=FILE]";
+            qDebug() << "A page size of 0 exports the entire address book in one go.";
+            qDebug() << "Import data/contacts-1000.ttl into tracker before running.";
+            return 2;
+        }
+    }
+
+    QFile output(outputFileName);
+
+    if (not output.open(QFile::WriteOnly | QFile::Truncate)) {
+        qDebug() << "Error: cannot open" << outputFileName << output.errorString();
+        return 1;
+    }
+
+    qDebug() << "page size:" << pageSize;
+    qDebug() << "output:" << outputFileName;
+
+    // run the benchmark
+    QContactManager cm(QLatin1String("tracker"));
+
+    QContactFetchHint fetchHint;
+    fetchHint.setOptimizationHints(QContactFetchHint::NoRelationships);
+
+    const qint64 initialMemory = peakMemoryUsage();
+
+    QElapsedTimer timer;
+    timer.start();
+
+    QList<QContactLocalId> localIds = cm.contactIds();
+    qSort(localIds);
+
+    const int step = (pageSize > 0 ? pageSize : localIds.count());
+    qint64 fetchTime = 0, writeTime = 0;
+    int pages = 0;
+
+    for(int offset = 0; offset < localIds.count(); offset += step, ++pages) {
+        QElapsedTimer pageTimer;
+        pageTimer.start();
+
+        const QList<QContact> contacts = cm.contacts(localIds.mid(offset, step), fetchHint);
+        fetchTime += pageTimer.restart();
+
+        if (not writeContacts(&output, contacts)) {
+            qDebug() << "Error: cannot write page" << pages;
+            return 1;
+        }
+
+        writeTime += pageTimer.elapsed();
+    }
+
+    qDebug("Exported %d contact(s) in %d page(s), %lld bytes written",
+           localIds.count(), pages, output.size());
+    qDebug("Time needed: %.3fs (fetch: %.3fs, write: %.3fs)",
+           timer.elapsed() / 1000.0, fetchTime / 1000.0, writeTime / 1000.0);
+    qDebug("Peak memory: %lld kB (%lld kB before export)",
+           peakMemoryUsage(), initialMemory);
+
+    return 0;
+}
@@ -0,0 +1,208 @@
+/*********************************************************************************
+ ** This file is part of QtContacts tracker storage plugin
+ **
+ ** Copyright (c) 2011 Nokia Corporation and/or its subsidiary(-ies).
+ **
+ ** Contact:  Nokia Corporation (info@qt.nokia.com)
+ **
+ ** GNU Lesser General Public License Usage
+ ** This file may be used under the terms of the GNU Lesser General Public License
+ ** version 2.1 as published by the Free Software Foundation and appearing in the
+ ** file LICENSE.LGPL included in the packaging of this file.  Please review the
+ ** following information to ensure the GNU Lesser General Public License version
+ ** 2.1 requirements will be met:
+ ** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+ **
+ ** In addition, as a special exception, Nokia gives you certain additional rights.
+ ** These rights are described in the Nokia Qt LGPL Exception version 1.1, included
+ ** in the file LGPL_EXCEPTION.txt in this package.
+ **
+ ** Other Usage
+ ** Alternatively, this file may be used in accordance with the terms and
+ ** conditions contained in a signed written agreement between you and Nokia.
+ *********************************************************************************/
+
+#include <QtCore>
+
+#include <qtcontacts.h>
+#include <lib/keypadmatchrequest.h>
+#include <lib/phoneutils.h>
+
+QTM_USE_NAMESPACE
+
+static const int DefaultContactCount = 10000;
+static const int BatchSize = 250;
+
+static QList<QContact>
+generateContacts(int offset, int count)
+{
+    static const char *const firstNames[] = {
+        "John", "Jane", "Kalle", "Maija", "Emilia", "Odoardo", "Marinelli", "Claudia",
+        "Hettore", "Appiani", "Conti", "Angelo", "Pirro", "Battista", "Orsina", "Camillo"
+    };
+    static const char *const lastNames[] = {
+        "Galotti", "Gonzaga", "Rota", "Smith", "Virtanen", "Korhonen", "Nieminen", "Lessing",
+        "Miller", "Wexler", "Quixote", "Panza", "Dulcinea", "Rocinante", "Sanson", "Carrasco"
+    };
+
+    static const int firstNameCount = sizeof firstNames / sizeof *firstNames;
+    static const int lastNameCount = sizeof lastNames / sizeof *lastNames;
+
+    QList<QContact> contacts;
+
+    for(int i = offset; i < offset + count; ++i) {
+        QContact contact;
+
+        QContactName name;
+        name.setFirstName(QLatin1String(firstNames[i % firstNameCount]));
+        name.setLastName(QLatin1String(lastNames[(i / firstNameCount) % lastNameCount]) +
+                         QString::number(i));
+        contact.saveDetail(&name);
+
+        QContactPhoneNumber phoneNumber;
+        phoneNumber.setNumber(QString::fromLatin1("+358 40 %1").arg(i, 7, 10, QLatin1Char('0')));
+        contact.saveDetail(&phoneNumber);
+
+        contacts += contact;
+    }
+
+    return contacts;
+}
+
+/// The smart-dial approach this benchmark is about to replace: fetch all names and
+/// numbers, and match them in memory.
+static QList<QContactLocalId>
+matchInMemory(QContactManager &manager, const QString &digits)
+{
+    QContactFetchHint fetchHint;
+    fetchHint.setDetailDefinitionsHint(QStringList() << QContactName::DefinitionName
+                                                     << QContactPhoneNumber::DefinitionName);
+    fetchHint.setOptimizationHints(QContactFetchHint::NoRelationships);
+
+    QList<QContactLocalId> result;
+
+    foreach(const QContact &contact, manager.contacts(QContactFilter(), QList<QContactSortOrder>(), fetchHint)) {
+        const QContactName name = contact.detail<QContactName>();
+        bool matches = (qctMakeKeypadDigits(name.firstName()).startsWith(digits) ||
+                        qctMakeKeypadDigits(name.lastName()).startsWith(digits));
+
+        foreach(const QContactPhoneNumber &number, contact.details<QContactPhoneNumber>()) {
+            matches = matches || qctMakeKeypadDigits(number.number()).contains(digits);
+        }
+
+        if (matches) {
+            result += contact.localId();
+        }
+    }
+
+    return result;
+}
+
+static QList<QContactLocalId>
+matchWithRequest(QContactManager &manager, const QString &digits)
+{
+    QctKeypadMatchRequest request;
+    request.setManager(&manager);
+    request.setDigits(digits);
+
+    if (not request.start() || not request.waitForFinished()) {
+        qWarning("Keypad match request failed for %s", qPrintable(digits));
+        return QList<QContactLocalId>();
+    }
+
+    return request.ids();
+}
+
+int
+main(int argc, char **argv)
+{
+    QCoreApplication app(argc, argv);
+
+    // load plugin from build directory
+    const QDir appdir = QDir(app.applicationDirPath());
+    const QDir topdir = QDir(appdir.relativeFilePath(QLatin1String("..")));
+    app.setLibraryPaths(QStringList(topdir.absolutePath()) + app.libraryPaths());
+
+    // process command line arguments
+    static const QString keepContactsOption = QLatin1String("--keep-contacts");
+
+    QStringList args = app.arguments();
+    const bool keepContacts = args.removeAll(keepContactsOption) > 0;
+
+    int contactCount = 0;
+
+    if (args.count() > 1) {
+        contactCount = args[1].toInt();
+    }
+
+    if (contactCount < 1) {
+        contactCount = DefaultContactCount;
+    }
+
+    QStringList digitSequences = args.mid(2);
+
+    if (digitSequences.isEmpty()) {
+        digitSequences << QLatin1String("5")
+                       << QLatin1String("56")
+                       << QLatin1String("564")
+                       << QLatin1String("5646")
+                       << QLatin1String("40000")
+                       << QLatin1String("4000123");
+    }
+
+    QMap<QString, QString> params;
+    params.insert(QLatin1String("debug"), QLatin1String("no-nagging"));
+
+    QContactManager manager(QLatin1String("tracker"), params);
+
+    // create the test contacts
+    qDebug() << "creating" << contactCount << "contacts";
+
+    QElapsedTimer timer;
+    timer.start();
+
+    QList<QContactLocalId> createdIds;
+
+    for(int offset = 0; offset < contactCount; offset += BatchSize) {
+        QList<QContact> contacts = generateContacts(offset, qMin(BatchSize, contactCount - offset));
+
+        if (not manager.saveContacts(&contacts)) {
+            qWarning("Saving contacts failed: error %d", manager.error());
+            return 1;
+        }
+
+        foreach(const QContact &contact, contacts) {
+            createdIds += contact.localId();
+        }
+    }
+
+    qDebug("contacts created in %.3fs", timer.elapsed() / 1000.0);
+
+    // first lookup also builds the index
+    timer.start();
+    matchWithRequest(manager, digitSequences.first());
+    qDebug("keypad index built in %.3fs", timer.elapsed() / 1000.0);
+
+    foreach(const QString &digits, digitSequences) {
+        timer.start();
+        const int indexMatches = matchWithRequest(manager, digits).count();
+        const qint64 indexTime = timer.elapsed();
+
+        timer.start();
+        const int memoryMatches = matchInMemory(manager, digits).count();
+        const qint64 memoryTime = timer.elapsed();
+
+        qDebug("\"%s\": request: %d contact(s) in %.3fs, fetch all: %d contact(s) in %.3fs",
+               qPrintable(digits), indexMatches, indexTime / 1000.0,
+               memoryMatches, memoryTime / 1000.0);
+    }
+
+    // cleanup
+    if (not keepContacts) {
+        timer.start();
+        manager.removeContacts(createdIds);
+        qDebug("contacts removed in %.3fs", timer.elapsed() / 1000.0);
+    }
+
+    return 0;
+}
@@ -38,7 +38,12 @@ public:
         : QObject(parent)
     {
         static const QString managerName = QString::fromLatin1("tracker");
-        m_manager.reset(new QContactManager(managerName));
+
+        // let the merge worker print the time spent in each of its phases
+        QMap<QString, QString> params;
+        params.insert(QLatin1String("debug"), QLatin1String("timing"));
+
+        m_manager.reset(new QContactManager(managerName, params));
         Q_ASSERT(not m_manager.isNull() && m_manager->managerName() == managerName);
 
         m_request.reset(new QContactLocalIdFetchRequest());
@@ -60,6 +65,8 @@ private slots:
         case QContactAbstractRequest::FinishedState:
         case QContactAbstractRequest::CanceledState:
             {
+            qDebug() << "Fetched" << m_request->ids().size() << "ids in" << m_timer.elapsed() << "ms";
+
             QList<QContactLocalId> ids = m_request->ids();
             ids.removeAll(m_manager->selfContactId());
             if (ids.length() % 2 > 0) {
@@ -90,7 +97,8 @@ private slots:
         switch (state) {
         case QContactAbstractRequest::FinishedState:
         case QContactAbstractRequest::CanceledState:
-            qDebug() << "Merged " << m_mergeRequest->mergeIds().size() << "elements in " << m_timer.elapsed();
+            qDebug() << "Merged" << m_mergeRequest->mergeIds().size() << "elements in" << m_timer.elapsed() << "ms"
+                     << "- error:" << m_mergeRequest->error();
             QCoreApplication::exit();
         default:
             break;
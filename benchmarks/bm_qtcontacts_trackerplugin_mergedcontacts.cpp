@@ -0,0 +1,175 @@
+/*********************************************************************************
+ ** This file is part of QtContacts tracker storage plugin
+ **
+ ** Copyright (c) 2011 Nokia Corporation and/or its subsidiary(-ies).
+ **
+ ** Contact:  Nokia Corporation (info@qt.nokia.com)
+ **
+ ** GNU Lesser General Public License Usage
+ ** This file may be used under the terms of the GNU Lesser General Public License
+ ** version 2.1 as published by the Free Software Foundation and appearing in the
+ ** file LICENSE.LGPL included in the packaging of this file.  Please review the
+ ** following information to ensure the GNU Lesser General Public License version
+ ** 2.1 requirements will be met:
+ ** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+ **
+ ** In addition, as a special exception, Nokia gives you certain additional rights.
+ ** These rights are described in the Nokia Qt LGPL Exception version 1.1, included
+ ** in the file LGPL_EXCEPTION.txt in this package.
+ **
+ ** Other Usage
+ ** Alternatively, this file may be used in accordance with the terms and
+ ** conditions contained in a signed written agreement between you and Nokia.
+ *********************************************************************************/
+
+#include <QtCore>
+
+#include <qtcontacts.h>
+
+QTM_USE_NAMESPACE
+
+static const int DefaultContactCount = 200;
+static const int DefaultAccountCount = 12;
+static const int FetchRounds = 5;
+static const int BatchSize = 50;
+
+/// Builds contacts looking like the result of merging several IM contacts: each of them
+/// has @p accountCount online accounts with a linked avatar, phone number and email address.
+static QList<QContact>
+generateContacts(int offset, int count, int accountCount)
+{
+    static const QString accountPathPattern =
+            QLatin1String("/org/freedesktop/Telepathy/Account/gabble/jabber/benchmark%1");
+    static const QString accountIriPattern = QLatin1String("telepathy:%1!%2");
+
+    QList<QContact> contacts;
+
+    for(int i = offset; i < offset + count; ++i) {
+        QContact contact;
+
+        QContactName name;
+        name.setFirstName(QLatin1String("Merged"));
+        name.setLastName(QString::fromLatin1("Contact%1").arg(i));
+        contact.saveDetail(&name);
+
+        for(int k = 0; k < accountCount; ++k) {
+            const QString accountPath = accountPathPattern.arg(k);
+            const QString accountUri = QString::fromLatin1("merged%1.%2@example.com").arg(i).arg(k);
+
+            QContactOnlineAccount account;
+            account.setAccountUri(accountUri);
+            account.setValue(QLatin1String("AccountPath"), accountPath);
+            account.setDetailUri(accountIriPattern.arg(accountPath, accountUri));
+            contact.saveDetail(&account);
+
+            QContactAvatar avatar;
+            avatar.setImageUrl(QUrl(QString::fromLatin1("file:///tmp/merged%1.%2.png").arg(i).arg(k)));
+            avatar.setLinkedDetailUris(account.detailUri());
+            contact.saveDetail(&avatar);
+
+            QContactPhoneNumber phoneNumber;
+            phoneNumber.setNumber(QString::fromLatin1("+358 40 %1%2").
+                                  arg(i, 5, 10, QLatin1Char('0')).arg(k, 2, 10, QLatin1Char('0')));
+            contact.saveDetail(&phoneNumber);
+
+            QContactEmailAddress emailAddress;
+            emailAddress.setEmailAddress(accountUri);
+            contact.saveDetail(&emailAddress);
+        }
+
+        contacts += contact;
+    }
+
+    return contacts;
+}
+
+int
+main(int argc, char **argv)
+{
+    QCoreApplication app(argc, argv);
+
+    // load plugin from build directory
+    const QDir appdir = QDir(app.applicationDirPath());
+    const QDir topdir = QDir(appdir.relativeFilePath(QLatin1String("..")));
+    app.setLibraryPaths(QStringList(topdir.absolutePath()) + app.libraryPaths());
+
+    // process command line arguments
+    static const QString keepContactsOption = QLatin1String("--keep-contacts");
+
+    QStringList args = app.arguments();
+    const bool keepContacts = args.removeAll(keepContactsOption) > 0;
+
+    int contactCount = (args.count() > 1 ? args[1].toInt() : 0);
+    int accountCount = (args.count() > 2 ? args[2].toInt() : 0);
+
+    if (contactCount < 1) {
+        contactCount = DefaultContactCount;
+    }
+
+    if (accountCount < 1) {
+        accountCount = DefaultAccountCount;
+    }
+
+    QMap<QString, QString> params;
+    params.insert(QLatin1String("debug"), QLatin1String("no-nagging"));
+
+    QContactManager manager(QLatin1String("tracker"), params);
+
+    // create the test contacts
+    qDebug() << "creating" << contactCount << "contacts with" << accountCount << "merged accounts";
+
+    QElapsedTimer timer;
+    timer.start();
+
+    QList<QContactLocalId> createdIds;
+
+    for(int offset = 0; offset < contactCount; offset += BatchSize) {
+        QList<QContact> contacts = generateContacts(offset, qMin(BatchSize, contactCount - offset), accountCount);
+
+        if (not manager.saveContacts(&contacts)) {
+            qWarning("Saving contacts failed: error %d", manager.error());
+            return 1;
+        }
+
+        foreach(const QContact &contact, contacts) {
+            createdIds += contact.localId();
+        }
+    }
+
+    qDebug("contacts created in %.3fs", timer.elapsed() / 1000.0);
+
+    // fetch them back
+    QContactLocalIdFilter filter;
+    filter.setIds(createdIds);
+
+    qint64 totalTime = 0;
+
+    for(int round = 0; round < FetchRounds; ++round) {
+        timer.start();
+        const QList<QContact> contacts = manager.contacts(filter);
+        const qint64 elapsed = timer.elapsed();
+
+        int detailCount = 0;
+
+        foreach(const QContact &contact, contacts) {
+            detailCount += contact.details().count();
+        }
+
+        qDebug("round %d: %d contact(s) with %.1f details on average fetched in %.3fs",
+               round + 1, contacts.count(), contacts.isEmpty() ? 0.0 : double(detailCount) / contacts.count(),
+               elapsed / 1000.0);
+
+        totalTime += elapsed;
+    }
+
+    qDebug("average fetch time: %.3fs", totalTime / 1000.0 / FetchRounds);
+
+    // cleanup
+    if (not keepContacts) {
+        timer.start();
+        manager.removeContacts(createdIds);
+        qDebug("contacts removed in %.3fs", timer.elapsed() / 1000.0);
+    }
+
+    return 0;
+}
@@ -0,0 +1,159 @@
+/*********************************************************************************
+ ** This file is part of QtContacts tracker storage plugin
+ **
+ ** Copyright (c) 2011 Nokia Corporation and/or its subsidiary(-ies).
+ **
+ ** Contact:  Nokia Corporation (info@qt.nokia.com)
+ **
+ ** GNU Lesser General Public License Usage
+ ** This file may be used under the terms of the GNU Lesser General Public License
+ ** version 2.1 as published by the Free Software Foundation and appearing in the
+ ** file LICENSE.LGPL included in the packaging of this file.  Please review the
+ ** following information to ensure the GNU Lesser General Public License version
+ ** 2.1 requirements will be met:
+ ** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+ **
+ ** In addition, as a special exception, Nokia gives you certain additional rights.
+ ** These rights are described in the Nokia Qt LGPL Exception version 1.1, included
+ ** in the file LGPL_EXCEPTION.txt in this package.
+ **
+ ** Other Usage
+ ** Alternatively, this file may be used in accordance with the terms and
+ ** conditions contained in a signed written agreement between you and Nokia.
+ *********************************************************************************/
+
+#include <QtCore>
+
+#include <lib/phoneutils.h>
+
+static const int DefaultIterations = 100;
+
+static QStringList
+readPhoneNumbers(const QString &fileName)
+{
+    QFile file(fileName);
+    QStringList numbers;
+
+    if (not file.open(QFile::ReadOnly)) {
+        qWarning("Cannot open %s for reading: %s",
+                 qPrintable(fileName), qPrintable(file.errorString()));
+        return numbers;
+    }
+
+    // A poor man's vCard parser, but good enough for extracting TEL properties
+    // from the files in our data directory.
+    while(not file.atEnd()) {
+        const QString line = QString::fromUtf8(file.readLine()).trimmed();
+
+        if (line.startsWith(QLatin1String("TEL"), Qt::CaseInsensitive)) {
+            const int colon = line.indexOf(QLatin1Char(':'));
+
+            if (colon > 0) {
+                numbers += line.mid(colon + 1);
+            }
+        }
+    }
+
+    return numbers;
+}
+
+static bool
+isLatin1(const QString &text)
+{
+    foreach(const QChar ch, text) {
+        if (ch.unicode() > 0xff) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static void
+benchmark(const char *title, const QStringList &numbers, int iterations)
+{
+    if (numbers.isEmpty()) {
+        return;
+    }
+
+    const Qct::NumberNormalizationOptions options =
+            Qct::RemoveUnicodeFormatters | Qct::RemoveNumberFormatters | Qct::ConvertToLatin;
+
+    QElapsedTimer timer;
+    int checksum = 0;
+
+    timer.start();
+
+    for(int i = 0; i < iterations; ++i) {
+        foreach(const QString &number, numbers) {
+            checksum += qctNormalizePhoneNumber(number, options).length();
+        }
+    }
+
+    const qint64 normalizeTime = timer.restart();
+
+    for(int i = 0; i < iterations; ++i) {
+        foreach(const QString &number, numbers) {
+            checksum += qctMakeLocalPhoneNumber(number).length();
+        }
+    }
+
+    const qint64 localNumberTime = timer.elapsed();
+    const double calls = 1.0 * iterations * numbers.count();
+
+    qDebug("%s: %d number(s), %d iteration(s), checksum %d", title,
+           numbers.count(), iterations, checksum);
+    qDebug("  qctNormalizePhoneNumber: %.3fs, %.1f ns/call",
+           normalizeTime / 1000.0, normalizeTime * 1e6 / calls);
+    qDebug("  qctMakeLocalPhoneNumber: %.3fs, %.1f ns/call",
+           localNumberTime / 1000.0, localNumberTime * 1e6 / calls);
+}
+
+int
+main(int argc, char **argv)
+{
+    QCoreApplication app(argc, argv);
+
+    const QString iterationsOption = QLatin1String("--iterations=");
+
+    int iterations = DefaultIterations;
+    QStringList fileNames;
+
+    foreach(const QString &argument, app.arguments().mid(1)) {
+        if (argument.startsWith(iterationsOption)) {
+            bool success = false;
+            iterations = argument.mid(iterationsOption.length()).toInt(&success);
+
+            if (not success || iterations < 1) {
+                qDebug() << "Error: invalid iteration count" << argument;
+                return 2;
+            }
+        } else {
+            fileNames += argument;
+        }
+    }
+
+    if (fileNames.isEmpty()) {
+        qDebug() << "Usage:" << argv[0] << "[--iterations=N] VCARD-FILE...";
+        qDebug() << "For instance use data/contacts.vcf and data/arabic.vcf.";
+        return 2;
+    }
+
+    QStringList latin1Numbers, otherNumbers;
+
+    foreach(const QString &fileName, fileNames) {
+        foreach(const QString &number, readPhoneNumbers(fileName)) {
+            if (isLatin1(number)) {
+                latin1Numbers += number;
+            } else {
+                otherNumbers += number;
+            }
+        }
+    }
+
+    // Report both groups separately since they take different code paths.
+    benchmark("Latin-1 numbers", latin1Numbers, iterations);
+    benchmark("Other numbers", otherNumbers, iterations);
+
+    return 0;
+}
@@ -25,9 +25,158 @@
 #include <QtCore>
 
 #include <qtcontacts.h>
+#include <lib/searchsession.h>
 
 QTM_USE_NAMESPACE
 
+/// Simulates a user typing the search term at keystroke rate: For each keystroke a new
+/// prefix search is started, and the still running search for the previous prefix is canceled.
+class KeystrokeSimulator : public QObject
+{
+    Q_OBJECT
+
+public:
+    KeystrokeSimulator(QContactManager *manager, const QString &searchTerm, int interval)
+        : m_manager(manager)
+        , m_searchTerm(searchTerm)
+        , m_canceledRequests(0)
+        , m_prefixLength(0)
+    {
+        m_keystrokeTimer.setInterval(interval);
+        connect(&m_keystrokeTimer, SIGNAL(timeout()), this, SLOT(onKeystroke()));
+    }
+
+    void run()
+    {
+        m_totalTime.start();
+        m_keystrokeTimer.start();
+        onKeystroke();
+    }
+
+private slots:
+    void onKeystroke()
+    {
+        if (++m_prefixLength > m_searchTerm.length()) {
+            m_keystrokeTimer.stop();
+            return;
+        }
+
+        // stale searches are not interesting anymore
+        if (not m_request.isNull() && m_request->isActive()) {
+            if (m_request->cancel()) {
+                ++m_canceledRequests;
+            }
+        }
+
+        QContactDetailFilter filter;
+        filter.setDetailDefinitionName(QContactName::DefinitionName);
+        filter.setValue(m_searchTerm.left(m_prefixLength));
+        filter.setMatchFlags(QContactFilter::MatchStartsWith);
+
+        m_request.reset(new QContactFetchRequest);
+        m_request->setManager(m_manager);
+        m_request->setFilter(filter);
+
+        connect(m_request.data(), SIGNAL(stateChanged(QContactAbstractRequest::State)),
+                this, SLOT(onStateChanged(QContactAbstractRequest::State)));
+
+        m_requestTime.start();
+        m_request->start();
+    }
+
+    void onStateChanged(QContactAbstractRequest::State state)
+    {
+        if (state != QContactAbstractRequest::FinishedState ||
+            m_prefixLength < m_searchTerm.length()) {
+            return;
+        }
+
+        qDebug("%d contact(s) found for \"%s\"",
+               m_request->contacts().count(), qPrintable(m_searchTerm));
+        qDebug("canceled requests: %d", m_canceledRequests);
+        qDebug("latency of final query: %.3fs", m_requestTime.elapsed() / 1000.0);
+        qDebug("total time: %.3fs", m_totalTime.elapsed() / 1000.0);
+
+        QCoreApplication::exit();
+    }
+
+private:
+    QContactManager *const m_manager;
+    const QString m_searchTerm;
+    QScopedPointer<QContactFetchRequest> m_request;
+    QTimer m_keystrokeTimer;
+    QElapsedTimer m_requestTime;
+    QElapsedTimer m_totalTime;
+    int m_canceledRequests;
+    int m_prefixLength;
+};
+
+/// Simulates a user typing the search term into a QctSearchSession: Each keystroke waits
+/// for the results of the previous one, to measure per-keystroke latency. Finally a
+/// backspace is simulated, which cannot be answered from the previous results.
+class SessionSimulator : public QObject
+{
+    Q_OBJECT
+
+public:
+    SessionSimulator(QContactManager *manager, const QString &searchTerm, int interval)
+        : m_session(manager)
+        , m_searchTerm(searchTerm)
+        , m_interval(interval)
+        , m_prefixLength(0)
+        , m_backspacePressed(false)
+    {
+        connect(&m_session, SIGNAL(finished()), this, SLOT(onFinished()));
+    }
+
+    void run()
+    {
+        m_totalTime.start();
+        onKeystroke();
+    }
+
+private slots:
+    void onKeystroke()
+    {
+        if (m_prefixLength < m_searchTerm.length()) {
+            ++m_prefixLength;
+        } else {
+            --m_prefixLength;
+            m_backspacePressed = true;
+        }
+
+        m_requestTime.start();
+        m_session.search(m_searchTerm.left(m_prefixLength));
+    }
+
+    void onFinished()
+    {
+        qDebug("%d contact(s) found for \"%s\", %.3fs ellapsed%s",
+               m_session.contacts().count(), qPrintable(m_session.term()),
+               m_requestTime.elapsed() / 1000.0,
+               m_session.isIncrementalResult() ? " (incremental)" : "");
+
+        if (m_backspacePressed) {
+            qDebug("total time: %.3fs", m_totalTime.elapsed() / 1000.0);
+            QCoreApplication::exit();
+            return;
+        }
+
+        QTimer::singleShot(m_interval, this, SLOT(onKeystroke()));
+    }
+
+private:
+    QctSearchSession m_session;
+    const QString m_searchTerm;
+    const int m_interval;
+    QElapsedTimer m_requestTime;
+    QElapsedTimer m_totalTime;
+    int m_prefixLength;
+    bool m_backspacePressed;
+};
+
+#include "bm_qtcontacts_trackerplugin_wordcompletion.moc"
+
 int
 main(int argc, char **argv)
 {
@@ -39,7 +188,24 @@ main(int argc, char **argv)
     app.setLibraryPaths(QStringList(topdir.absolutePath()) + app.libraryPaths());
 
     // process command line arguments
+    static const QString keystrokeIntervalOption = QLatin1String("--keystroke-interval=");
+    static const QString sessionOption = QLatin1String("--session");
+
     QStringList args = app.arguments();
+    int keystrokeInterval = -1;
+    bool useSession = false;
+
+    for(QStringList::Iterator it = args.begin(); it != args.end(); ) {
+        if (it->startsWith(keystrokeIntervalOption)) {
+            keystrokeInterval = it->mid(keystrokeIntervalOption.length()).toInt();
+            it = args.erase(it);
+        } else if (*it == sessionOption) {
+            useSession = true;
+            it = args.erase(it);
+        } else {
+            ++it;
+        }
+    }
 
     int iterations = 0;
     QString searchTerm;
@@ -66,12 +232,33 @@ main(int argc, char **argv)
         iterations = searchTerm.length();
     }
 
-    qDebug() << "iterations:" << iterations;
     qDebug() << "search term:" << searchTerm;
 
-    // run benchmark iterations
     QContactManager cm(QLatin1String("tracker"));
 
+    // simulate typing into a search session
+    if (useSession) {
+        qDebug() << "keystroke interval:" << qMax(0, keystrokeInterval) << "ms";
+
+        SessionSimulator simulator(&cm, searchTerm, qMax(0, keystrokeInterval));
+        simulator.run();
+
+        return app.exec();
+    }
+
+    // simulate typing
+    if (keystrokeInterval >= 0) {
+        qDebug() << "keystroke interval:" << keystrokeInterval << "ms";
+
+        KeystrokeSimulator simulator(&cm, searchTerm, keystrokeInterval);
+        simulator.run();
+
+        return app.exec();
+    }
+
+    // run benchmark iterations
+    qDebug() << "iterations:" << iterations;
+
     for(int i = 0; i < iterations; ++i) {
         QTime time;
         time.start();
@@ -21,6 +21,7 @@
 # conditions contained in a signed written agreement between you and Nokia.
 
 include(../src/common.pri)
+include(../src/lib/lib.pri)
 
 CONFIG += mobility
 MOBILITY += contacts
@@ -10,6 +10,9 @@
  * <ul>
  * <li>QctContactMergeRequest - Allows you to merge several contacts together</li>
  * <li>QctUnmergeIMContactsRequest - Allows you to unmerge IM accounts from a contact</li>
+ * <li>QctPhoneNumberMatchRequest - Quickly finds the contacts owning a phone number</li>
+ * <li>QctKeypadMatchRequest - Finds contacts by digits typed on a phone keypad</li>
+ * <li>QctSearchSession - Refines the results of as-you-type searches incrementally</li>
  * </ul>
  * Those classes are in the qtcontacts-extensions-tracker library.
  *
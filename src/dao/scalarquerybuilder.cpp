@@ -103,6 +103,52 @@ QTrackerScalarContactQueryBuilder::listSeparator()
     return separator;
 }
 
+QString
+QTrackerScalarContactQueryBuilder::encodeCustomDetailFields(const QVariantMap &fields)
+{
+    // Produces the same layout bindCustomDetails() builds for details stored with one
+    // nao:Property per field value, so that fetch requests can parse both alike. Instead
+    // of tracker ids the values get prefixed by their position in the field's value list.
+    QStringList encodedFields;
+
+    for(QVariantMap::ConstIterator it = fields.constBegin(); it != fields.constEnd(); ++it) {
+        QVariantList values;
+
+        switch(it.value().type()) {
+        case QVariant::StringList:
+            foreach(const QString &element, it.value().toStringList()) {
+                if (not element.isEmpty()) {
+                    values.append(element);
+                }
+            }
+
+            break;
+
+        case QVariant::List:
+            values = it.value().toList();
+            break;
+
+        default:
+            values.append(it.value());
+            break;
+        }
+
+        QStringList encodedValues;
+
+        foreach(const QVariant &value, values) {
+            if (not value.isNull()) {
+                encodedValues += QString::number(encodedValues.count()) + QLatin1Char(':') + value.toString();
+            }
+        }
+
+        if (not encodedValues.isEmpty()) {
+            encodedFields += it.key() + fieldSeparator() + encodedValues.join(listSeparator());
+        }
+    }
+
+    return encodedFields.join(fieldSeparator());
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 /// Returns the first part of the @p propertyChain including the property giving the detail uri.
@@ -1186,10 +1232,14 @@ QTrackerScalarContactQueryBuilder::bindCustomDetails(Cubi::Select &query,
                                        LiteralValue(fieldSeparator())));
     propertySelect.addRestriction(detail, nao::hasProperty::resource(), field);
 
+    // Details stored in compact form carry their encoded fields as property value,
+    // see encodeCustomDetailFields(). Otherwise collect the per-field properties.
+    const Function compactFields(nao::propertyValue::function().apply(detail));
+
     ValueChain groupConcatParams;
     groupConcatParams.append(detailName);
     groupConcatParams.append(LiteralValue(fieldSeparator()));
-    groupConcatParams.append(Filter(propertySelect));
+    groupConcatParams.append(Functions::coalesce.apply(compactFields, Filter(propertySelect)));
     customDetailsQuery.addProjection(Functions::groupConcat.
                                      apply(Functions::concat.apply(groupConcatParams),
                                            LiteralValue(detailSeparator())));
@@ -66,6 +66,8 @@ public: // attributes
     static const QChar fieldSeparator();
     static const QChar listSeparator();
 
+    static QString encodeCustomDetailFields(const QVariantMap &fields);
+
 public: // methods
     QContactManager::Error bindFields(const QTrackerContactDetail &detail,
                                       Cubi::Select &query,
@@ -24,7 +24,9 @@
 
 #include "abstractcontactfetchrequest.h"
 
+#include "displaylabelgenerator.h"
 #include "engine.h"
+#include "membershipindex.h"
 
 #include <dao/contactdetail.h>
 #include <dao/contactdetailschema.h>
@@ -32,6 +34,7 @@
 #include <dao/subject.h>
 #include <dao/support.h>
 #include <lib/constants.h>
+#include <lib/customdetails.h>
 #include <lib/logger.h>
 #include <lib/presenceutils.h>
 #include <lib/contactlocalidfetchrequest.h>
@@ -39,6 +42,7 @@
 #include <lib/resourcecache.h>
 #include <lib/sparqlconnectionmanager.h>
 
+#include <QtConcurrentRun>
 #include <QtSparql>
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
@@ -80,6 +84,7 @@ public:
         , hasMemberRelationshipColumn(-1)
         , fetchAllDetails(false)
         , sorted(false)
+        , hasMemberRelationshipsFromIndex(false)
         , m_schema(schema)
     {
     }
@@ -101,6 +106,7 @@ public: // fields
 
     bool fetchAllDetails : 1;
     bool sorted : 1;
+    bool hasMemberRelationshipsFromIndex : 1;
 
 private: // fields
     QTrackerContactDetailSchema m_schema;
@@ -108,6 +114,110 @@ private: // fields
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 
+/// Collects the details of one contact while they are decoded from the query results.
+/// Duplicates are dropped and detail links get resolved before any detail reaches the
+/// contact, so that each detail is stored exactly once via QContact::saveDetail().
+class QTrackerAbstractContactFetchRequest::DetailAssembler
+{
+public:
+    /// With @p linkOnlineAvatars being @c false online and social avatars are kept out of
+    /// link resolution, since QContactTrackerEngine::updateAvatar() replaces them by plain
+    /// avatars built from the links they were fetched with.
+    explicit DetailAssembler(bool linkOnlineAvatars = true)
+        : m_linkOnlineAvatars(linkOnlineAvatars)
+    {
+    }
+
+    /// Adds @p detail unless an equal detail was added before. Returns @c false for duplicates.
+    bool addDetail(QContactDetail detail)
+    {
+        if (m_knownDetails.contains(detail)) {
+            return false;
+        }
+
+        m_knownDetails.insert(detail);
+
+        const int index = m_details.count();
+        const QString detailUri = detail.detailUri();
+
+        if (not detailUri.isEmpty() && (m_linkOnlineAvatars || not isOnlineAvatar(detail))) {
+            // link back to the details which referred to this one before it got decoded
+            QStringList linkedDetailUris = detail.linkedDetailUris();
+            bool linksChanged = false;
+
+            foreach(int source, m_pendingLinks.values(detailUri)) {
+                const QString &sourceUri = m_details.at(source).detailUri();
+
+                if (not linkedDetailUris.contains(sourceUri)) {
+                    linkedDetailUris.append(sourceUri);
+                    linksChanged = true;
+                }
+            }
+
+            if (linksChanged) {
+                detail.setLinkedDetailUris(linkedDetailUris);
+            }
+
+            m_pendingLinks.remove(detailUri);
+
+            // link the already known details this detail refers to back to it
+            foreach(const QString &targetUri, detail.linkedDetailUris()) {
+                if (targetUri == detailUri) {
+                    continue;
+                }
+
+                const QHash<QString, int>::ConstIterator target = m_detailIndices.find(targetUri);
+
+                if (target == m_detailIndices.constEnd()) {
+                    m_pendingLinks.insert(targetUri, index);
+                    continue;
+                }
+
+                QContactDetail &targetDetail = m_details[target.value()];
+                QStringList targetLinks = targetDetail.linkedDetailUris();
+
+                if (not targetLinks.contains(detailUri)) {
+                    targetLinks.append(detailUri);
+                    targetDetail.setLinkedDetailUris(targetLinks);
+                }
+            }
+
+            m_detailIndices.insert(detailUri, index);
+        }
+
+        m_details.append(detail);
+
+        return true;
+    }
+
+    /// Stores the assembled details on @p contact.
+    void saveDetails(QContact &contact)
+    {
+        for(QList<QContactDetail>::Iterator detail = m_details.begin(); detail != m_details.end(); ++detail) {
+            if (not contact.saveDetail(&(*detail))) {
+                qctWarn(QString::fromLatin1("Could not save detail %1 on contact %2").
+                        arg(detail->definitionName(), QString::number(contact.localId())));
+            }
+        }
+    }
+
+private: // methods
+    static bool isOnlineAvatar(const QContactDetail &detail)
+    {
+        return (detail.definitionName() == QContactOnlineAvatar::DefinitionName ||
+                detail.definitionName() == QContactSocialAvatar::DefinitionName);
+    }
+
+private: // fields
+    bool m_linkOnlineAvatars;
+    QList<QContactDetail> m_details;
+    QSet<QContactDetail> m_knownDetails;
+    QHash<QString, int> m_detailIndices;
+    QMultiHash<QString, int> m_pendingLinks;
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
 QTrackerAbstractContactFetchRequest::QTrackerAbstractContactFetchRequest(QContactAbstractRequest *request,
                                                                          const QContactFilter &filter,
                                                                          const QContactFetchHint &fetchHint,
@@ -120,6 +230,7 @@ QTrackerAbstractContactFetchRequest::QTrackerAbstractContactFetchRequest(QContac
                                               QctRequestExtensions::get(request)->nameOrder()))
     , m_nameOrder(QctRequestExtensions::get(request)->nameOrder())
     , m_sorting(sorting)
+    , m_membershipIndex(0)
 {
 }
 
@@ -419,14 +530,22 @@ QTrackerAbstractContactFetchRequest::buildQuery(QueryContext &context) const
     // Build relationships query if asked to (only HasMember supported)
     if (not m_fetchHint.optimizationHints().testFlag(QContactFetchHint::NoRelationships)) {
         if (checkRelationshipTypesHint(m_fetchHint.relationshipTypesHint())) {
-            context.hasMemberRelationshipColumn = context.query.projections().count();
+            if (0 != m_membershipIndex) {
+                if (engine()->hasDebugFlag(QContactTrackerEngine::ShowNotes)) {
+                    qDebug() << "looking up HasMember relationships in the membership index";
+                }
 
-            if (engine()->hasDebugFlag(QContactTrackerEngine::ShowNotes)) {
-                qDebug() << "fetching HasMember relationships";
-            }
+                context.hasMemberRelationshipsFromIndex = true;
+            } else {
+                context.hasMemberRelationshipColumn = context.query.projections().count();
+
+                if (engine()->hasDebugFlag(QContactTrackerEngine::ShowNotes)) {
+                    qDebug() << "fetching HasMember relationships";
+                }
 
-            QTrackerScalarContactQueryBuilder queryBuilder(context.schema(), engine()->managerUri());
-            queryBuilder.bindHasMemberRelationships(context.query);
+                QTrackerScalarContactQueryBuilder queryBuilder(context.schema(), engine()->managerUri());
+                queryBuilder.bindHasMemberRelationships(context.query);
+            }
         }
     }
 
@@ -763,10 +882,9 @@ QTrackerAbstractContactFetchRequest::fetchCustomValues(const QTrackerContactDeta
     }
 }
 
-bool
-QTrackerAbstractContactFetchRequest::saveDetail(ContactCache::iterator contact,
-                                                QContactDetail &detail,
-                                                const QTrackerContactDetail &definition)
+void
+QTrackerAbstractContactFetchRequest::updateDetailUri(QContactDetail &detail,
+                                                     const QTrackerContactDetail &definition) const
 {
     if (not detail.detailUri().isEmpty()) {
         QString detailUri;
@@ -792,8 +910,6 @@ QTrackerAbstractContactFetchRequest::saveDetail(ContactCache::iterator contact,
             detail.setDetailUri(detailUri);
         }
     }
-
-    return contact->saveDetail(&detail);
 }
 
 static void
@@ -1117,9 +1233,17 @@ QTrackerAbstractContactFetchRequest::fetchResults(ContactCache &results, QueryCo
 
     const int limit = m_fetchHint.maxCountHint();
 
+    // Contacts can span multiple rows, therefore their details only get stored
+    // once all rows have been decoded.
+    QHash<QContactLocalId, DetailAssembler> assemblers;
+
+    // Avatars are computed from the online avatars as fetched, see QctContactPostProcessor.
+    const QStringList &detailHint = m_fetchHint.detailDefinitionsHint();
+    const bool linkOnlineAvatars = not (detailHint.isEmpty() ||
+                                        detailHint.contains(QContactAvatar::DefinitionName));
+
     for(bool hasRow = result->first(); not isCanceled() && hasRow; hasRow = result->next()) {
         // identify the contact
-        const QString contactIri = result->stringValue(0);
         const QContactLocalId localId = result->value(1).toUInt();
         const QString affiliation = result->stringValue(2);
         const QString affiliationContext = qctCamelCase(result->stringValue(3));
@@ -1148,6 +1272,12 @@ QTrackerAbstractContactFetchRequest::fetchResults(ContactCache &results, QueryCo
             queryContext.contactIds.append(localId);
         }
 
+        QHash<QContactLocalId, DetailAssembler>::Iterator assembler = assemblers.find(localId);
+
+        if (assembler == assemblers.end()) {
+            assembler = assemblers.insert(localId, DetailAssembler(linkOnlineAvatars));
+        }
+
         // read details
         for(QList<DetailContext>::ConstIterator detailContext = queryContext.details.constBegin();
             detailContext != queryContext.details.constEnd();
@@ -1171,16 +1301,22 @@ QTrackerAbstractContactFetchRequest::fetchResults(ContactCache &results, QueryCo
                     detail.setContexts(affiliationContext);
                 }
 
-                if (not saveDetail(contact, detail, detailContext->definition())) {
-                    qctWarn(QString::fromLatin1("Could not save detail %1 on contact %2").
-                            arg (detail.definitionName(), contactIri));
-                }
+                updateDetailUri(detail, detailContext->definition());
+                assembler->addDetail(detail);
             }
         }
 
-        fetchCustomDetails(queryContext, contact);
+        fetchCustomDetails(queryContext, contact->type(), *assembler);
 
-        fetchHasMemberRelationships(queryContext, contact);
+        if (queryContext.hasMemberRelationshipsFromIndex) {
+            lookupHasMemberRelationships(queryContext, contact);
+        } else {
+            fetchHasMemberRelationships(queryContext, contact);
+        }
+    }
+
+    for(QHash<QContactLocalId, DetailAssembler>::Iterator it = assemblers.begin(); it != assemblers.end(); ++it) {
+        it->saveDetails(results[it.key()]);
     }
 }
 
@@ -1213,8 +1349,8 @@ QTrackerAbstractContactFetchRequest::fetchCustomDetail(const QString &rawValue,
     foreach(const QString &fieldName, detailValues.uniqueKeys()) {
         QMap<uint, QString> orderedValues;
 
-        // Values are retrieved as "tracker-id:value" pairs.
-        // Order values by tracker-id and extract the value.
+        // Values are retrieved as "tracker-id:value" pairs, or as "position:value" pairs
+        // for details stored in compact form. Order values by that key and extract the value.
         foreach(const QString &s, detailValues.values(fieldName)) {
             const int i = s.indexOf(QLatin1Char(':'));
             orderedValues.insert(s.left(i).toUInt(), s.mid(i + 1));
@@ -1245,7 +1381,8 @@ QTrackerAbstractContactFetchRequest::fetchCustomDetail(const QString &rawValue,
 
 void
 QTrackerAbstractContactFetchRequest::fetchCustomDetails(const QueryContext &queryContext,
-                                                        ContactCache::Iterator contact)
+                                                        const QString &contactType,
+                                                        DetailAssembler &assembler)
 {
     if (queryContext.customDetailColumn < 0 ||
         queryContext.customDetailColumn >= queryContext.query.projections().count()) {
@@ -1255,10 +1392,10 @@ QTrackerAbstractContactFetchRequest::fetchCustomDetails(const QueryContext &quer
     const QString rawValue = queryContext.result->stringValue(queryContext.customDetailColumn);
 
     foreach(const QString &rawDetailValue, rawValue.split(QTrackerScalarContactQueryBuilder::detailSeparator())) {
-        QContactDetail detail = fetchCustomDetail(rawDetailValue, contact->type());
+        const QContactDetail detail = fetchCustomDetail(rawDetailValue, contactType);
 
         if (not areContactDetailDataValuesEmpty(detail)) {
-            contact->saveDetail(&detail);
+            assembler.addDetail(detail);
         }
     }
 }
@@ -1329,53 +1466,116 @@ QTrackerAbstractContactFetchRequest::fetchHasMemberRelationships(const QueryCont
     QContactManagerEngine::setContactRelationships(&contact.value(), hasMemberRelationships);
 }
 
-static void
-updateDetailLinks(QContact &contact)
+void
+QTrackerAbstractContactFetchRequest::lookupHasMemberRelationships(const QueryContext &queryContext,
+                                                                  ContactCache::Iterator contact)
 {
-    typedef QHash<QString, QContactDetail> DetailHash;
+    QList<QContactRelationship> hasMemberRelationships;
 
-    DetailHash detailHash;
+    QContactRelationship relationship;
+    relationship.setRelationshipType(QContactRelationship::HasMember);
 
-    foreach(const QContactDetail &detail, contact.details()) {
-        if (not detail.detailUri().isEmpty()) {
-            detailHash.insert(detail.detailUri(), detail);
-        }
-    }
+    QContactId contactId;
+    contactId.setManagerUri(engine()->managerUri());
+    contactId.setLocalId(contact->localId());
 
-    for(DetailHash::ConstIterator detail = detailHash.constBegin(); detail != detailHash.constEnd(); ++detail) {
-        foreach(const QString &detailUri, detail->linkedDetailUris()) {
-            DetailHash::Iterator target = detailHash.find(detailUri);
+    QContactId otherContactId;
+    otherContactId.setManagerUri(engine()->managerUri());
 
-            if (target == detailHash.constEnd()) {
-                continue;
-            }
+    // HasMember with contact in Second role, valid for both group and normal contacts
+    relationship.setSecond(contactId);
 
-            QStringList linkedDetailUris = target->linkedDetailUris();
+    foreach(QContactLocalId groupId, m_membershipIndex->groups(contactId.localId())) {
+        otherContactId.setLocalId(groupId);
+        relationship.setFirst(otherContactId);
+        hasMemberRelationships << relationship;
+    }
 
-            if (linkedDetailUris.contains(detail->detailUri())) {
-                continue;
-            }
+    if (queryContext.contactType() == QContactType::TypeGroup) {
+        // HasMember with contact in First role, only applyable for group contacts
+        relationship.setFirst(contactId);
 
-            linkedDetailUris.append(detail->detailUri());
-            target->setLinkedDetailUris(linkedDetailUris);
-            contact.saveDetail(&target.value());
+        foreach(QContactLocalId memberId, m_membershipIndex->members(contactId.localId())) {
+            otherContactId.setLocalId(memberId);
+            relationship.setSecond(otherContactId);
+            hasMemberRelationships << relationship;
         }
     }
+
+    QContactManagerEngine::setContactRelationships(&contact.value(), hasMemberRelationships);
 }
 
-static void
-removeDuplicateDetails(QContact &contact)
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+class QctContactPostProcessor
 {
-    QSet<QContactDetail> knownDetails;
+public:
+    // Chunks smaller than this are not worth the cost of dispatching them to another thread
+    static const int MinimumChunkSize = 64;
+
+    QctContactPostProcessor(QContactTrackerEngine *engine,
+                            const QContactFetchHint &fetchHint,
+                            const QString &nameOrder)
+        : m_engine(engine)
+        , m_displayLabelGenerators(engine->displayLabelGenerators(nameOrder))
+    {
+        const QStringList &detailHint = fetchHint.detailDefinitionsHint();
 
-    foreach(QContactDetail detail, contact.details()) {
-        if(knownDetails.contains(detail)) {
-            contact.removeDetail(&detail);
-        } else {
-            knownDetails.insert(detail);
+        m_calculateGlobalPresence = (detailHint.contains(QContactGlobalPresence::DefinitionName) || detailHint.isEmpty());
+        m_calculateDisplayLabel = (detailHint.contains(QContactDisplayLabel::DefinitionName) || detailHint.isEmpty());
+        m_calculateAvatar = (detailHint.contains(QContactAvatar::DefinitionName) || detailHint.isEmpty());
+    }
+
+    /// Updates synthetic details of @p contacts, spreading the work
+    /// over @p threadCount threads. The calling thread processes the first chunk itself.
+    void run(const QList<QContact *> &contacts, int threadCount) const
+    {
+        const int chunkSize = qMax<int>(MinimumChunkSize, (contacts.count() + threadCount - 1) / qMax(1, threadCount));
+        QList< QFuture<void> > pendingChunks;
+
+        for(int i = chunkSize; i < contacts.count(); i += chunkSize) {
+            pendingChunks += QtConcurrent::run(this, &QctContactPostProcessor::processChunk,
+                                               contacts.mid(i, chunkSize));
+        }
+
+        processChunk(contacts.mid(0, chunkSize));
+
+        foreach(QFuture<void> future, pendingChunks) {
+            future.waitForFinished();
         }
     }
-}
+
+private:
+    void processChunk(const QList<QContact *> &contacts) const
+    {
+        foreach(QContact *contact, contacts) {
+            process(*contact);
+        }
+    }
+
+    // Runs all steps on one contact while its details are still hot in the cache.
+    void process(QContact &contact) const
+    {
+        if (m_calculateGlobalPresence) {
+            qctUpdateGlobalPresence(contact);
+        }
+        if (m_calculateDisplayLabel) {
+            m_engine->updateDisplayLabel(contact, m_displayLabelGenerators);
+        }
+        if (m_calculateAvatar) {
+            m_engine->updateAvatar(contact);
+        }
+    }
+
+private:
+    QContactTrackerEngine *const m_engine;
+    const QList<QctDisplayLabelGenerator> m_displayLabelGenerators;
+    bool m_calculateGlobalPresence : 1;
+    bool m_calculateDisplayLabel : 1;
+    bool m_calculateAvatar : 1;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
 
 void
 QTrackerAbstractContactFetchRequest::run()
@@ -1384,10 +1584,19 @@ QTrackerAbstractContactFetchRequest::run()
         return;
     }
 
-    const QStringList &detailHint = m_fetchHint.detailDefinitionsHint();
-    const bool calculateGlobalPresence(detailHint.contains(QContactGlobalPresence::DefinitionName) || detailHint.isEmpty());
-    const bool calculateDisplayLabel(detailHint.contains(QContactDisplayLabel::DefinitionName) || detailHint.isEmpty());
-    const bool calculateAvatar(detailHint.contains(QContactAvatar::DefinitionName) || detailHint.isEmpty());
+    m_filter = resolveNameFilters(m_filter, m_nameOrder);
+    m_filter = resolveRelationshipFilters(m_filter);
+
+    // Take relationships from the membership index instead of querying them for each contact.
+    if (not m_fetchHint.optimizationHints().testFlag(QContactFetchHint::NoRelationships)) {
+        QctMembershipIndex *const index = membershipIndex();
+
+        if (0 != index && refreshMembershipIndex(index)) {
+            m_membershipIndex = index;
+        }
+    }
+
+    const QctContactPostProcessor postProcessor(engine(), m_fetchHint, m_nameOrder);
 
     // Results are already sorted if we run a preliminary ID fetch
     bool isSortedAlready = false;
@@ -1447,24 +1656,16 @@ QTrackerAbstractContactFetchRequest::run()
 
         // Update synthetic details and detail links
         // That needs to be done before sorting
-        foreach (QContactLocalId id, context.contactIds) {
-            QContact &c = results[id];
-
-            removeDuplicateDetails(c);
-
-            if (calculateGlobalPresence) {
-                qctUpdateGlobalPresence(c);
-            }
-            if (calculateDisplayLabel) {
-                engine()->updateDisplayLabel(c, m_nameOrder);
-            }
-            if (calculateAvatar) {
-                engine()->updateAvatar(c);
-            }
+        // Collect the pointers first, the worker threads must not touch the hash itself.
+        QList<QContact *> contacts;
+        contacts.reserve(context.contactIds.count());
 
-            updateDetailLinks(c);
+        foreach (QContactLocalId id, context.contactIds) {
+            contacts += &results[id];
         }
 
+        postProcessor.run(contacts, engine()->fetchThreads());
+
         if (not isSortedAlready) {
             if (context.sorted || m_sorting.isEmpty()) {
                 m_sortedIds[context.contactType()] = context.contactIds;
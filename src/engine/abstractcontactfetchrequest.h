@@ -31,6 +31,7 @@
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+class QctMembershipIndex;
 class QTrackerContactDetailBuilder;
 class QTrackerContactDetail;
 class QTrackerContactDetailField;
@@ -46,6 +47,7 @@ class QTrackerAbstractContactFetchRequest : public QTrackerAbstractRequest
     Q_DISABLE_COPY(QTrackerAbstractContactFetchRequest)
     Q_OBJECT
 
+    class DetailAssembler;
     class DetailContext;
     class QueryContext;
 
@@ -98,9 +100,12 @@ private:
     QContactDetail fetchCustomDetail(const QString &rawValue,
                                      const QString &contactType);
     void fetchCustomDetails(const QueryContext &queryContext,
-                            ContactCache::Iterator contact);
+                            const QString &contactType,
+                            DetailAssembler &assembler);
     void fetchHasMemberRelationships(const QueryContext &queryContext,
                                      ContactCache::Iterator contact);
+    void lookupHasMemberRelationships(const QueryContext &queryContext,
+                                      ContactCache::Iterator contact);
 
     QVariant fetchInstances(const QTrackerContactDetailField &field,
                             const QString &rawValueString,
@@ -112,8 +117,8 @@ private:
                            QVariant &fieldValue,
                            const QString &rawValueString,
                            QSet<QString> &graphIris) const;
-    bool saveDetail(ContactCache::iterator contact, QContactDetail &detail,
-                    const QTrackerContactDetail &definition);
+    void updateDetailUri(QContactDetail &detail,
+                         const QTrackerContactDetail &definition) const;
 
     enum ListExtractionMode {
         KeepListAsIs, ///< Take the raw list.
@@ -132,6 +137,7 @@ private: // fields
     const QString                       m_nameOrder;
     QList<QContactSortOrder>            m_sorting;
     QHash<QString, QList<QContactLocalId> > m_sortedIds;
+    QctMembershipIndex                 *m_membershipIndex;
 };
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -28,6 +28,8 @@
 #include "abstractrequest.h"
 
 #include <engine/engine.h>
+#include <engine/membershipindex.h>
+#include <engine/nameindex.h>
 #include <lib/threadutils.h>
 
 #include <ontologies/nco.h>
@@ -115,9 +117,13 @@ QTrackerAbstractRequest::QTrackerAbstractRequest(QContactTrackerEngine *engine,
     : QObject(parent)
     , m_engine(engine)
     , m_logger(makePrefix(engine))
+    , m_nameIndex(engine ? engine->nameIndex() : 0)
+    , m_membershipIndex(engine ? engine->membershipIndex() : 0)
     , m_lastError(QContactManager::NoError)
+    , m_priority(QctRequestExtensions::NormalPriority)
     , m_canceled(false)
     , m_cancelable(true)
+    , m_started(false)
 {
     if (0 == m_engine) {
         qctFail("No engine passed to request worker");
@@ -135,6 +141,17 @@ QTrackerAbstractRequest::~QTrackerAbstractRequest()
 void
 QTrackerAbstractRequest::exec()
 {
+    {
+        QCT_SYNCHRONIZED_WRITE(&m_cancelableLock);
+
+        // Canceled while waiting in the queue, cancelUnstarted() already took care of everything.
+        if (m_started) {
+            return;
+        }
+
+        m_started = true;
+    }
+
     run();
 
     if (isCanceled()) {
@@ -157,6 +174,23 @@ QTrackerAbstractRequest::cancel()
     return m_canceled;
 }
 
+bool
+QTrackerAbstractRequest::cancelUnstarted()
+{
+    QCT_SYNCHRONIZED_WRITE(&m_cancelableLock);
+
+    // Requests can turn irreversible before they got started,
+    // e.g. when merged into some other save request.
+    if (m_started || not m_cancelable) {
+        return false;
+    }
+
+    m_canceled = true;
+    m_started = true;
+
+    return true;
+}
+
 bool
 QTrackerAbstractRequest::isCanceled() const
 {
@@ -195,11 +229,32 @@ QTrackerAbstractRequest::runQuery(const QSparqlQuery &query,
         return 0;
     }
 
+    // Don't bother tracker with queries of canceled requests. Callers handle
+    // the null result like an error, and exec() reports the canceled state.
+    if (isCanceled()) {
+        return 0;
+    }
+
     if (engine()->hasDebugFlag(queryDebugFlag(query))) {
         qDebug() << query.query();
     }
 
-    QScopedPointer<QSparqlResult> result(connection.exec(query, options));
+    // Let tracker know about the request's priority. High priority requests
+    // must not be throttled, even if the caller asked for batch processing.
+    QSparqlQueryOptions queryOptions = options;
+
+    switch(priority()) {
+    case QctRequestExtensions::LowPriority:
+        queryOptions.setPriority(QSparqlQueryOptions::LowPriority);
+        break;
+    case QctRequestExtensions::HighPriority:
+        queryOptions.setPriority(QSparqlQueryOptions::NormalPriority);
+        break;
+    case QctRequestExtensions::NormalPriority:
+        break;
+    }
+
+    QScopedPointer<QSparqlResult> result(connection.exec(query, queryOptions));
 
     if (result->hasError()) {
         reportError(result->lastError());
@@ -275,3 +330,130 @@ QTrackerAbstractRequest::reportError(const QSparqlError &error, const QString &d
     const QString message = details % QLatin1String(details.isEmpty() ? "": ": ") % error.message();
     reportError(message, translateError(error));
 }
+
+bool
+QTrackerAbstractRequest::fetchIndexedDetails(const QList<QContactLocalId> &contactIds,
+                                             const QStringList &definitionNames,
+                                             QList<QContact> &contacts)
+{
+    QContactFetchHint fetchHint;
+    fetchHint.setDetailDefinitionsHint(definitionNames);
+    fetchHint.setOptimizationHints(QContactFetchHint::NoRelationships);
+
+    QContactFetchRequest request;
+    request.setFetchHint(fetchHint);
+
+    if (not contactIds.isEmpty()) {
+        QContactLocalIdFilter filter;
+        filter.setIds(contactIds);
+        request.setFilter(filter);
+    }
+
+    QScopedPointer<QTrackerAbstractRequest>(engine()->createRequestWorker(&request))->exec();
+
+    if (request.error() != QContactManager::NoError) {
+        return false;
+    }
+
+    contacts = request.contacts();
+    return true;
+}
+
+QContactFilter
+QTrackerAbstractRequest::resolveNameFilters(const QContactFilter &filter, const QString &nameOrder)
+{
+    QctNameIndex *const index = m_nameIndex;
+
+    // The display labels in the index are built for the default name order.
+    const bool withDisplayLabels = nameOrder.isEmpty();
+
+    if (0 == index || not QctNameIndex::isResolvable(filter, withDisplayLabels)) {
+        return filter;
+    }
+
+    if (not refreshIndex(index)) {
+        // tracker still can do the filtering
+        return filter;
+    }
+
+    if (engine()->hasDebugFlag(QContactTrackerEngine::ShowNotes)) {
+        qctWarn(QString::fromLatin1("Resolving name filters of %1 using the name index").
+                arg(QLatin1String(metaObject()->className())));
+    }
+
+    return index->resolveFilter(filter, withDisplayLabels, QctSparqlResolver::ColumnLimit);
+}
+
+bool
+QTrackerAbstractRequest::fetchMemberships(const QList<QContactLocalId> &contactIds,
+                                          QctMembershipIndex::MembersByGroup &memberships)
+{
+    static const QString queryTemplate = QLatin1String
+            ("SELECT tracker:id(?g) tracker:id(?c)\n"
+             "WHERE\n"
+             "{\n"
+             "  ?c a nco:Contact ; nco:belongsToGroup ?g .\n"
+             "  ?g a nco:Contact ; a nco:ContactGroup .\n"
+             "%1"
+             "}\n");
+    static const QString filterTemplate = QLatin1String
+            ("  FILTER(tracker:id(?g) IN (%1) || tracker:id(?c) IN (%1)) .\n");
+
+    QString filterString;
+
+    if (not contactIds.isEmpty()) {
+        QStringList idStrings;
+
+        foreach(QContactLocalId id, contactIds) {
+            idStrings += QString::number(id);
+        }
+
+        filterString = filterTemplate.arg(idStrings.join(QLatin1String(", ")));
+    }
+
+    const QSparqlQuery query(queryTemplate.arg(filterString));
+    QScopedPointer<QSparqlResult> result(runQuery(query, SyncQueryOptions));
+
+    if (result.isNull()) {
+        return false; // runQuery() called reportError()
+    }
+
+    while(result->next()) {
+        const QContactLocalId groupId = result->value(0).toUInt();
+        const QContactLocalId memberId = result->value(1).toUInt();
+
+        if (0 != groupId && 0 != memberId && groupId != memberId) {
+            memberships.insert(groupId, memberId);
+        }
+    }
+
+    return true;
+}
+
+bool
+QTrackerAbstractRequest::refreshMembershipIndex(QctMembershipIndex *index)
+{
+    return refreshIndex(index, &QTrackerAbstractRequest::fetchMemberships);
+}
+
+QContactFilter
+QTrackerAbstractRequest::resolveRelationshipFilters(const QContactFilter &filter)
+{
+    QctMembershipIndex *const index = membershipIndex();
+
+    if (0 == index || not QctMembershipIndex::isResolvable(filter, engine()->managerUri())) {
+        return filter;
+    }
+
+    if (not refreshMembershipIndex(index)) {
+        // tracker still can do the filtering
+        return filter;
+    }
+
+    if (engine()->hasDebugFlag(QContactTrackerEngine::ShowNotes)) {
+        qctWarn(QString::fromLatin1("Resolving relationship filters of %1 using the membership index").
+                arg(QLatin1String(metaObject()->className())));
+    }
+
+    return index->resolveFilter(filter, engine()->managerUri(), QctSparqlResolver::ColumnLimit);
+}
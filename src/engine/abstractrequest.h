@@ -31,7 +31,9 @@
 #include <lib/logger.h>
 #undef QTC_NO_GLOBAL_LOGGER
 
+#include <lib/requestextensions.h>
 #include <lib/sparqlconnectionmanager.h>
+#include <lib/sparqlresolver.h>
 #include <QtSparql>
 #include <QReadWriteLock>
 
@@ -40,6 +42,8 @@ QTM_USE_NAMESPACE
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 class QContactTrackerEngine;
+class QctMembershipIndex;
+class QctNameIndex;
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
@@ -76,6 +80,12 @@ public: // attributes
     const QContactTrackerEngine * engine() const { return m_engine; }
     QContactTrackerEngine * engine() { return m_engine; }
 
+    QctRequestExtensions::Priority priority() const { return m_priority; }
+    void setPriority(QctRequestExtensions::Priority priority) { m_priority = priority; }
+
+    /// The engine's membership index as of construction of this worker, or \c 0 if disabled.
+    QctMembershipIndex * membershipIndex() const { return m_membershipIndex; }
+
 protected: // abstract API which must be implemented
     virtual void updateRequest(QContactManager::Error error) = 0;
     virtual void run() = 0;
@@ -92,6 +102,14 @@ public: // overriddable methods
      */
     virtual bool cancel();
 
+    /**
+     * Cancels the request if exec() was not called yet, and prevents it from running later.
+     * Returns \c true if the request was canceled. The caller then is responsible for
+     * reporting the canceled state, since exec() will not do so anymore.
+     * Needs to support being called from another thread than the one of this object.
+     */
+    bool cancelUnstarted();
+
 protected: // internal attributes
     const QctLogger & qctLogger() const { return m_logger; }
 
@@ -119,20 +137,122 @@ protected: // internal methods
 
     bool turnIrreversible();
 
+    /**
+     * Replaces name prefix filters within \p filter by local id filters if the
+     * engine's name index is enabled. Returns \p filter if the index cannot help.
+     */
+    QContactFilter resolveNameFilters(const QContactFilter &filter, const QString &nameOrder);
+
+    /**
+     * Fetches the details listed in \p definitionNames of the contacts in \p contactIds,
+     * or of all contacts if \p contactIds is empty. Used for populating in-memory indexes.
+     */
+    bool fetchIndexedDetails(const QList<QContactLocalId> &contactIds,
+                             const QStringList &definitionNames,
+                             QList<QContact> &contacts);
+
+    /**
+     * Fetches the details indexed by \p Index, see fetchIndexedDetails().
+     */
+    template<class Index>
+    bool fetchIndexedContacts(const QList<QContactLocalId> &contactIds, QList<QContact> &contacts)
+    {
+        return fetchIndexedDetails(contactIds, Index::detailDefinitionNames(), contacts);
+    }
+
+    /**
+     * Brings \p index up to date, by populating it or by refreshing its stale contacts.
+     * The index data is retrieved by calling \p fetch, with an empty contact list for
+     * populating the index, and in chunks of the stale contacts otherwise.
+     */
+    template<class Index, class Request>
+    bool refreshIndex(Index *index, bool (Request::*fetch)(const QList<QContactLocalId> &,
+                                                          typename Index::Data &));
+
+    /**
+     * Brings the detail based \p index up to date, see fetchIndexedContacts().
+     */
+    template<class Index>
+    bool refreshIndex(Index *index)
+    {
+        return refreshIndex(index, &QTrackerAbstractRequest::fetchIndexedContacts<Index>);
+    }
+
+    /**
+     * Replaces HasMember relationship filters within \p filter by local id filters if the
+     * engine's membership index is enabled. Returns \p filter if the index cannot help.
+     */
+    QContactFilter resolveRelationshipFilters(const QContactFilter &filter);
+
+    /**
+     * Brings the membership \p index up to date, see refreshIndex().
+     */
+    bool refreshMembershipIndex(QctMembershipIndex *index);
+
     static QContactManager::Error translateError(const QSparqlError &error);
 
+private: // methods
+    bool fetchMemberships(const QList<QContactLocalId> &contactIds,
+                          QMultiHash<QContactLocalId, QContactLocalId> &memberships);
+
 private: // fields
     QContactTrackerEngine *const m_engine;
     QctLogger m_logger;
 
+    QctNameIndex *const m_nameIndex;
+    QctMembershipIndex *const m_membershipIndex;
+
     QReadWriteLock m_cancelableLock;
 
     QContactManager::Error m_lastError;
+    QctRequestExtensions::Priority m_priority;
 
     bool m_canceled : 1;
     bool m_cancelable : 1;
+    bool m_started : 1;
 };
 
 Q_DECLARE_OPERATORS_FOR_FLAGS(QTrackerAbstractRequest::Dependencies)
 
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template<class Index, class Request> inline bool
+QTrackerAbstractRequest::refreshIndex(Index *index, bool (Request::*fetch)(const QList<QContactLocalId> &,
+                                                                          typename Index::Data &))
+{
+    Request *const request = static_cast<Request *>(this);
+
+    // Take the stale contacts before running any query, so that changes reported
+    // while we are waiting for results are picked up by the next lookup.
+    QList<QContactLocalId> staleContactIds = index->takeStaleContacts();
+
+    if (not index->isPopulated()) {
+        typename Index::Data data;
+
+        if (not (request->*fetch)(QList<QContactLocalId>(), data)) {
+            return false;
+        }
+
+        index->populate(data);
+        return true;
+    }
+
+    while(not staleContactIds.isEmpty()) {
+        // split the local id list to avoid "Too many SQL variables" warning
+        const QList<QContactLocalId> nextContactIds = staleContactIds.mid(0, QctSparqlResolver::ColumnLimit);
+        typename Index::Data data;
+
+        if (not (request->*fetch)(nextContactIds, data)) {
+            // try again on next lookup
+            index->markStale(staleContactIds);
+            return false;
+        }
+
+        index->update(nextContactIds, data);
+        staleContactIds = staleContactIds.mid(nextContactIds.count());
+    }
+
+    return true;
+}
+
 #endif /* QTRACKERABSTRACTREQUEST_H_ */
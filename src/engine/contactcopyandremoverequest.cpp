@@ -27,6 +27,8 @@
 #include <dao/scalarquerybuilder.h>
 #include <dao/support.h>
 #include <engine/engine.h>
+#include <engine/membershipindex.h>
+#include <engine/tombstones.h>
 #include <lib/constants.h>
 #include <lib/contactmergerequest.h>
 #include <lib/customdetails.h>
@@ -98,40 +100,60 @@ QTrackerContactCopyAndRemoveRequest::resolveContactIds()
     return true;
 }
 
-bool
-QTrackerContactCopyAndRemoveRequest::fetchContactDetails()
+QString
+QTrackerContactCopyAndRemoveRequest::buildFetchQuery(const QList<QContactLocalId> &contactIds) const
 {
-    enum {SyncTargetColumn = 0, GraphedPropertiesColumn, UngraphedPropertiesColumn};
-    enum {PropertyField = 0, CardinalityField, NFields};
-
     static const QString queryTemplate = QLatin1String
             ("SELECT\n"
-             "  nie:generator(<%1>)\n"
+             "  tracker:id(?contact)\n"
+             "  nie:generator(?contact)\n"
              "  (SELECT\n"
              "        GROUP_CONCAT(fn:concat(?p, \"%2\", tracker:coalesce(nrl:maxCardinality(?p),\"\")), \"%3\")\n"
              "   WHERE\n"
              "   {\n"
              "        GRAPH ?g\n"
              "        {\n"
-             "                <%1> ?p ?o FILTER(?p NOT IN(dc:date,nie:informationElementDate,nie:generator,nco:contactLocalUID))\n"
+             "                ?contact ?p ?o FILTER(?p NOT IN(dc:date,nie:informationElementDate,nie:generator,nco:contactLocalUID))\n"
              "        }\n"
              "   })\n"
              "  (SELECT\n"
              "        GROUP_CONCAT(fn:concat(?p, \"%2\", tracker:coalesce(nrl:maxCardinality(?p),\"\")), \"%3\")\n"
              "   WHERE\n"
              "   {\n"
-             "        <%1> ?p ?o FILTER(?p NOT IN(dc:date,nie:informationElementDate,nie:generator,nco:contactLocalUID))\n"
+             "        ?contact ?p ?o FILTER(?p NOT IN(dc:date,nie:informationElementDate,nie:generator,nco:contactLocalUID))\n"
              "   })\n"
-             "{}\n");
+             "WHERE\n"
+             "{\n"
+             "  ?contact a nco:Contact\n"
+             "  FILTER(tracker:id(?contact) IN (%1))\n"
+             "}\n");
+
+    QStringList idStrings;
 
-    QMap<QString, bool> singleWithGraph;
+    foreach(QContactLocalId id, contactIds) {
+        idStrings.append(QString::number(id));
+    }
 
-    foreach(const QString &contactIri, m_contactIris) {
-        const QString queryString = queryTemplate.arg(contactIri,
-                                                      QTrackerScalarContactQueryBuilder::fieldSeparator(),
-                                                      QTrackerScalarContactQueryBuilder::listSeparator());
-        const QSparqlQuery query(queryString, QSparqlQuery::SelectStatement);
+    return queryTemplate.arg(idStrings.join(QLatin1String(", ")),
+                             QTrackerScalarContactQueryBuilder::fieldSeparator(),
+                             QTrackerScalarContactQueryBuilder::listSeparator());
+}
+
+bool
+QTrackerContactCopyAndRemoveRequest::fetchContactDetails()
+{
+    enum {IdColumn = 0, SyncTargetColumn, GraphedPropertiesColumn, UngraphedPropertiesColumn};
+    enum {PropertyField = 0, CardinalityField, NFields};
 
+    // Fetch the predicates of all involved contacts at once, instead of running
+    // one query per contact. The id list is split to avoid "Too many SQL variables".
+    QList<QContactLocalId> pendingIds = m_contactIris.keys();
+
+    while(not pendingIds.isEmpty()) {
+        const QList<QContactLocalId> nextIds = pendingIds.mid(0, QctSparqlResolver::ColumnLimit);
+        pendingIds = pendingIds.mid(nextIds.count());
+
+        const QSparqlQuery query(buildFetchQuery(nextIds), QSparqlQuery::SelectStatement);
         QScopedPointer<QSparqlResult> result(runQuery(query, SyncQueryOptions));
 
         if (result.isNull()) {
@@ -139,13 +161,23 @@ QTrackerContactCopyAndRemoveRequest::fetchContactDetails()
         }
 
         // parse result
-        QString syncTarget;
-
         while (result->next()) {
-            QStringList graphedProperties = result->stringValue(GraphedPropertiesColumn).split(QTrackerScalarContactQueryBuilder::listSeparator());
+            const QString contactIri = m_contactIris.value(result->value(IdColumn).toUInt());
+
+            if (contactIri.isEmpty()) {
+                qctWarn(QString::fromLatin1("Unexpected contact id: %1").
+                        arg(result->stringValue(IdColumn)));
+                continue;
+            }
 
-            foreach (const QString property, graphedProperties) {
-                QStringList values = property.split(QTrackerScalarContactQueryBuilder::fieldSeparator());
+            QSet<QString> singleWithGraph;
+
+            const QStringList graphedProperties =
+                    result->stringValue(GraphedPropertiesColumn).
+                    split(QTrackerScalarContactQueryBuilder::listSeparator(), QString::SkipEmptyParts);
+
+            foreach (const QString &property, graphedProperties) {
+                const QStringList values = property.split(QTrackerScalarContactQueryBuilder::fieldSeparator());
 
                 if (values.size() != NFields) {
                     qctWarn(QString::fromLatin1("Invalid field data: %1").arg(property));
@@ -155,15 +187,17 @@ QTrackerContactCopyAndRemoveRequest::fetchContactDetails()
                 if (values.at(CardinalityField).toInt() != 1) {
                     m_contactPredicatesMultiWithGraph.insertMulti(contactIri, values.at(PropertyField));
                 } else {
-                    singleWithGraph.insert(values.at(PropertyField), true);
+                    singleWithGraph.insert(values.at(PropertyField));
                     m_contactPredicatesSingleWithGraph.insertMulti(contactIri, values.at(PropertyField));
                 }
             }
 
-            QStringList ungraphedProperties = result->stringValue(UngraphedPropertiesColumn).split(QTrackerScalarContactQueryBuilder::listSeparator());
+            const QStringList ungraphedProperties =
+                    result->stringValue(UngraphedPropertiesColumn).
+                    split(QTrackerScalarContactQueryBuilder::listSeparator(), QString::SkipEmptyParts);
 
-            foreach (const QString property, ungraphedProperties) {
-                QStringList values = property.split(QTrackerScalarContactQueryBuilder::fieldSeparator());
+            foreach (const QString &property, ungraphedProperties) {
+                const QStringList values = property.split(QTrackerScalarContactQueryBuilder::fieldSeparator());
 
                 if (values.size() != NFields) {
                     qctWarn(QString::fromLatin1("Invalid field data: %1").arg(property));
@@ -175,12 +209,10 @@ QTrackerContactCopyAndRemoveRequest::fetchContactDetails()
                 } else if (not singleWithGraph.contains(values.at(PropertyField))) {
                     m_contactPredicatesSingle.insertMulti(contactIri, values.at(PropertyField));
                 }
-
-                if (syncTarget.isNull()) {
-                    syncTarget = result->stringValue(SyncTargetColumn);
-                }
             }
 
+            const QString syncTarget = result->stringValue(SyncTargetColumn);
+
             if (not syncTarget.isEmpty()) {
                 m_contactSyncTargets.insert(contactIri, syncTarget);
             }
@@ -195,6 +227,17 @@ QTrackerContactCopyAndRemoveRequest::doMerge()
 {
     QString queryString;
 
+    // Merged contacts are removed, so delta sync clients must learn about them.
+    if (engine()->tombstoneRetention() > 0) {
+        const QList<QContactLocalId> sourceIds = m_mergeIds.values();
+
+        queryString += QctTombstones::buildPruneQuery(engine()->tombstoneRetention());
+
+        for(int i = 0; i < sourceIds.count(); i += QctSparqlResolver::ColumnLimit) {
+            queryString += QctTombstones::buildRecordQuery(sourceIds.mid(i, QctSparqlResolver::ColumnLimit));
+        }
+    }
+
     foreach(QContactLocalId id, m_mergeIds.uniqueKeys()) {
         queryString += buildMergeQuery(id);
 
@@ -203,8 +246,24 @@ QTrackerContactCopyAndRemoveRequest::doMerge()
         }
     }
 
+    reportTiming("building merge queries");
+
     const QSparqlQuery query(queryString, QSparqlQuery::InsertStatement);
-    return not QScopedPointer<QSparqlResult>(runQuery(query, SyncQueryOptions)).isNull();
+    const bool success = not QScopedPointer<QSparqlResult>(runQuery(query, SyncQueryOptions)).isNull();
+
+    reportTiming("running merge queries");
+
+    return success;
+}
+
+void
+QTrackerContactCopyAndRemoveRequest::reportTiming(const char *phase)
+{
+    if (engine()->hasDebugFlag(QContactTrackerEngine::ShowTiming)) {
+        qDebug()
+                << metaObject()->className() << m_stopWatch.elapsed()
+                << ":" << phase << "took" << m_stopWatch.restart() << "ms";
+    }
 }
 
 QString
@@ -467,12 +526,37 @@ QTrackerContactCopyAndRemoveRequest::mergeContacts(const QString &targetUrn,
 void
 QTrackerContactCopyAndRemoveRequest::run()
 {
-    if (not turnIrreversible()
-            || not verifyRequest()
-            || not resolveContactIds()
-            || not fetchContactDetails()
-            || not doMerge()) {
-        return; // request failed (http://en.wikipedia.org/wiki/Lazy_evaluation)
+    if (not turnIrreversible() || not verifyRequest()) {
+        return;
+    }
+
+    m_stopWatch.start();
+
+    if (not resolveContactIds()) {
+        return;
+    }
+
+    reportTiming("resolving contact ids");
+
+    if (not fetchContactDetails()) {
+        return;
+    }
+
+    reportTiming("fetching contact predicates");
+
+    if (not doMerge()) {
+        return;
+    }
+
+    // don't wait for the change listener, the next lookup must see the merged contacts
+    const QList<QContactLocalId> targetIds = m_mergeIds.uniqueKeys();
+    QctMembershipIndex *const index = membershipIndex();
+
+    engine()->removeIndexedContacts(m_mergeIds.values());
+    engine()->markIndexedContactsStale(targetIds);
+
+    if (0 != index) {
+        index->markStale(targetIds);
     }
 }
 
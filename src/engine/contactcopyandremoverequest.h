@@ -27,6 +27,8 @@
 
 #include "contactremoverequest.h"
 
+#include <QElapsedTimer>
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 class QctContactMergeRequest;
@@ -58,9 +60,12 @@ private: // methods
 
     QString pickPreferredSyncTarget(const QSet<QString> &syncTargets,
                                     const QString &destinationSyncTarget);
+    QString buildFetchQuery(const QList<QContactLocalId> &contactIds) const;
     QString buildMergeQuery(QContactLocalId id);
     QString mergeContacts(const QString &targetUrn, const QString &sourceUrn);
 
+    void reportTiming(const char *phase);
+
 private: // fields
     const MergeIdMap m_mergeIds;
 
@@ -71,6 +76,7 @@ private: // fields
     QMultiHash<QString, QString> m_contactPredicatesMulti;
     QMultiHash<QString, QString> m_contactPredicatesMultiWithGraph;
     QHash<QString, QString> m_contactSyncTargets;
+    QElapsedTimer m_stopWatch;
 };
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
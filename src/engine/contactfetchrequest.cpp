@@ -27,7 +27,68 @@
 #include "engine.h"
 
 #include <lib/requestextensions.h>
+#include <lib/threadutils.h>
 
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+static bool
+isEqualFetchHint(const QContactFetchHint &a, const QContactFetchHint &b)
+{
+    return (a.optimizationHints() == b.optimizationHints() &&
+            a.maxCountHint() == b.maxCountHint() &&
+            a.preferredImageSize() == b.preferredImageSize() &&
+            a.detailDefinitionsHint() == b.detailDefinitionsHint() &&
+            a.relationshipTypesHint() == b.relationshipTypesHint());
+}
+
+QctSharedFetchResult::QctSharedFetchResult(const QContactFetchRequest *request,
+                                           const QString &nameOrder)
+    : m_filter(request->filter())
+    , m_sorting(request->sorting())
+    , m_fetchHint(request->fetchHint())
+    , m_nameOrder(nameOrder)
+    , m_published(false)
+{
+}
+
+bool
+QctSharedFetchResult::matches(const QContactFetchRequest *request, const QString &nameOrder) const
+{
+    return (m_nameOrder == nameOrder &&
+            m_sorting == request->sorting() &&
+            isEqualFetchHint(m_fetchHint, request->fetchHint()) &&
+            m_filter == request->filter());
+}
+
+bool
+QctSharedFetchResult::isPublished() const
+{
+    QCT_SYNCHRONIZED_READ(&m_lock);
+    return m_published;
+}
+
+void
+QctSharedFetchResult::publish(const QList<QContact> &contacts)
+{
+    QCT_SYNCHRONIZED_WRITE(&m_lock);
+
+    if (not m_published) {
+        m_contacts = contacts;
+        m_published = true;
+    }
+}
+
+bool
+QctSharedFetchResult::fetch(QList<QContact> &contacts) const
+{
+    QCT_SYNCHRONIZED_READ(&m_lock);
+
+    if (m_published) {
+        contacts = m_contacts;
+    }
+
+    return m_published;
+}
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 
@@ -41,6 +102,7 @@ QTrackerContactFetchRequest::QTrackerContactFetchRequest(QContactAbstractRequest
                                                             engine,
                                                             parent)
     , m_nameOrder(QctRequestExtensions::get(request)->nameOrder())
+    , m_sharedResult(engine->sharedFetchResult(staticCast(request), m_nameOrder))
 {
 }
 
@@ -89,6 +151,26 @@ QTrackerContactFetchRequest::processResults(const ContactCache &results)
     }
 }
 
+void
+QTrackerContactFetchRequest::run()
+{
+    // An identical request, which was started while we were waiting in the queue,
+    // might already have fetched our contacts.
+    if (m_sharedResult->fetch(m_contacts)) {
+        if (engine()->hasDebugFlag(QContactTrackerEngine::ShowNotes)) {
+            qDebug() << metaObject()->className() << ": reusing results of identical request";
+        }
+
+        return;
+    }
+
+    QTrackerBaseContactFetchRequest<QContactFetchRequest>::run();
+
+    if (not isCanceled() && lastError() == QContactManager::NoError) {
+        m_sharedResult->publish(m_contacts);
+    }
+}
+
 void
 QTrackerContactFetchRequest::updateRequest(QContactManager::Error error)
 {
@@ -29,6 +29,34 @@
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+/// Result of a contact fetch, shared by all identical fetch requests which are in-flight at
+/// the same time. The first of them to finish publishes its contacts, all others reuse them
+/// instead of querying tracker again.
+class QctSharedFetchResult
+{
+    Q_DISABLE_COPY(QctSharedFetchResult)
+
+public:
+    QctSharedFetchResult(const QContactFetchRequest *request, const QString &nameOrder);
+
+    bool matches(const QContactFetchRequest *request, const QString &nameOrder) const;
+
+    bool isPublished() const;
+    void publish(const QList<QContact> &contacts);
+    bool fetch(QList<QContact> &contacts) const;
+
+private: // fields
+    const QContactFilter m_filter;
+    const QList<QContactSortOrder> m_sorting;
+    const QContactFetchHint m_fetchHint;
+    const QString m_nameOrder;
+
+    mutable QReadWriteLock m_lock;
+    QList<QContact> m_contacts;
+    bool m_published;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
 
 class QTrackerContactFetchRequest : public QTrackerBaseContactFetchRequest<QContactFetchRequest>
 {
@@ -45,6 +73,7 @@ protected: // QTrackerAbstractContactFetchRequest API
     void processResults(const ContactCache &results);
 
 protected: // QTrackerAbstractRequest API
+    void run();
     void updateRequest(QContactManager::Error error);
 
 private:
@@ -52,6 +81,7 @@ private:
 
 private: // fields
     const QString   m_nameOrder;
+    const QSharedPointer<QctSharedFetchResult> m_sharedResult;
 
     QList<QContact> m_contacts;
 };
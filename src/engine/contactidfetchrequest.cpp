@@ -28,6 +28,7 @@
 #include "dao/scalarquerybuilder.h"
 #include "engine/abstractcontactfetchrequest.h"
 #include "engine/engine.h"
+#include "engine/tombstones.h"
 #include "lib/contactlocalidfetchrequest.h"
 #include "lib/sparqlconnectionmanager.h"
 
@@ -197,6 +198,16 @@ QTrackerContactIdFetchRequest::run()
         return;
     }
 
+    // Removed contacts only exist as tombstones, which the query builder knows nothing about.
+    if (m_filter.type() == QContactFilter::ChangeLogFilter && engine()->tombstoneRetention() > 0 &&
+        QContactChangeLogFilter(m_filter).eventType() == QContactChangeLogFilter::EventRemoved) {
+        runTombstones();
+        return;
+    }
+
+    m_filter = resolveNameFilters(m_filter, QString());
+    m_filter = resolveRelationshipFilters(m_filter);
+
     QContactManager::Error error = QContactManager::UnspecifiedError;
     // canSort tells if native sorting can be achieved
     bool sorted = false;
@@ -244,6 +255,36 @@ QTrackerContactIdFetchRequest::runNative(const QString &queryString)
     }
 }
 
+void
+QTrackerContactIdFetchRequest::runTombstones()
+{
+    // Sort orders are ignored: The details they refer to are gone with the removed contacts.
+    const QContactChangeLogFilter filter(m_filter);
+    const QSparqlQuery query(QctTombstones::buildFetchQuery(filter.since()));
+    QScopedPointer<QSparqlResult> result(runQuery(query, SyncQueryOptions));
+
+    if (result.isNull()) {
+        // runQuery() called reportError()
+        return;
+    }
+
+    while(not isCanceled() && result->next()) {
+        if (m_limit >= 0 && m_localIds.count() >= m_limit) {
+            break;
+        }
+
+        if (engine()->hasDebugFlag(QContactTrackerEngine::ShowModels)) {
+            qDebug() << result->current();
+        }
+
+        const QContactLocalId id = QctTombstones::parseIri(result->value(0).toString());
+
+        if (id != 0) {
+            m_localIds.append(id);
+        }
+    }
+}
+
 void
 QTrackerContactIdFetchRequest::runEmulated()
 {
@@ -56,9 +56,10 @@ protected: // QTrackerAbstractRequest API
 private: // methods
     void runNative(const QString &queryString);
     void runEmulated();
+    void runTombstones();
 
 private: // fields
-    const QContactFilter  m_filter;
+    QContactFilter  m_filter;
     QList<QContactLocalId> m_localIds;
     QList<QContactSortOrder> m_sorting;
     int m_limit;
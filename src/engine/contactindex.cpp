@@ -0,0 +1,91 @@
+/*********************************************************************************
+ ** This file is part of QtContacts tracker storage plugin
+ **
+ ** Copyright (c) 2011 Nokia Corporation and/or its subsidiary(-ies).
+ **
+ ** Contact:  Nokia Corporation (info@qt.nokia.com)
+ **
+ ** GNU Lesser General Public License Usage
+ ** This file may be used under the terms of the GNU Lesser General Public License
+ ** version 2.1 as published by the Free Software Foundation and appearing in the
+ ** file LICENSE.LGPL included in the packaging of this file.  Please review the
+ ** following information to ensure the GNU Lesser General Public License version
+ ** 2.1 requirements will be met:
+ ** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+ **
+ ** In addition, as a special exception, Nokia gives you certain additional rights.
+ ** These rights are described in the Nokia Qt LGPL Exception version 1.1, included
+ ** in the file LGPL_EXCEPTION.txt in this package.
+ **
+ ** Other Usage
+ ** Alternatively, this file may be used in accordance with the terms and
+ ** conditions contained in a signed written agreement between you and Nokia.
+ *********************************************************************************/
+
+#include "contactindex.h"
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+QctContactIndex::QctContactIndex(ChangeType changeType, QObject *parent)
+    : QObject(parent)
+    , m_populated(false)
+    , m_changeType(changeType)
+{
+}
+
+QctContactIndex::~QctContactIndex()
+{
+}
+
+bool
+QctContactIndex::isPopulated() const
+{
+    QCT_SYNCHRONIZED_READ(&m_lock);
+    return m_populated;
+}
+
+QList<QContactLocalId>
+QctContactIndex::takeStaleContacts()
+{
+    QCT_SYNCHRONIZED_WRITE(&m_lock);
+
+    const QList<QContactLocalId> result = m_staleContacts.toList();
+    m_staleContacts.clear();
+
+    return result;
+}
+
+void
+QctContactIndex::markStale(const QList<QContactLocalId> &contactIds)
+{
+    QCT_SYNCHRONIZED_WRITE(&m_lock);
+
+    // Also track changes while not populated yet: They might have happened while
+    // the worker populating this index was waiting for its query results.
+    m_staleContacts += contactIds.toSet();
+}
+
+void
+QctContactIndex::remove(const QList<QContactLocalId> &contactIds)
+{
+    QCT_SYNCHRONIZED_WRITE(&m_lock);
+
+    foreach(QContactLocalId id, contactIds) {
+        m_staleContacts.remove(id);
+        removeContact(id);
+    }
+}
+
+void
+QctContactIndex::invalidate()
+{
+    QCT_SYNCHRONIZED_WRITE(&m_lock);
+
+    clearContacts();
+    m_staleContacts.clear();
+    m_populated = false;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "moc_contactindex.cpp"
@@ -0,0 +1,169 @@
+/*********************************************************************************
+ ** This file is part of QtContacts tracker storage plugin
+ **
+ ** Copyright (c) 2011 Nokia Corporation and/or its subsidiary(-ies).
+ **
+ ** Contact:  Nokia Corporation (info@qt.nokia.com)
+ **
+ ** GNU Lesser General Public License Usage
+ ** This file may be used under the terms of the GNU Lesser General Public License
+ ** version 2.1 as published by the Free Software Foundation and appearing in the
+ ** file LICENSE.LGPL included in the packaging of this file.  Please review the
+ ** following information to ensure the GNU Lesser General Public License version
+ ** 2.1 requirements will be met:
+ ** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+ **
+ ** In addition, as a special exception, Nokia gives you certain additional rights.
+ ** These rights are described in the Nokia Qt LGPL Exception version 1.1, included
+ ** in the file LGPL_EXCEPTION.txt in this package.
+ **
+ ** Other Usage
+ ** Alternatively, this file may be used in accordance with the terms and
+ ** conditions contained in a signed written agreement between you and Nokia.
+ *********************************************************************************/
+
+#ifndef QCTCONTACTINDEX_H
+#define QCTCONTACTINDEX_H
+
+#include <qtcontacts.h>
+
+#include <lib/threadutils.h>
+
+QTM_USE_NAMESPACE
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*!
+ * Common base of the in-memory indexes kept by the engine.
+ *
+ * The indexes themselves don't run any queries. The request workers populate them, and
+ * feed back the contacts reported as stale by the change listener slots, see
+ * QTrackerAbstractRequest::refreshIndex(). All methods are thread-safe since the change
+ * listener and the request workers live in different threads.
+ */
+class QctContactIndex : public QObject
+{
+    Q_OBJECT
+
+public: // typedefs
+    /// The change listener signals which make contacts stale.
+    enum ChangeType {
+        ContactChanges,
+        RelationshipChanges
+    };
+
+public: // constructors/destructors
+    explicit QctContactIndex(ChangeType changeType = ContactChanges, QObject *parent = 0);
+    virtual ~QctContactIndex();
+
+public: // attributes
+    ChangeType changeType() const { return m_changeType; }
+
+    /// Returns \c true when populate() got called since construction or the last invalidate().
+    bool isPopulated() const;
+
+public: // methods
+    /// Returns the contacts which changed since the last call of this method,
+    /// and forgets about them.
+    QList<QContactLocalId> takeStaleContacts();
+
+public slots:
+    /// Marks \p contactIds for refreshing on next use of the index.
+    void markStale(const QList<QContactLocalId> &contactIds);
+
+    /// Drops \p contactIds from the index.
+    void remove(const QList<QContactLocalId> &contactIds);
+
+    /// Drops the entire index, causing it to get populated again on next use.
+    void invalidate();
+
+protected: // abstract methods, the caller holds the write lock
+    virtual void clearContacts() = 0;
+    virtual void removeContact(QContactLocalId contactId) = 0;
+
+protected: // fields
+    mutable QReadWriteLock m_lock;
+    bool m_populated : 1;
+
+private: // fields
+    const ChangeType m_changeType;
+    QSet<QContactLocalId> m_staleContacts;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*!
+ * Adds populating and updating from the \p DataType results fetched by the request workers.
+ */
+template<typename DataType>
+class QctTypedContactIndex : public QctContactIndex
+{
+public: // typedefs
+    typedef DataType Data;
+
+public: // constructors/destructors
+    explicit QctTypedContactIndex(ChangeType changeType = ContactChanges, QObject *parent = 0)
+        : QctContactIndex(changeType, parent)
+    {
+    }
+
+public: // methods
+    /// Replaces the entire index by \p data.
+    void populate(const Data &data)
+    {
+        QCT_SYNCHRONIZED_WRITE(&m_lock);
+
+        clearContacts();
+        insertContacts(data);
+
+        m_populated = true;
+    }
+
+    /// Replaces the entries of the contacts in \p contactIds by \p data.
+    void update(const QList<QContactLocalId> &contactIds, const Data &data)
+    {
+        QCT_SYNCHRONIZED_WRITE(&m_lock);
+
+        if (not m_populated) {
+            return;
+        }
+
+        foreach(QContactLocalId id, contactIds) {
+            removeContact(id);
+        }
+
+        insertContacts(data);
+    }
+
+protected: // abstract methods, the caller holds the write lock
+    virtual void insertContacts(const Data &data) = 0;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*!
+ * Base of the indexes built from the details of fetched contacts.
+ */
+class QctContactDetailIndex : public QctTypedContactIndex< QList<QContact> >
+{
+public: // constructors/destructors
+    explicit QctContactDetailIndex(QObject *parent = 0)
+        : QctTypedContactIndex<Data>(ContactChanges, parent)
+    {
+    }
+
+protected: // abstract methods, the caller holds the write lock
+    virtual void insertContact(const QContact &contact) = 0;
+
+protected: // QctTypedContactIndex methods
+    virtual void insertContacts(const QList<QContact> &contacts)
+    {
+        foreach(const QContact &contact, contacts) {
+            insertContact(contact);
+        }
+    }
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#endif // QCTCONTACTINDEX_H
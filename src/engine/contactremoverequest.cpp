@@ -24,16 +24,24 @@
 
 #include "contactremoverequest.h"
 #include "engine.h"
+#include "tombstones.h"
 
+#include <dao/contactdetail.h>
 #include <dao/contactdetailschema.h>
 #include <dao/subject.h>
+#include <dao/support.h>
 
 #include <lib/garbagecollector.h>
 #include <lib/sparqlconnectionmanager.h>
 #include <lib/sparqlresolver.h>
 
+#include <ontologies/nco.h>
+
 #include <QtSparql>
 
+CUBI_USE_NAMESPACE
+CUBI_USE_NAMESPACE_RESOURCES
+
 QTrackerContactRemoveRequest::QTrackerContactRemoveRequest(QContactAbstractRequest *request,
                                                            QContactTrackerEngine *engine,
                                                            QObject *parent)
@@ -58,6 +66,140 @@ makeLocalUIDList(const QList<QContactLocalId> &localIdList)
     return idStrings.join(QString::fromLatin1(", "));
 }
 
+static bool
+isLongerChain(const PropertyInfoList &a, const PropertyInfoList &b)
+{
+    return a.count() > b.count();
+}
+
+static QList<PropertyInfoList>
+ownedResourceChains(const QTrackerContactDetailSchemaMap &schemas)
+{
+    QSet<PropertyInfoList> chains;
+
+    // Custom details are nao:Property resources, their fields are nested nao:Property resources.
+    chains += PropertyInfoList() << piHasAffiliation;
+    chains += PropertyInfoList() << piHasProperty;
+    chains += PropertyInfoList() << piHasProperty << piHasProperty;
+    chains += PropertyInfoList() << piHasAffiliation << piHasProperty;
+
+    foreach(const QTrackerContactDetailSchema &schema, schemas) {
+        foreach(const QTrackerContactDetail &detail, schema.details()) {
+            foreach(const PropertyInfoList &chain, detail.possessedChains()) {
+                const QString &rangeIri = chain.last().rangeIri();
+
+                // Don't touch resources of unknown type. IM addresses are shared with
+                // contactsd's IM accounts, leave them to the garbage collector.
+                if (rangeIri == rdfs::Resource::iri() || rangeIri == nco::IMAddress::iri()) {
+                    continue;
+                }
+
+                // custom fields of standard details are attached to the detail's resource
+                chains += chain;
+                chains += PropertyInfoList() << chain << piHasProperty;
+
+                if (detail.hasContext()) {
+                    chains += PropertyInfoList() << piHasAffiliation << chain;
+                    chains += PropertyInfoList() << piHasAffiliation << chain << piHasProperty;
+                }
+            }
+        }
+    }
+
+    // Delete nested resources first, the longer chains pass through the shorter ones.
+    QList<PropertyInfoList> sortedChains = chains.toList();
+    qStableSort(sortedChains.begin(), sortedChains.end(), isLongerChain);
+
+    return sortedChains;
+}
+
+/// Builds the pattern "?from <p1> [ <p2> ?to ]" following the first \p length properties
+/// of \p chain, or returns an empty pattern if \p length is zero.
+static QString
+makeChainPattern(const QString &from, const PropertyInfoList &chain, int length, const QString &to)
+{
+    if (length < 1) {
+        return QString();
+    }
+
+    QString pattern = from;
+
+    for(int i = 0; i < length; ++i) {
+        pattern += (i > 0 ? QLatin1String(" [ ") : QLatin1String(" "));
+        pattern += ResourceValue(chain.at(i).iri()).sparql();
+    }
+
+    pattern += QLatin1Char(' ') + to;
+
+    for(int i = length; i > 1; --i) {
+        pattern += QLatin1String(" ]");
+    }
+
+    return pattern + QLatin1String(" .\n  ");
+}
+
+QString
+QTrackerContactRemoveRequest::buildCascadeQuery(const QList<QContactLocalId> &localIds) const
+{
+    // Only delete resources which are not shared with any parent outside of the removed
+    // contacts, the garbage collector will deal with those once they turned into garbage.
+    static const QString queryTemplate = QLatin1String
+            ("DELETE {\n"
+             "  ?resource a rdfs:Resource\n"
+             "} WHERE {\n"
+             "  ?contact rdf:type nco:Contact .\n"
+             "  %1%4 %2 ?resource .\n"
+             "  FILTER(tracker:id(?contact) IN (%3))\n"
+             "  FILTER(NOT EXISTS {\n"
+             "    ?parent %2 ?resource .\n"
+             "    FILTER(?parent != %4)\n"
+             "    FILTER(NOT EXISTS {\n"
+             "      ?owner rdf:type nco:Contact .\n"
+             "      %5FILTER(tracker:id(?owner) IN (%3))\n"
+             "    })\n"
+             "  })\n"
+             "}\n");
+
+    // parents which are contacts themselves can be checked without following any chain
+    static const QString directQueryTemplate = QLatin1String
+            ("DELETE {\n"
+             "  ?resource a rdfs:Resource\n"
+             "} WHERE {\n"
+             "  ?contact rdf:type nco:Contact ; %1 ?resource .\n"
+             "  FILTER(tracker:id(?contact) IN (%2))\n"
+             "  FILTER(NOT EXISTS {\n"
+             "    ?parent %1 ?resource .\n"
+             "    FILTER(tracker:id(?parent) NOT IN (%2))\n"
+             "  })\n"
+             "}\n");
+
+    static const QString contactVariable = QLatin1String("?contact");
+    static const QString ownerVariable = QLatin1String("?owner");
+    static const QString parentVariable = QLatin1String("?parent");
+    static const QString subjectVariable = QLatin1String("?subject");
+
+    const QString localIdList = makeLocalUIDList(localIds);
+    QString queryString;
+
+    foreach(const PropertyInfoList &chain, ownedResourceChains(engine()->schemas())) {
+        const QString predicate = ResourceValue(chain.last().iri()).sparql();
+
+        if (chain.count() == 1) {
+            queryString += directQueryTemplate.arg(predicate, localIdList);
+            continue;
+        }
+
+        // "?contact <p1> [ <p2> ?subject ] . ?subject <pN> ?resource"
+        const int length = chain.count() - 1;
+        const QString subject = makeChainPattern(contactVariable, chain, length, subjectVariable);
+        const QString owner = makeChainPattern(ownerVariable, chain, length, parentVariable);
+
+        queryString += queryTemplate.arg(subject, predicate, localIdList, subjectVariable, owner);
+    }
+
+    return queryString;
+}
+
 QString
 QTrackerContactRemoveRequest::buildQuery(const QList<QContactLocalId> &localIds) const
 {
@@ -69,15 +211,41 @@ QTrackerContactRemoveRequest::buildQuery(const QList<QContactLocalId> &localIds)
              "  FILTER(tracker:id(?contact) IN (%1))\n"
              "}\n");
 
+    QString queryString;
+
+    // Tombstones must be recorded before the contacts vanish, since they copy their GUIDs.
+    if (engine()->tombstoneRetention() > 0) {
+        queryString += QctTombstones::buildRecordQuery(localIds);
+    }
+
+    // Owned resources must be deleted before the contacts, since
+    // they are found by following the contacts' predicate chains.
+    if (engine()->isCascadeRemoveEnabled()) {
+        queryString += buildCascadeQuery(localIds);
+    }
+
     // Taking localIds from argument instead of taking member because remove requests
     // are split into small chunks to avoid "Too many variables" errors in tracker.
-    return queryTemplate.arg(makeLocalUIDList(localIds));
+    queryString += queryTemplate.arg(makeLocalUIDList(localIds));
+
+    return queryString;
 }
 
 QString
 QTrackerContactRemoveRequest::buildQuery() const
 {
-    return buildQuery(m_contactIds);
+    QString queryString;
+
+    if (engine()->tombstoneRetention() > 0) {
+        queryString += QctTombstones::buildPruneQuery(engine()->tombstoneRetention());
+    }
+
+    // split the local id list to avoid "Too many SQL variables" warning
+    for(int i = 0; i < m_contactIds.count(); i += QctSparqlResolver::ColumnLimit) {
+        queryString += buildQuery(m_contactIds.mid(i, QctSparqlResolver::ColumnLimit));
+    }
+
+    return queryString;
 }
 
 void
@@ -130,20 +298,21 @@ QTrackerContactRemoveRequest::run()
         return;
     }
 
-    while(not m_contactIds.isEmpty()) {
-        // split the local id list to avoid "Too many SQL variables" warning
-        const QList<QContactLocalId> nextLocalIds = m_contactIds.mid(0, QctSparqlResolver::ColumnLimit);
-        m_contactIds = m_contactIds.mid(nextLocalIds.count());
+    // Send all chunks as one update: This only costs a single round trip, and since
+    // tracker runs each update in a transaction the contacts are removed atomically.
+    const QSparqlQuery query(buildQuery(), QSparqlQuery::DeleteStatement);
+    QScopedPointer<QSparqlResult> result(runQuery(query, SyncQueryOptions));
 
-        const QSparqlQuery query(buildQuery(nextLocalIds), QSparqlQuery::DeleteStatement);
-        QScopedPointer<QSparqlResult> result(runQuery(query, SyncQueryOptions));
-
-        if (result.isNull()) {
-            // runQuery() called reportError()
-            break;
-        }
+    if (result.isNull()) {
+        // runQuery() called reportError(), nothing got removed
+        return;
     }
 
+    // the removed contacts must vanish from the indexes before the change listener reports them
+    engine()->removeIndexedContacts(m_contactIds);
+
+    // Even with cascade deletion IM addresses, resources of unknown type and resources
+    // shared with contacts removed in other chunks are left to the garbage collector.
     QctGarbageCollector::trigger(engine()->gcQueryId(), 1.0*nContacts/engine()->gcLimit());
 }
 
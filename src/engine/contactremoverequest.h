@@ -48,6 +48,7 @@ protected: // QTrackerAbstractRequest API
 
 private: // methods
     QString buildQuery(const QList<QContactLocalId> &localIds) const;
+    QString buildCascadeQuery(const QList<QContactLocalId> &localIds) const;
 
 private: // fields
     ErrorMap m_errorMap;
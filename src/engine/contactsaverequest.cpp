@@ -28,6 +28,7 @@
 
 #include <dao/contactdetail.h>
 #include <dao/contactdetailschema.h>
+#include <dao/scalarquerybuilder.h>
 #include <dao/subject.h>
 #include <dao/support.h>
 
@@ -40,6 +41,7 @@
 #include <lib/sparqlconnectionmanager.h>
 #include <lib/sparqlresolver.h>
 
+#include <QtConcurrentRun>
 #include <QtSparql>
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
@@ -385,6 +387,7 @@ private: // fields
 
     const Options::SparqlOptions m_sparqlOptions;
     const ValueList m_weakSyncTargets;
+    const bool m_compactCustomDetails;
 };
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
@@ -587,6 +590,8 @@ QTrackerContactSaveRequest::QTrackerContactSaveRequest(QContactAbstractRequest *
     , m_timestamp(QDateTime::currentDateTime())
     , m_batchSize(0)
     , m_updateCount(0)
+    , m_hasCommonSyncTarget(true)
+    , m_merged(false)
 {
     if (not engine->mangleAllSyncTargets()) {
         m_weakSyncTargets.addValue(LiteralValue(QString()));
@@ -595,10 +600,27 @@ QTrackerContactSaveRequest::QTrackerContactSaveRequest(QContactAbstractRequest *
             m_weakSyncTargets.addValue(LiteralValue(target));
         }
     }
+
+    if (engine->saveCombiningWindow() > 0) {
+        // Requests can only be merged if all their contacts share the same sync target.
+        for(int i = 0; i < m_contacts.count(); ++i) {
+            const QString &syncTarget = m_contacts.at(i).detail<QContactSyncTarget>().syncTarget();
+
+            if (0 == i) {
+                m_syncTarget = syncTarget;
+            } else if (syncTarget != m_syncTarget) {
+                m_hasCommonSyncTarget = false;
+                break;
+            }
+        }
+    }
 }
 
 QTrackerContactSaveRequest::~QTrackerContactSaveRequest()
 {
+    if (engine()->saveCombiningWindow() > 0) {
+        engine()->unregisterCombinableSaveRequest(this);
+    }
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
@@ -1030,6 +1052,7 @@ UpdateBuilder::UpdateBuilder(const QTrackerContactSaveRequest *request,
     , m_variableCounter(1)
     , m_sparqlOptions(request->engine()->updateQueryOptions())
     , m_weakSyncTargets(request->m_weakSyncTargets)
+    , m_compactCustomDetails(request->engine()->isCompactCustomDetailsEnabled())
 {
    // figure out the contact's timestamps
    const QContactTimestamp timestampDetail = contact.detail<QContactTimestamp>();
@@ -1150,6 +1173,13 @@ UpdateBuilder::insertCustomDetail(const Value &subject, const DetailMapping &det
     insertValue(detailProperty, rdf::type::resource(), nao::Property::resource());
     insertValue(detailProperty, nao::propertyName::resource(), LiteralValue(detailName));
 
+    // In compact form all fields go into a single literal instead of separate properties.
+    if (m_compactCustomDetails) {
+        const QString encodedFields = QTrackerScalarContactQueryBuilder::encodeCustomDetailFields(fields);
+        insertValue(detailProperty, nao::propertyValue::resource(), LiteralValue(encodedFields));
+        return;
+    }
+
     for(QVariantMap::ConstIterator i = fields.constBegin(); i != fields.constEnd(); ++i) {
         insertCustomValues(detailProperty, detailName, i.key(), i.value());
     }
@@ -1926,12 +1956,18 @@ isLinkedDetail(const QContactDetail &detail, const QSet<QString> &linkedDetailUr
     return false;
 }
 
-QContactManager::Error
-QTrackerContactSaveRequest::writebackThumbnails(QContact &contact)
+/// Picks the default thumbnail of the contact at @p i, scales it down and writes it to the
+/// avatar cache. Runs on helper threads before the update loop, therefore it must not
+/// modify the contact, nor any other state of the request.
+QTrackerContactSaveRequest::WrittenThumbnail
+QTrackerContactSaveRequest::writeThumbnail(int i) const
 {
+    WrittenThumbnail result;
+    const QContact &contact = m_contacts.at(i);
+
     // skip if thumbnails not in detail mask, if existing
     if (isUnknownDetail(contact, QContactThumbnail::DefinitionName)) {
-        return QContactManager::NoError;
+        return result;
     }
 
     const QSet<QString> accountDetailUris = findAccountDetailUris(contact);
@@ -1943,7 +1979,8 @@ QTrackerContactSaveRequest::writebackThumbnails(QContact &contact)
     if (engine()->hasDebugFlag(QContactTrackerEngine::ShowNotes)) {
         qDebug()
                 << metaObject()->className() << m_stopWatch.elapsed()
-                << ": found" << thumbnailDetails.count() << "thumbnail detail(s)";
+                << ": found" << thumbnailDetails.count() << "thumbnail detail(s)"
+                << "for contact" << i;
     }
 
     foreach(const QContactThumbnail &thumbnail, thumbnailDetails) {
@@ -1958,9 +1995,96 @@ QTrackerContactSaveRequest::writebackThumbnails(QContact &contact)
     }
 
     if (defaultThumbnail.isEmpty()) {
+        return result;
+    }
+
+    // Get avatar thumbnail from detail and scale down when needed.
+    QFile::FileError fileError = QFile::NoError;
+    QImage thumbnailImage = defaultThumbnail.thumbnail();
+    result.fileName = qctWriteThumbnail(thumbnailImage, &fileError);
+
+    if (result.fileName.isEmpty()) {
+        result.error = (QFile::ResizeError == fileError ? QContactManager::OutOfMemoryError
+                                                        : QContactManager::UnspecifiedError);
+    }
+
+    return result;
+}
+
+/// Writes the thumbnails of all contacts in parallel. Scaling, hashing and encoding
+/// the images is expensive, but independent of tracker, so we don't want to pay for
+/// it within the update loop.
+void
+QTrackerContactSaveRequest::writeThumbnails()
+{
+    m_writtenThumbnails.clear();
+
+    // Only dispatch contacts which actually carry some thumbnail,
+    // and which will not be rejected by prepareUpdate() anyway.
+    QList<int> pendingContacts;
+
+    for(int i = 0; i < m_contacts.count(); ++i) {
+        const QString contactManagerUri = m_contacts.at(i).id().managerUri();
+
+        if (m_contactIris.at(i).isEmpty()
+                || (contactManagerUri != engine()->managerUri() && not contactManagerUri.isEmpty())) {
+            continue;
+        }
+
+        if (not m_contacts.at(i).details<QContactThumbnail>().isEmpty()) {
+            pendingContacts += i;
+        }
+    }
+
+    if (pendingContacts.isEmpty()) {
+        return;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    // The calling thread processes the first contact itself.
+    QList< QFuture<WrittenThumbnail> > pendingThumbnails;
+
+    for(int k = 1; k < pendingContacts.count(); ++k) {
+        pendingThumbnails += QtConcurrent::run(this, &QTrackerContactSaveRequest::writeThumbnail,
+                                               pendingContacts.at(k));
+    }
+
+    m_writtenThumbnails.insert(pendingContacts.first(), writeThumbnail(pendingContacts.first()));
+
+    for(int k = 1; k < pendingContacts.count(); ++k) {
+        m_writtenThumbnails.insert(pendingContacts.at(k), pendingThumbnails.at(k - 1).result());
+    }
+
+    // Saving a thumbnail also updates the avatar detail, even for partial save requests.
+    foreach(int i, pendingContacts) {
+        if (not m_writtenThumbnails.value(i).fileName.isEmpty()
+                && isUnknownDetail(m_contacts.at(i), QContactAvatar::DefinitionName)) {
+            m_detailMask += QContactAvatar::DefinitionName;
+            break;
+        }
+    }
+
+    if (engine()->hasDebugFlag(QContactTrackerEngine::ShowTiming)) {
+        qDebug()
+                << metaObject()->className() << m_stopWatch.elapsed()
+                << ": wrote" << pendingContacts.count() << "thumbnails in"
+                << timer.elapsed() << "ms";
+    }
+}
+
+/// Points the default avatar of @p contact to the thumbnail written by writeThumbnails().
+QContactManager::Error
+QTrackerContactSaveRequest::writebackThumbnails(QContact &contact,
+                                                const WrittenThumbnail &thumbnail) const
+{
+    if (thumbnail.fileName.isEmpty() && QContactManager::NoError == thumbnail.error) {
         return QContactManager::NoError;
     }
 
+    const QSet<QString> accountDetailUris = findAccountDetailUris(contact);
+
     // Find default avatar of the contact itself.
     QContactAvatar defaultAvatar;
 
@@ -1971,32 +2095,21 @@ QTrackerContactSaveRequest::writebackThumbnails(QContact &contact)
         }
     }
 
-    // Get avatar thumbnail from detail and scale down when needed.
-    QFile::FileError fileError = QFile::NoError;
-    QImage thumbnailImage = defaultThumbnail.thumbnail();
-    const QString avatarCacheFileName = qctWriteThumbnail(thumbnailImage, &fileError);
-
-    if (avatarCacheFileName.isEmpty()) {
+    if (thumbnail.fileName.isEmpty()) {
         // failed to save avatar picture - remove avatar detail
         contact.removeDetail(&defaultAvatar);
-
-        return (QFile::ResizeError == fileError ? QContactManager::OutOfMemoryError
-                                                : QContactManager::UnspecifiedError);
+        return thumbnail.error;
     }
 
     if (engine()->hasDebugFlag(QContactTrackerEngine::ShowNotes)) {
         qDebug() << metaObject()->className() << m_stopWatch.elapsed()
-                 << ": writing default thumbnail:" << avatarCacheFileName;
+                 << ": writing default thumbnail:" << thumbnail.fileName;
     }
 
     // everything went fine - update avatar detail and proceed
-    defaultAvatar.setImageUrl(QUrl::fromLocalFile(avatarCacheFileName));
+    defaultAvatar.setImageUrl(qctThumbnailUrl(thumbnail.fileName));
     contact.saveDetail(&defaultAvatar);
 
-    if (isUnknownDetail(contact, QContactAvatar::DefinitionName)) {
-        m_detailMask += QContactAvatar::DefinitionName;
-    }
-
     return QContactManager::NoError;
 }
 
@@ -2208,6 +2321,142 @@ QTrackerContactSaveRequest::resolveContactIds()
     return true;
 }
 
+static QString
+makeDetachedResourcePattern(const PropertyInfoList &chain)
+{
+    QString pattern = QLatin1String("?contact ");
+
+    for(PropertyInfoList::ConstIterator p = chain.constBegin(); p != chain.constEnd(); ++p) {
+        if (p != chain.constBegin()) {
+            pattern += QLatin1String("[ ");
+        }
+
+        pattern += ResourceValue(p->iri()).sparql();
+        pattern += QLatin1Char(' ');
+    }
+
+    pattern += QLatin1String("?resource");
+
+    for(int i = chain.count(); i > 1; --i) {
+        pattern += QLatin1String(" ]");
+    }
+
+    return pattern;
+}
+
+bool
+QTrackerContactSaveRequest::collectDetachedResources()
+{
+    static const QString queryTemplate = QLatin1String
+            ("SELECT DISTINCT tracker:id(?resource)\n"
+             "WHERE\n"
+             "{\n"
+             "  {\n"
+             "    %1 .\n"
+             "  }\n"
+             "  FILTER(tracker:id(?contact) IN (%2)) .\n"
+             "}\n");
+    static const QString patternSeparator = QLatin1String
+            (" .\n"
+             "  }\n"
+             "  UNION\n"
+             "  {\n"
+             "    ");
+
+    // Collect the predicate chains deleteRelatedObjects() will break for the updated
+    // contacts. The resources at the end of these chains are the only ones which can
+    // turn into garbage by saving the contacts.
+    QList<QContactLocalId> contactIds;
+    QSet<QString> patterns;
+
+    patterns += makeDetachedResourcePattern(PropertyInfoList() << piHasAffiliation);
+    patterns += makeDetachedResourcePattern(PropertyInfoList() << piHasProperty);
+
+    for(int i = 0; i < m_contacts.count(); ++i) {
+        const QContact &contact = m_contacts.at(i);
+
+        if (isNewContact(contact) || m_contactIris.at(i).isEmpty()) {
+            continue;
+        }
+
+        contactIds += contact.localId();
+
+        foreach(const QTrackerContactDetail &detail, engine()->schema(contact.type()).details()) {
+            if (isUnknownDetail(contact, detail.name())) {
+                continue;
+            }
+
+            foreach(const PropertyInfoList &chain, detail.possessedChains()) {
+                patterns += makeDetachedResourcePattern(chain);
+
+                if (detail.hasContext()) {
+                    patterns += makeDetachedResourcePattern(PropertyInfoList() << piHasAffiliation << chain);
+                }
+            }
+        }
+    }
+
+    const QString patternString = QStringList(patterns.toList()).join(patternSeparator);
+    QSet<uint> knownResourceIds;
+
+    m_detachedResourceIds.clear();
+
+    while(not contactIds.isEmpty()) {
+        // split the local id list to avoid "Too many SQL variables" warning
+        const QList<QContactLocalId> nextContactIds = contactIds.mid(0, QctSparqlResolver::ColumnLimit);
+        QStringList idStrings;
+
+        foreach(QContactLocalId id, nextContactIds) {
+            idStrings += QString::number(id);
+        }
+
+        const QSparqlQuery query(queryTemplate.arg(patternString, idStrings.join(QLatin1String(", "))));
+        QScopedPointer<QSparqlResult> result(runQuery(query, SyncQueryOptions));
+
+        if (result.isNull()) {
+            return false; // runQuery() called reportError()
+        }
+
+        while(result->next()) {
+            const uint resourceId = result->value(0).toUInt();
+
+            if (0 != resourceId && not knownResourceIds.contains(resourceId)) {
+                knownResourceIds.insert(resourceId);
+                m_detachedResourceIds += resourceId;
+            }
+        }
+
+        contactIds = contactIds.mid(nextContactIds.count());
+    }
+
+    return true;
+}
+
+bool
+QTrackerContactSaveRequest::cleanupDetachedResources()
+{
+    // Failing to clean up garbage doesn't make the save request fail, therefore
+    // the error reported by runQuery() must not leak into the request's result.
+    const QContactManager::Error error = lastError();
+    QList<uint> resourceIds = m_detachedResourceIds;
+
+    while(not resourceIds.isEmpty()) {
+        const QList<uint> nextResourceIds = resourceIds.mid(0, QctSparqlResolver::ColumnLimit);
+        const QSparqlQuery query(engine()->cleanupQueryString(nextResourceIds),
+                                 QSparqlQuery::InsertStatement);
+        QScopedPointer<QSparqlResult> result(runQuery(query, SyncBatchQueryOptions));
+
+        if (result.isNull()) {
+            setLastError(error);
+            return false;
+        }
+
+        resourceIds = resourceIds.mid(nextResourceIds.count());
+    }
+
+    return true;
+}
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 
 QTrackerAbstractRequest::Dependencies
@@ -2216,6 +2465,28 @@ QTrackerContactSaveRequest::dependencies() const
     return ResourceCache | GuidAlgorithm;
 }
 
+bool
+QTrackerContactSaveRequest::isCombinableWith(const QTrackerContactSaveRequest *other) const
+{
+    return (m_hasCommonSyncTarget && other->m_hasCommonSyncTarget &&
+            m_syncTarget == other->m_syncTarget &&
+            m_detailMask == other->m_detailMask &&
+            m_nameOrder == other->m_nameOrder);
+}
+
+/// Called by the engine while holding its list of combinable save requests.
+/// Returns \c true if \p leader shall save our contacts.
+bool
+QTrackerContactSaveRequest::mergeInto(const QTrackerContactSaveRequest *leader)
+{
+    if (not isCombinableWith(leader) || not turnIrreversible()) {
+        return false;
+    }
+
+    m_merged = true;
+    return true;
+}
+
 void
 QTrackerContactSaveRequest::run()
 {
@@ -2223,6 +2494,182 @@ QTrackerContactSaveRequest::run()
         return;
     }
 
+    // Some other save request already saved our contacts and handed over the results.
+    if (m_merged) {
+        return;
+    }
+
+    if (engine()->saveCombiningWindow() > 0) {
+        // Give clients the chance to issue more save requests that can be merged with us.
+        engine()->waitForCombinableSaveRequests(this);
+
+        const QList<QTrackerContactSaveRequest *> requests = engine()->takeCombinableSaveRequests(this);
+
+        if (requests.count() > 1) {
+            saveCombinedContacts(requests);
+            return;
+        }
+    }
+
+    saveContacts();
+}
+
+void
+QTrackerContactSaveRequest::saveCombinedContacts(const QList<QTrackerContactSaveRequest *> &requests)
+{
+    if (engine()->hasDebugFlag(QContactTrackerEngine::ShowNotes)) {
+        qDebug()
+                << metaObject()->className() << 0
+                << ": combining" << requests.count() << "save requests";
+    }
+
+    // Collect the contacts of all merged requests, we are the first one.
+    QList<QContact> combinedContacts;
+    QList<int> offsets;
+
+    foreach(const QTrackerContactSaveRequest *request, requests) {
+        offsets += combinedContacts.count();
+        combinedContacts += request->m_contacts;
+    }
+
+    offsets += combinedContacts.count();
+    m_contacts = combinedContacts;
+
+    saveContacts();
+
+    // Hand over the results. Errors of individual contacts only are reported to the request
+    // owning that contact. Errors not related to any contact are reported to every request.
+    const QList<QContact> savedContacts = m_contacts;
+    const ErrorMap errorMap = m_errorMap;
+    const QContactManager::Error error = (errorMap.isEmpty() ? lastError()
+                                                             : QContactManager::NoError);
+
+    for(int i = 0; i < requests.count(); ++i) {
+        QTrackerContactSaveRequest *const request = requests.at(i);
+        const int begin = offsets.at(i), end = offsets.at(i + 1);
+
+        request->m_contacts = savedContacts.mid(begin, end - begin);
+        request->m_errorMap.clear();
+
+        for(ErrorMap::ConstIterator it = errorMap.lowerBound(begin);
+            it != errorMap.constEnd() && it.key() < end; ++it) {
+            request->m_errorMap.insert(it.key() - begin, it.value());
+        }
+
+        request->setLastError(request->m_errorMap.isEmpty() ? error
+                                                            : request->m_errorMap.constBegin().value());
+    }
+}
+
+/// Builds the update query for the contact at @p i. Runs on a helper thread, while the
+/// previous contact's update is executed. Therefore it must not touch any other contact,
+/// nor any state used by executeUpdate().
+QTrackerContactSaveRequest::PreparedUpdate
+QTrackerContactSaveRequest::prepareUpdate(int i)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    PreparedUpdate update;
+    QContact &contact = m_contacts[i];
+    const QContactId contactId = contact.id();
+    const QString contactManagerUri = contactId.managerUri();
+
+    if (engine()->hasDebugFlag(QContactTrackerEngine::ShowNotes)) {
+        qDebug()
+                << metaObject()->className() << m_stopWatch.elapsed()
+                << ": contact" << i << "- preparing";
+    }
+
+    if (m_contactIris.at(i).isEmpty()) {
+        return update; // skip contacts with non-exisitant, non-zero local id
+    }
+
+    // Conforms to behaviour of Symbian backend, but not clear if this is the right behaviour,
+    // see QTMOBILITY-1816.
+    //
+    // hasselmm: It's also not entirely clear how to deal with some valid local id, but an
+    // empty manager URI. QTM unit tests don't seem to test this, but relationship tests
+    // and API suggest that and empty URI shall be interpreted as placeholder for the
+    // actual manager URI.
+    if (contactManagerUri != engine()->managerUri() && not contactManagerUri.isEmpty()) {
+        qctWarn(QString::fromLatin1("Bad id passed for contact %1/%2: manager: \"%3\", id:%4").
+                arg(QString::number(i + 1), QString::number(m_contacts.count()),
+                contactManagerUri, QString::number(contactId.localId())));
+        update.error = QContactManager::DoesNotExistError;
+        update.elapsed = timer.elapsed();
+        return update;
+    }
+
+    // drop odd details, add missing details, collect named details
+    QHash<QString, QContactDetail> detailsByUri;
+    update.error = normalizeContact(contact, detailsByUri);
+
+    if (update.error != QContactManager::NoError) {
+        qctWarn(QString::fromLatin1("Cannot normalize details for contact %1/%2").
+                arg(QString::number(i + 1), QString::number(m_contacts.count())));
+        update.elapsed = timer.elapsed();
+        return update;
+    }
+
+    // point the avatar to the thumbnail written before the update loop
+    update.error = writebackThumbnails(contact, m_writtenThumbnails.value(i));
+
+    if (update.error != QContactManager::NoError) {
+        qctWarn(QString::fromLatin1("Cannot save avatar thumbnail for contact %1/%2").
+                arg(QString::number(i + 1), QString::number(m_contacts.count())));
+        update.elapsed = timer.elapsed();
+        return update;
+    }
+
+    // build the update query
+    UpdateBuilder builder(this, contact, m_contactIris.at(i), detailsByUri, m_detailMask);
+    update.queryString = builder.queryString();
+    update.isExistingContact = builder.isExistingContact();
+    update.elapsed = timer.elapsed();
+
+    return update;
+}
+
+void
+QTrackerContactSaveRequest::executeUpdate(int i, const PreparedUpdate &update,
+                                          QSparqlConnection &connection)
+{
+    if (engine()->hasDebugFlag(QContactTrackerEngine::ShowNotes)) {
+        qDebug()
+                << metaObject()->className() << m_stopWatch.elapsed()
+                << ": contact" << i << "- updating";
+    }
+
+    if (update.isExistingContact) {
+        ++m_updateCount;
+    }
+
+    // run the update query
+    const QSparqlQuery query(update.queryString, QSparqlQuery::InsertStatement);
+    const QSparqlQueryOptions &options = (m_contacts.count() > 1 ? SyncBatchQueryOptions
+                                                                 : SyncQueryOptions);
+    QScopedPointer<QSparqlResult> result(runQuery(query, options, connection));
+
+    if (result.isNull()) {
+        qctWarn(QString::fromLatin1("Save request failed for contact %1/%2").
+            arg(QString::number(i + 1), QString::number(m_contacts.count())));
+        m_errorMap.insert(i, lastError());
+        return;
+    }
+
+    if (result->hasError()) {
+        qctWarn(QString::fromLatin1("Save request failed for contact %1/%2: %3").
+            arg(QString::number(i + 1), QString::number(m_contacts.count()),
+                qctTruncate(result->lastError().message())));
+        m_errorMap.insert(i, translateError(result->lastError()));
+        return;
+    }
+}
+
+void
+QTrackerContactSaveRequest::saveContacts()
+{
     if (m_contacts.isEmpty()) {
         return;
     }
@@ -2240,6 +2687,11 @@ QTrackerContactSaveRequest::run()
         return;
     }
 
+    // remember which resources the updates might turn into garbage
+    if (engine()->isScopedGcEnabled() && not collectDetachedResources()) {
+        return;
+    }
+
     // update tracker with the contacts
     QSparqlConnection &connection = QctSparqlConnectionManager::defaultConnection();
 
@@ -2248,90 +2700,57 @@ QTrackerContactSaveRequest::run()
         return;
     }
 
-    for(int i = 0; i < m_contacts.count(); ++i) {
-        QContact &contact = m_contacts[i];
-        const QContactId contactId = contact.id();
-        const QString contactManagerUri = contactId.managerUri();
+    // Make sure the contact list is detached now, and not by some helper thread
+    // while others are reading it.
+    m_contacts.detach();
 
-        if (engine()->hasDebugFlag(QContactTrackerEngine::ShowNotes)) {
-            qDebug()
-                    << metaObject()->className() << m_stopWatch.elapsed()
-                    << ": contact" << i << "- updating";
-        }
+    // Write all thumbnails up front, so that the update loop doesn't wait for them.
+    writeThumbnails();
 
-        if (m_contactIris.at(i).isEmpty()) {
-            continue; // skip contacts with non-exisitant, non-zero local id
-        }
+    // Prepare the next contact's update while tracker executes the current one.
+    // Preparation only touches the contact it prepares, and state which is not
+    // modified while executing updates.
 
-        // Conforms to behaviour of Symbian backend, but not clear if this is the right behaviour,
-        // see QTMOBILITY-1816.
-        //
-        // hasselmm: It's also not entirely clear how to deal with some valid local id, but an
-        // empty manager URI. QTM unit tests don't seem to test this, but relationship tests
-        // and API suggest that and empty URI shall be interpreted as placeholder for the
-        // actual manager URI.
-        if (contactManagerUri != engine()->managerUri() && not contactManagerUri.isEmpty()) {
-            qctWarn(QString::fromLatin1("Bad id passed for contact %1/%2: manager: \"%3\", id:%4").
-                    arg(QString::number(i + 1), QString::number(m_contacts.count()),
-                    contactManagerUri, QString::number(contactId.localId())));
-            m_errorMap.insert(i, QContactManager::DoesNotExistError);
-            continue;
-        }
+    QElapsedTimer pipelineTimer;
+    qint64 preparationTime = 0, executionTime = 0;
+    pipelineTimer.start();
 
-        // drop odd details, add missing details, collect named details
-        QHash<QString, QContactDetail> detailsByUri;
+    PreparedUpdate update = prepareUpdate(0);
 
-        {
-            const QContactManager::Error error = normalizeContact(contact, detailsByUri);
+    for(int i = 0; i < m_contacts.count(); ++i) {
+        QFuture<PreparedUpdate> nextUpdate;
 
-            if (error != QContactManager::NoError) {
-                qctWarn(QString::fromLatin1("Cannot normalize details for contact %1/%2").
-                        arg(QString::number(i + 1), QString::number(m_contacts.count())));
-                m_errorMap.insert(i, error);
-                continue;
-            }
+        if (i + 1 < m_contacts.count()) {
+            nextUpdate = QtConcurrent::run(this, &QTrackerContactSaveRequest::prepareUpdate, i + 1);
         }
 
-        // normalize and save avatar
-        {
-            const QContactManager::Error error = writebackThumbnails(contact);
+        preparationTime += update.elapsed;
 
-            if (error != QContactManager::NoError) {
-                qctWarn(QString::fromLatin1("Cannot save avatar thumbnail for contact %1/%2").
-                        arg(QString::number(i + 1), QString::number(m_contacts.count())));
-                m_errorMap.insert(i, error);
-                continue;
-            }
-        }
+        if (update.error != QContactManager::NoError) {
+            m_errorMap.insert(i, update.error);
+        } else if (not update.queryString.isEmpty()) {
+            QElapsedTimer executionTimer;
+            executionTimer.start();
 
-        // build the update query
-        UpdateBuilder builder(this, contact, m_contactIris.at(i), detailsByUri, m_detailMask);
-        const QString queryString = builder.queryString();
+            executeUpdate(i, update, connection);
 
-        if (builder.isExistingContact()) {
-            ++m_updateCount;
+            executionTime += executionTimer.elapsed();
         }
 
-        // run the update query
-        const QSparqlQuery query(queryString, QSparqlQuery::InsertStatement);
-        const QSparqlQueryOptions &options = (m_contacts.count() > 1 ? SyncBatchQueryOptions
-                                                                     : SyncQueryOptions);
-        QScopedPointer<QSparqlResult> result(runQuery(query, options, connection));
-
-        if (result.isNull()) {
-            qctWarn(QString::fromLatin1("Save request failed for contact %1/%2").
-                arg(QString::number(i + 1), QString::number(m_contacts.count())));
-            m_errorMap.insert(i, lastError());
-            continue;
+        if (i + 1 < m_contacts.count()) {
+            update = nextUpdate.result();
         }
+    }
 
-        if (result->hasError()) {
-            qctWarn(QString::fromLatin1("Save request failed for contact %1/%2: %3").
-                arg(QString::number(i + 1), QString::number(m_contacts.count()),
-                    qctTruncate(result->lastError().message())));
-            m_errorMap.insert(i, translateError(result->lastError()));
-            continue;
-        }
+    if (engine()->hasDebugFlag(QContactTrackerEngine::ShowTiming)) {
+        const qint64 pipelineTime = pipelineTimer.elapsed();
+
+        qDebug()
+                << metaObject()->className() << m_stopWatch.elapsed()
+                << ": saved" << m_contacts.count() << "contacts in" << pipelineTime << "ms -"
+                << "preparation:" << preparationTime << "ms,"
+                << "updates:" << executionTime << "ms,"
+                << "overlap:" << qMax<qint64>(0, preparationTime + executionTime - pipelineTime) << "ms";
     }
 
     // update contact ids
@@ -2339,6 +2758,17 @@ QTrackerContactSaveRequest::run()
         return;
     }
 
+    // don't wait for the change listener, the next lookup must see the saved contacts
+    QList<QContactLocalId> savedContactIds;
+
+    for(int i = 0; i < m_contacts.count(); ++i) {
+        if (not m_errorMap.contains(i) && 0 != m_contacts.at(i).localId()) {
+            savedContactIds += m_contacts.at(i).localId();
+        }
+    }
+
+    engine()->markIndexedContactsStale(savedContactIds);
+
     // report result
     if (lastError() == QContactManager::NoError && not m_errorMap.isEmpty()) {
         setLastError(m_errorMap.constBegin().value());
@@ -2348,6 +2778,16 @@ QTrackerContactSaveRequest::run()
     // For new contacts we don't have to break any old contact-resource relationships,
     // therefore adding new contacts doesn't increase the amount of garbage.
     if (m_updateCount > 0) {
+        // With scoped garbage collection we only check the resources detached from the
+        // updated contacts. Fall back to the full sweep if that cleanup fails.
+        if (engine()->isScopedGcEnabled()) {
+            if (cleanupDetachedResources()) {
+                return;
+            }
+
+            qctWarn("Cannot clean up detached resources, triggering full garbage collection");
+        }
+
         const double pollutionLevel = double(m_updateCount) / engine()->gcLimit();
         QctGarbageCollector::trigger(engine()->gcQueryId(), pollutionLevel);
     }
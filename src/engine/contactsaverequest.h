@@ -51,6 +51,10 @@ public:
     // might modify local ids
     QString queryString() const;
 
+    // write-combining, see the engine's "save-combining-window" parameter
+    bool isCombinableWith(const QTrackerContactSaveRequest *other) const;
+    bool mergeInto(const QTrackerContactSaveRequest *leader);
+
 public: // QTrackerAbstractRequest API
     void updateRequest(QContactManager::Error error);
     Dependencies dependencies() const;
@@ -59,11 +63,41 @@ public: // QTrackerAbstractRequest API
 private:
     // will remove odd details
     QContactManager::Error normalizeContact(QContact &contact, QHash<QString, QContactDetail> &detailsByUri) const;
-    QContactManager::Error writebackThumbnails(QContact &contact);
+
+    struct WrittenThumbnail
+    {
+        WrittenThumbnail() : error(QContactManager::NoError) {}
+
+        QString fileName;
+        QContactManager::Error error;
+    };
+
+    WrittenThumbnail writeThumbnail(int i) const;
+    void writeThumbnails();
+    QContactManager::Error writebackThumbnails(QContact &contact, const WrittenThumbnail &thumbnail) const;
 
     bool resolveContactIris();
     bool resolveContactIds();
 
+    bool collectDetachedResources();
+    bool cleanupDetachedResources();
+
+    struct PreparedUpdate
+    {
+        PreparedUpdate() : error(QContactManager::NoError), isExistingContact(false), elapsed(0) {}
+
+        QString queryString;
+        QContactManager::Error error;
+        bool isExistingContact;
+        qint64 elapsed;
+    };
+
+    PreparedUpdate prepareUpdate(int i);
+    void executeUpdate(int i, const PreparedUpdate &update, QSparqlConnection &connection);
+
+    void saveContacts();
+    void saveCombinedContacts(const QList<QTrackerContactSaveRequest *> &requests);
+
     static bool isNewContact(const QContact &contact) { return 0 == contact.localId(); }
     bool isFullSaveRequest(const QContact &contact) const { return isNewContact(contact) || m_detailMask.isEmpty(); }
     bool isPartialSaveRequest(const QContact &contact) const { return not isFullSaveRequest(contact); }
@@ -73,6 +107,8 @@ private: // fields
     QList<QContact> m_contacts;
     QStringList m_contactIris;
     QStringList m_detailMask;
+    QList<uint> m_detachedResourceIds;
+    QHash<int, WrittenThumbnail> m_writtenThumbnails;
 
     ErrorMap m_errorMap;
 
@@ -81,6 +117,10 @@ private: // fields
     int m_batchSize;
     int m_updateCount;
 
+    QString m_syncTarget;
+    bool m_hasCommonSyncTarget : 1;
+    bool m_merged : 1;
+
     QElapsedTimer m_stopWatch;
 
     Cubi::ValueList m_weakSyncTargets;
@@ -42,9 +42,18 @@ QTrackerContactSaveOrUnmergeRequest::QTrackerContactSaveOrUnmergeRequest(QContac
                                                                          QContactTrackerEngine *engine,
                                                                          QObject *parent)
     : QTrackerBaseRequest<QctUnmergeIMContactsRequest>(engine, parent)
-    , m_unmergeOnlineAccounts(staticCast(request)->unmergeOnlineAccounts())
-    , m_sourceContact(staticCast(request)->sourceContact())
+    , m_unmergeOnlineAccounts(staticCast(request)->sourceContactOnlineAccounts())
 {
+    if (m_unmergeOnlineAccounts.isEmpty()) {
+        const QContact sourceContact = staticCast(request)->sourceContact();
+
+        // Contacts of other managers are mapped to the invalid id 0,
+        // which gets rejected by resolveSourceContacts().
+        const QContactLocalId sourceId = (sourceContact.id().managerUri() == engine->managerUri()
+                                          ? sourceContact.localId() : 0);
+
+        m_unmergeOnlineAccounts.insert(sourceId, staticCast(request)->unmergeOnlineAccounts());
+    }
 }
 
 QTrackerContactSaveOrUnmergeRequest::~QTrackerContactSaveOrUnmergeRequest()
@@ -58,20 +67,25 @@ QTrackerContactSaveOrUnmergeRequest::buildQuery()
 
     QStringList queries;
 
-    foreach(const QContactOnlineAccount &account, m_unmergeOnlineAccounts) {
-        const QString contactIri(makeAnonymousIri(QUuid::createUuid()));
+    for(OnlineAccountMap::ConstIterator it = m_unmergeOnlineAccounts.constBegin();
+        it != m_unmergeOnlineAccounts.constEnd(); ++it) {
+        const QString sourceContactIri = m_sourceContactIris.value(it.key());
 
-        queries.append(insertContactQuery(contactIri, account).sparql(sparqlOptions));
+        foreach(const QContactOnlineAccount &account, it.value()) {
+            const QString contactIri(makeAnonymousIri(QUuid::createUuid()));
 
-        // When unmerging contacts we add telepathy as a fallback generator, so
-        // that they get deleted properly when their hour comes
-        queries.append(insertTelepathyGeneratorFallbackQuery(contactIri).sparql(sparqlOptions));
+            queries.append(insertContactQuery(sourceContactIri, contactIri, account).sparql(sparqlOptions));
 
-        foreach (const Delete &d, cleanupQueries(account)) {
-            queries.append(d.sparql(sparqlOptions));
-        }
+            // When unmerging contacts we add telepathy as a fallback generator, so
+            // that they get deleted properly when their hour comes
+            queries.append(insertTelepathyGeneratorFallbackQuery(contactIri).sparql(sparqlOptions));
+
+            foreach (const Delete &d, cleanupQueries(sourceContactIri, account)) {
+                queries.append(d.sparql(sparqlOptions));
+            }
 
-        m_unmergedContactIris += contactIri;
+            m_unmergedContactIris += contactIri;
+        }
     }
 
     return queries.join(QLatin1String("\n"));
@@ -84,33 +98,52 @@ QTrackerContactSaveOrUnmergeRequest::run()
         return;
     }
 
-    if (resolveSourceContact() && fetchPredicates() &&
-        unmergeContacts() && resolveUnmergedContactIds()) {
+    if (not resolveSourceContacts() || not fetchPredicates() || not unmergeContacts()) {
+        return;
+    }
+
+    // don't wait for the change listener, the next lookup must see the unmerged contacts
+    QList<QContactLocalId> changedContactIds = m_unmergeOnlineAccounts.keys();
+
+    if (resolveUnmergedContactIds()) {
+        changedContactIds += m_unmergedContactIds;
     }
+
+    engine()->markIndexedContactsStale(changedContactIds);
 }
 
 bool
-QTrackerContactSaveOrUnmergeRequest::resolveSourceContact()
+QTrackerContactSaveOrUnmergeRequest::resolveSourceContacts()
 {
-    if (m_sourceContact.id().managerUri() != engine()->managerUri() ||
-        m_sourceContact.localId() == 0) {
+    if (m_unmergeOnlineAccounts.contains(0)) {
         setLastError(QContactManager::BadArgumentError);
         return false;
     }
 
-    QctResourceIriResolver resolver(QList<QContactLocalId>() << m_sourceContact.localId());
+    // resolve all source contacts at once
+    const QList<QContactLocalId> sourceIds = m_unmergeOnlineAccounts.keys();
+    QctResourceIriResolver resolver(sourceIds);
 
     if (not resolver.lookupAndWait()) {
-        reportError(resolver.errors(), QLatin1String("Cannot resolve resource IRI for source contact"));
+        reportError(resolver.errors(), QLatin1String("Cannot resolve resource IRIs for source contacts"));
         return false;
     }
 
-    if (resolver.resourceIris().count() != 1) {
+    if (resolver.resourceIris().count() != sourceIds.count()) {
         setLastError(QContactManager::DoesNotExistError);
         return false;
     }
 
-    m_sourceContactIri = resolver.resourceIris().first();
+    for(int i = 0; i < sourceIds.count(); ++i) {
+        const QString &iri = resolver.resourceIris().at(i);
+
+        if (iri.isEmpty()) {
+            setLastError(QContactManager::DoesNotExistError);
+            return false;
+        }
+
+        m_sourceContactIris.insert(sourceIds.at(i), iri);
+    }
 
     return true;
 }
@@ -140,7 +173,8 @@ QTrackerContactSaveOrUnmergeRequest::resolveUnmergedContactIds()
 static QVector<QStringList>
 parseResults(const QString &data)
 {
-    const QStringList rows = data.split(QTrackerScalarContactQueryBuilder::detailSeparator());
+    const QStringList rows = data.split(QTrackerScalarContactQueryBuilder::detailSeparator(),
+                                        QString::SkipEmptyParts);
 
     QVector<QStringList> results;
     results.reserve(rows.count());
@@ -154,13 +188,13 @@ parseResults(const QString &data)
     return results;
 }
 
-bool
-QTrackerContactSaveOrUnmergeRequest::fetchPredicates()
+QString
+QTrackerContactSaveOrUnmergeRequest::buildFetchQuery(const QStringList &sourceContactIris) const
 {
     static const LiteralValue detailSeparator(QTrackerScalarContactQueryBuilder::detailSeparator());
     static const LiteralValue fieldSeparator(QTrackerScalarContactQueryBuilder::fieldSeparator());
 
-    // We run two selects (nested in one)
+    // We run two selects (nested in one), returning one row per source contact
     // 1st one is to get the graph of all ?contact ?p ?o statements
     // graph is either qct, or the telepathy iri, so we can use the graph to
     // know which properties to detach from the original contact
@@ -170,7 +204,7 @@ QTrackerContactSaveOrUnmergeRequest::fetchPredicates()
     // contactsd graph (if the affiliation has one IMAddress on it), so we need
     // to check the actual IMAddress to know which affiliations we have to move
 
-    const ResourceValue contact(m_sourceContactIri);
+    const Variable contact(QLatin1String("contact"));
 
     // 1st select
     const Variable predicate;
@@ -210,45 +244,72 @@ QTrackerContactSaveOrUnmergeRequest::fetchPredicates()
                                       detailSeparator));
     accountSelect.addRestriction(g);
 
-    // Final step, combine the two selects in one
+    // Final step, combine the two selects in one, restricted to the source contacts
+    ValueList contactIris;
+
+    foreach(const QString &iri, sourceContactIris) {
+        contactIris.addValue(ResourceValue(iri));
+    }
+
     Select select;
+    select.addProjection(Functions::str.apply(contact));
     select.addProjection(predicateSelect);
     select.addProjection(accountSelect);
+    select.addRestriction(contact, rdf::type::resource(), nco::PersonContact::resource());
+    select.setFilter(Functions::in.apply(contact, contactIris));
 
-    const QSparqlQuery query(select.sparql(engine()->selectQueryOptions()));
-    QScopedPointer<QSparqlResult> result(runQuery(query, SyncQueryOptions));
+    return select.sparql(engine()->selectQueryOptions());
+}
 
-    if (result.isNull()) {
-        return false; // runQuery() calls reportError()
-    }
+bool
+QTrackerContactSaveOrUnmergeRequest::fetchPredicates()
+{
+    // The IRI list is split to avoid "Too many SQL variables"
+    QStringList pendingIris = m_sourceContactIris.values();
 
-    while (result->next()) {
-        const QString predicateData = result->stringValue(0);
-        const QString accountData = result->stringValue(1);
+    while(not pendingIris.isEmpty()) {
+        const QStringList nextIris = pendingIris.mid(0, QctSparqlResolver::ColumnLimit);
+        pendingIris = pendingIris.mid(nextIris.count());
 
-        // We first get the list of predicate/graph
-        foreach (const QStringList &row, parseResults(predicateData)) {
-            if (row.size() != 2) {
-                qctWarn("Skipping invalid result row");
-                continue;
-            }
+        const QSparqlQuery query(buildFetchQuery(nextIris));
+        QScopedPointer<QSparqlResult> result(runQuery(query, SyncQueryOptions));
 
-            // Skip predicates that might blow up the source contact
-            if (row.at(1) == rdf::type::iri()) {
-                continue;
-            }
-
-            m_predicates.insert(row.at(0), row.at(1));
+        if (result.isNull()) {
+            return false; // runQuery() calls reportError()
         }
 
-        // And then the list of affiliation graph/affiliation iri/imaddress iri
-        foreach (const QStringList &row, parseResults(accountData)) {
-            if (row.size() != 3) {
-                qctWarn("Skipping invalid result row");
-                continue;
+        while (result->next()) {
+            const QString contactIri = result->stringValue(0);
+            const QString predicateData = result->stringValue(1);
+            const QString accountData = result->stringValue(2);
+
+            PredicateHash &predicates = m_predicates[contactIri];
+            OnlineAccountHash &onlineAccounts = m_onlineAccounts[contactIri];
+
+            // We first get the list of predicate/graph
+            foreach (const QStringList &row, parseResults(predicateData)) {
+                if (row.size() != 2) {
+                    qctWarn("Skipping invalid result row");
+                    continue;
+                }
+
+                // Skip predicates that might blow up the source contact
+                if (row.at(1) == rdf::type::iri()) {
+                    continue;
+                }
+
+                predicates.insert(row.at(0), row.at(1));
             }
 
-            m_onlineAccounts.insert(row.at(2), qMakePair(row.at(0), row.at(1)));
+            // And then the list of affiliation graph/affiliation iri/imaddress iri
+            foreach (const QStringList &row, parseResults(accountData)) {
+                if (row.size() != 3) {
+                    qctWarn("Skipping invalid result row");
+                    continue;
+                }
+
+                onlineAccounts.insert(row.at(2), qMakePair(row.at(0), row.at(1)));
+            }
         }
     }
 
@@ -263,7 +324,8 @@ QTrackerContactSaveOrUnmergeRequest::unmergeContacts()
 }
 
 Insert
-QTrackerContactSaveOrUnmergeRequest::insertContactQuery(const QString &contactIri,
+QTrackerContactSaveOrUnmergeRequest::insertContactQuery(const QString &sourceContactIri,
+                                                        const QString &contactIri,
                                                         const QContactOnlineAccount &account)
 {
     static const QString affiliationNamePattern = QLatin1String("affiliation%1");
@@ -274,11 +336,12 @@ QTrackerContactSaveOrUnmergeRequest::insertContactQuery(const QString &contactIr
     const QString accountPath = account.value(QContactOnlineAccount__FieldAccountPath);
     const QString accountUri = account.accountUri();
     const QString telepathyIri = makeTelepathyIri(accountPath, accountUri);
+    const OnlineAccountHash onlineAccounts = m_onlineAccounts.value(sourceContactIri);
 
     Insert insert;
 
     // We first reparent all the hasAffiliation statements that were in the telepathy graph (if any)
-    const QSet<QString> telepathyPredicates = m_predicates.values(telepathyIri).toSet();
+    const QSet<QString> telepathyPredicates = m_predicates.value(sourceContactIri).values(telepathyIri).toSet();
 
     Graph commonGraph = Graph(ResourceValue(QtContactsTrackerDefaultGraphIri));
 
@@ -289,7 +352,7 @@ QTrackerContactSaveOrUnmergeRequest::insertContactQuery(const QString &contactIr
     if (not telepathyPredicates.isEmpty()) {
         Graph imGraph = Graph(ResourceValue(telepathyIri));
         Graph restrictionGraph = Graph(ResourceValue(telepathyIri));
-        const ResourceValue source(m_sourceContactIri);
+        const ResourceValue source(sourceContactIri);
 
         foreach (const QString &predicate, telepathyPredicates) {
             const ResourceValue predicateResource(predicate);
@@ -307,8 +370,8 @@ QTrackerContactSaveOrUnmergeRequest::insertContactQuery(const QString &contactIr
     // Because there might be several IMAddress on a single affiliation (if the affiliation
     // statement is in qct's graph, when adding a new contact with OnlineAccounts), we
     // go "down" to IMAddress precision.
-    if (m_onlineAccounts.contains(telepathyIri)) {
-        const QPair<QString, QString> accountData = m_onlineAccounts.value(telepathyIri);
+    if (onlineAccounts.contains(telepathyIri)) {
+        const QPair<QString, QString> accountData = onlineAccounts.value(telepathyIri);
         Graph imAffiliationGraph = Graph(ResourceValue(accountData.first));
         const BlankValue affiliation(affiliationNamePattern.arg(affiliationIndex++));
         ResourceValue imAddress = ResourceValue(telepathyIri);
@@ -324,9 +387,12 @@ QTrackerContactSaveOrUnmergeRequest::insertContactQuery(const QString &contactIr
 }
 
 QList<Delete>
-QTrackerContactSaveOrUnmergeRequest::cleanupQueries(const QContactOnlineAccount &account)
+QTrackerContactSaveOrUnmergeRequest::cleanupQueries(const QString &sourceContactIri,
+                                                    const QContactOnlineAccount &account)
 {
-    const ResourceValue source(m_sourceContactIri);
+    const ResourceValue source(sourceContactIri);
+    const PredicateHash predicates = m_predicates.value(sourceContactIri);
+    const OnlineAccountHash onlineAccounts = m_onlineAccounts.value(sourceContactIri);
     const QString accountPath = account.value(QContactOnlineAccount__FieldAccountPath);
     const QString accountUri = account.accountUri();
     const QString telepathyIri = makeTelepathyIri(accountPath, accountUri);
@@ -336,11 +402,11 @@ QTrackerContactSaveOrUnmergeRequest::cleanupQueries(const QContactOnlineAccount
     Delete d;
 
     // Delete all properties when statement is in the graph of unmerged IMAddress
-    if (m_predicates.contains(telepathyIri)) {
+    if (predicates.contains(telepathyIri)) {
         Graph deleteGraph = Graph(ResourceValue(telepathyIri));
         Graph whereGraph = Graph(ResourceValue(telepathyIri));
 
-        foreach (const QString &predicate, m_predicates.values(telepathyIri).toSet()) {
+        foreach (const QString &predicate, predicates.values(telepathyIri).toSet()) {
             ResourceValue predicateResource = ResourceValue(predicate);
 
             // Avoid predicates that might blow everything up
@@ -367,8 +433,8 @@ QTrackerContactSaveOrUnmergeRequest::cleanupQueries(const QContactOnlineAccount
     d = Delete();
 
     // And also the IMAddress itself
-    if (m_onlineAccounts.contains(telepathyIri)) {
-        const QPair<QString, QString> accountData = m_onlineAccounts.value(telepathyIri);
+    if (onlineAccounts.contains(telepathyIri)) {
+        const QPair<QString, QString> accountData = onlineAccounts.value(telepathyIri);
         const ResourceValue affiliation = ResourceValue(accountData.second);
         const ResourceValue imAddress = ResourceValue(telepathyIri);
 
@@ -53,27 +53,36 @@ protected: // QTrackerAbstractRequest API
 private:
    QString buildQuery();
 
+private: // types
+    typedef QMap<QContactLocalId, QList<QContactOnlineAccount> > OnlineAccountMap;
+    // Maps predicate graph to predicate iris
+    typedef QMultiHash<QString, QString> PredicateHash;
+    // Maps IMAddress iri to (affiliation graph, affiliation iri)
+    typedef QHash<QString, QPair<QString, QString> > OnlineAccountHash;
+
 private: // methods
-    bool resolveSourceContact();
+    bool resolveSourceContacts();
     bool resolveUnmergedContactIds();
 
+    QString buildFetchQuery(const QStringList &sourceContactIris) const;
     bool fetchPredicates();
     bool unmergeContacts();
 
-    Cubi::Insert insertContactQuery(const QString &contactIri, const QContactOnlineAccount &account);
-    QList<Cubi::Delete> cleanupQueries(const QContactOnlineAccount &account);
+    Cubi::Insert insertContactQuery(const QString &sourceContactIri, const QString &contactIri,
+                                    const QContactOnlineAccount &account);
+    QList<Cubi::Delete> cleanupQueries(const QString &sourceContactIri,
+                                       const QContactOnlineAccount &account);
     Cubi::Insert insertTelepathyGeneratorFallbackQuery(const QString &contactIri);
 
 private: // fields
-    const QList<QContactOnlineAccount> m_unmergeOnlineAccounts;
-    const QContact m_sourceContact;
-    QString m_sourceContactIri;
+    OnlineAccountMap m_unmergeOnlineAccounts;
+    QHash<QContactLocalId, QString> m_sourceContactIris;
     QList<QContactLocalId> m_unmergedContactIds;
     QStringList m_unmergedContactIris;
-    // Maps predicate graph to predicate iris
-    QMultiHash<QString, QString> m_predicates;
-    // Maps IMAddress iri to (affiliation graph, affiliation iri)
-    QHash<QString, QPair<QString, QString> > m_onlineAccounts;
+    // Maps source contact iri to its predicates
+    QHash<QString, PredicateHash> m_predicates;
+    // Maps source contact iri to its online accounts
+    QHash<QString, OnlineAccountHash> m_onlineAccounts;
 };
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
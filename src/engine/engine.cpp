@@ -31,6 +31,12 @@
 #include "contactcopyandremoverequest.h"
 #include "contactunmergerequest.h"
 #include "displaylabelgenerator.h"
+#include "keypadindex.h"
+#include "keypadmatchrequest.h"
+#include "membershipindex.h"
+#include "nameindex.h"
+#include "phonenumberindex.h"
+#include "phonenumbermatchrequest.h"
 #include "relationshipfetchrequest.h"
 #include "relationshipremoverequest.h"
 #include "relationshipsaverequest.h"
@@ -47,8 +53,11 @@
 #include <lib/contactmergerequest.h>
 #include <lib/customdetails.h>
 #include <lib/garbagecollector.h>
+#include <lib/keypadmatchrequest.h>
+#include <lib/phonenumbermatchrequest.h>
 #include <lib/presenceutils.h>
 #include <lib/queue.h>
+#include <lib/requestextensions.h>
 #include <lib/settings.h>
 #include <lib/threadutils.h>
 #include <lib/sparqlresolver.h>
@@ -149,6 +158,18 @@ parseParameter(int &result, const QString &key, const QString &text)
  *      Default value: 0.</td>
  * </tr>
  * <tr>
+ *  <td>save-combining-window</td>
+ *  <td>Maximum time (in ms) a save request waits before it starts working, so that compatible
+ *      save requests issued shortly after it (same definition mask, name order and sync
+ *      target) can be merged into the same tracker update. Only save requests queued directly
+ *      after each other are merged, any other request queued between them ends the batch.
+ *      Each merged request still gets its own results and error map.<br/>
+ *      The save request only waits while compatible save requests already are queued after
+ *      it, and stops waiting as soon as any other request gets queued behind them.<br/>
+ *      Valid values: 0 to disable combining, or the window size in milliseconds<br/>
+ *      Default value: 0.</td>
+ * </tr>
+ * <tr>
  *  <td>writeback</td>
  *  <td>Controls which details are written to Tracker on saving.<br/>
  *      Valid values: "", a comma separated list of detail names, or "all"<br/>
@@ -183,6 +204,63 @@ parseParameter(int &result, const QString &key, const QString &text)
  *      Default value: 100</td>
  * </tr>
  * <tr>
+ *  <td>scoped-gc</td>
+ *  <td>Whether save requests should only check the resources they detached from updated
+ *      contacts for garbage, instead of asking contactsd to sweep the entire graph.<br/>
+ *      Valid values: true to clean up the detached resources, false to use the full sweep<br/>
+ *      Default value: false</td>
+ * </tr>
+ * <tr>
+ *  <td>cascade-remove</td>
+ *  <td>Whether remove requests should delete the resources owned by the removed contacts,
+ *      like affiliations, postal addresses and custom properties, in the same update instead
+ *      of leaving them to the garbage collector. Garbage collection still gets triggered for
+ *      IM addresses, resources of unknown type and resources shared with other contacts.<br/>
+ *      Valid values: true to delete owned resources, false to only trigger garbage collection<br/>
+ *      Default value: false</td>
+ * </tr>
+ * <tr>
+ *  <td>tombstone-retention</td>
+ *  <td>Number of days remove and merge requests keep a tombstone of each removed contact,
+ *      holding its local id, GUID and time of removal. The tombstones answer local id
+ *      fetch requests filtering by QContactChangeLogFilter::EventRemoved.<br/>
+ *      Valid values: 0 to disable tombstones, or the retention period in days<br/>
+ *      Default value: 0</td>
+ * </tr>
+ * <tr>
+ *  <td>compact-custom-details</td>
+ *  <td>Whether save requests should store all fields of a custom detail in a single
+ *      literal of one nao:Property, instead of one nao:Property per field value.
+ *      Fetch requests read both encodings, and saving a contact rewrites its custom
+ *      details in the configured encoding. Filters and sort orders on custom detail
+ *      fields only consider the per-field encoding.<br/>
+ *      Valid values: true to use the compact encoding, false to use one property per value<br/>
+ *      Default value: false</td>
+ * </tr>
+ * <tr>
+ *  <td>fetch-threads</td>
+ *  <td>Number of threads used for post-processing the contacts of a fetch request,
+ *      like building display labels and avatars. 0 to use one thread per CPU core,
+ *      1 to do all work in the request's thread.<br/>
+ *      Default value: 0</td>
+ * </tr>
+ * <tr>
+ *  <td>name-index</td>
+ *  <td>Whether to keep an in-memory index of names, nicknames and display labels, which is
+ *      used to resolve case-insensitive MatchStartsWith filters on those details without
+ *      scanning all contacts in tracker.<br/>
+ *      Valid values: true to use the index, false to always query tracker<br/>
+ *      Default value: false</td>
+ * </tr>
+ * <tr>
+ *  <td>membership-index</td>
+ *  <td>Whether to keep an in-memory index of group memberships, which is used to answer
+ *      relationship fetch requests and to resolve relationship filters without querying
+ *      nco:belongsToGroup each time.<br/>
+ *      Valid values: true to use the index, false to always query tracker<br/>
+ *      Default value: false</td>
+ * </tr>
+ * <tr>
  *  <td>guid-algorithm</td>
  *  <td>Name of the GUID algorithm to use<br/>
  *      Valid values: "default", "cellular" (depends on CelullarQt)<br/>
@@ -227,7 +305,10 @@ QContactTrackerEngineParameters::QContactTrackerEngineParameters(const QMap<QStr
     , m_requestTimeout(QContactTrackerEngine::DefaultRequestTimeout)
     , m_trackerTimeout(QContactTrackerEngine::DefaultTrackerTimeout)
     , m_coalescingDelay(QContactTrackerEngine::DefaultCoalescingDelay)
+    , m_saveCombiningWindow(0)
+    , m_tombstoneRetention(0)
     , m_gcLimit(QContactTrackerEngine::DefaultGCLimit)
+    , m_fetchThreads(QContactTrackerEngine::DefaultFetchThreads)
     , m_syncTarget(QContactTrackerEngine::DefaultSyncTarget)
     , m_weakSyncTargets(QContactTrackerEngine::DefaultWeakSyncTargets)
     , m_guidAlgorithm(0)
@@ -237,6 +318,11 @@ QContactTrackerEngineParameters::QContactTrackerEngineParameters(const QMap<QStr
     , m_updateQueryOptions(Cubi::Options::DefaultSparqlOptions)
     , m_omitPresenceChanges(false)
     , m_mangleAllSyncTargets(false)
+    , m_nameIndexEnabled(false)
+    , m_membershipIndexEnabled(false)
+    , m_scopedGcEnabled(false)
+    , m_cascadeRemoveEnabled(false)
+    , m_compactCustomDetailsEnabled(false)
 {
     const QctSettings *const settings = QctThreadLocalData::instance()->settings();
 
@@ -279,6 +365,11 @@ QContactTrackerEngineParameters::QContactTrackerEngineParameters(const QMap<QStr
             continue;
         }
 
+        if (QLatin1String("save-combining-window") == i.key()) {
+            parseParameter(m_saveCombiningWindow, i.key(), i.value());
+            continue;
+        }
+
         if (QLatin1String("writeback") == i.key()) {
             const QSet<QString> values = i.value().split(QLatin1Char(',')).toSet();
             const bool all = values.contains(QLatin1String("all"));
@@ -366,6 +457,41 @@ QContactTrackerEngineParameters::QContactTrackerEngineParameters(const QMap<QStr
             continue;
         }
 
+        if (QLatin1String("scoped-gc") == i.key()) {
+            m_scopedGcEnabled = (i.value().isEmpty() || QVariant(i.value()).toBool());
+            continue;
+        }
+
+        if (QLatin1String("cascade-remove") == i.key()) {
+            m_cascadeRemoveEnabled = (i.value().isEmpty() || QVariant(i.value()).toBool());
+            continue;
+        }
+
+        if (QLatin1String("tombstone-retention") == i.key()) {
+            parseParameter(m_tombstoneRetention, i.key(), i.value());
+            continue;
+        }
+
+        if (QLatin1String("compact-custom-details") == i.key()) {
+            m_compactCustomDetailsEnabled = (i.value().isEmpty() || QVariant(i.value()).toBool());
+            continue;
+        }
+
+        if (QLatin1String("fetch-threads") == i.key()) {
+            parseParameter(m_fetchThreads, i.key(), i.value());
+            continue;
+        }
+
+        if (QLatin1String("name-index") == i.key()) {
+            m_nameIndexEnabled = (i.value().isEmpty() || QVariant(i.value()).toBool());
+            continue;
+        }
+
+        if (QLatin1String("membership-index") == i.key()) {
+            m_membershipIndexEnabled = (i.value().isEmpty() || QVariant(i.value()).toBool());
+            continue;
+        }
+
         if (QLatin1String("guid-algorithm") == i.key()) {
             guidAlgorithmName = i.value();
             continue;
@@ -448,6 +574,10 @@ QContactTrackerEngineData::QContactTrackerEngineData(const QMap<QString, QString
     , m_parameters(parameters, engineName, engineVersion)
     , m_selfContactId(0)
     , m_changeListener(0) // create on demand
+    , m_phoneNumberIndex(0) // created by the engine
+    , m_nameIndex(0) // created by the engine if enabled
+    , m_keypadIndex(0) // created by the engine
+    , m_membershipIndex(0) // created by the engine if enabled
     , m_requestLifeGuard(QMutex::Recursive)
     , m_satisfiedDependencies(QTrackerAbstractRequest::NoDependencies)
     , m_mandatoryTokensFound(false)
@@ -466,6 +596,11 @@ QContactTrackerEngineData::~QContactTrackerEngineData()
     // like this engine or SPARQL resolvers.
     delete m_asyncQueue;
     delete m_syncQueue;
+
+    delete m_phoneNumberIndex;
+    delete m_nameIndex;
+    delete m_keypadIndex;
+    delete m_membershipIndex;
 }
 
 void
@@ -609,11 +744,16 @@ QContactTrackerEngine::QContactTrackerEngine(const QMap<QString, QString> &param
 
     connectSignals();
     registerGcQuery();
+    createIndexes();
 }
 
 QContactTrackerEngine::~QContactTrackerEngine()
 {
     disconnectSignals();
+
+    // send the garbage collector load accumulated by our requests
+    QctGarbageCollector::flush();
+
     delete d;
 }
 
@@ -893,6 +1033,13 @@ QContactTrackerEngine::gcLimit() const
     return d->m_parameters.m_gcLimit;
 }
 
+int
+QContactTrackerEngine::fetchThreads() const
+{
+    const int fetchThreads = d->m_parameters.m_fetchThreads;
+    return (fetchThreads > 0 ? fetchThreads : QThread::idealThreadCount());
+}
+
 int
 QContactTrackerEngine::requestTimeout() const
 {
@@ -911,6 +1058,12 @@ QContactTrackerEngine::coalescingDelay() const
     return d->m_parameters.m_coalescingDelay;
 }
 
+int
+QContactTrackerEngine::saveCombiningWindow() const
+{
+    return d->m_parameters.m_saveCombiningWindow;
+}
+
 QctGuidAlgorithm &
 QContactTrackerEngine::guidAlgorithm() const
 {
@@ -935,6 +1088,30 @@ QContactTrackerEngine::mangleAllSyncTargets() const
     return d->m_parameters.m_mangleAllSyncTargets;
 }
 
+bool
+QContactTrackerEngine::isScopedGcEnabled() const
+{
+    return d->m_parameters.m_scopedGcEnabled;
+}
+
+bool
+QContactTrackerEngine::isCascadeRemoveEnabled() const
+{
+    return d->m_parameters.m_cascadeRemoveEnabled;
+}
+
+int
+QContactTrackerEngine::tombstoneRetention() const
+{
+    return d->m_parameters.m_tombstoneRetention;
+}
+
+bool
+QContactTrackerEngine::isCompactCustomDetailsEnabled() const
+{
+    return d->m_parameters.m_compactCustomDetailsEnabled;
+}
+
 Cubi::Options::SparqlOptions
 QContactTrackerEngine::selectQueryOptions() const
 {
@@ -1187,6 +1364,27 @@ QContactTrackerEngine::relationships(const QString &relationshipType,
             return QList<QContactRelationship>();
         }
 
+        // The First role request just brought the membership index up to date,
+        // so it can answer the Second role without running another request.
+        QctMembershipIndex *const index = const_cast<QContactTrackerEngine *>(this)->membershipIndex();
+
+        if (0 != index && index->isPopulated() && participantId.managerUri() == managerUri()) {
+            QContactRelationship relationship;
+            relationship.setRelationshipType(QContactRelationship::HasMember);
+            relationship.setSecond(participantId);
+
+            QContactId groupId;
+            groupId.setManagerUri(managerUri());
+
+            foreach(QContactLocalId localId, index->groups(participantId.localId())) {
+                groupId.setLocalId(localId);
+                relationship.setFirst(groupId);
+                result += relationship;
+            }
+
+            return result;
+        }
+
         internalError = QContactManager::UnspecifiedError;
         result += relationships(relationshipType, participantId,
                                 QContactRelationship::Second,
@@ -1331,13 +1529,12 @@ QContactTrackerEngine::updateDisplayLabel(QContact &contact, const QString &name
     setContactDisplayLabel(&contact, createDisplayLabel(contact, nameOrder));
 }
 
-QString
-QContactTrackerEngine::createDisplayLabel(const QContact &contact,
-                                          const QString &nameOrder) const
+static QString
+createDisplayLabel(const QContact &contact, const QList<QctDisplayLabelGenerator> &generators)
 {
     QString label;
 
-    foreach(const QctDisplayLabelGenerator &generator, findDisplayNameGenerators(nameOrder)) {
+    foreach(const QctDisplayLabelGenerator &generator, generators) {
         label = generator.createDisplayLabel(contact);
 
         if (not label.isEmpty()) {
@@ -1348,6 +1545,26 @@ QContactTrackerEngine::createDisplayLabel(const QContact &contact,
     return label;
 }
 
+QString
+QContactTrackerEngine::createDisplayLabel(const QContact &contact,
+                                          const QString &nameOrder) const
+{
+    return ::createDisplayLabel(contact, findDisplayNameGenerators(nameOrder));
+}
+
+QList<QctDisplayLabelGenerator>
+QContactTrackerEngine::displayLabelGenerators(const QString &nameOrder) const
+{
+    return findDisplayNameGenerators(nameOrder);
+}
+
+void
+QContactTrackerEngine::updateDisplayLabel(QContact &contact,
+                                          const QList<QctDisplayLabelGenerator> &generators) const
+{
+    setContactDisplayLabel(&contact, ::createDisplayLabel(contact, generators));
+}
+
 template <class T> static void
 transfer(const T &key, const QContactDetail &source, QContactDetail &target)
 {
@@ -1478,8 +1695,10 @@ QContactTrackerEngine::gcQueryId() const
 }
 
 // TODO: we could cache the return value in this function
+/// Builds the garbage collector's DELETE query. If @p resourceIds is empty all resources in
+/// our graph are checked, otherwise only the resources with these tracker ids are considered.
 QString
-QContactTrackerEngine::cleanupQueryString() const
+QContactTrackerEngine::cleanupQueryString(const QList<uint> &resourceIds) const
 {
     // Notice FILTER in WHERE clause - garbage collector needs to verify parenting outside this graph too.
     // reason - IMAccount hasIMAddress in contactsd private graph so no need to delete it. The same could apply
@@ -1507,6 +1726,20 @@ QContactTrackerEngine::cleanupQueryString() const
             ("  FILTER(NOT EXISTS { ?parent <%1> ?resource }) .\n");
     static const QString obsoleteResourcesSuffix = QLatin1String
             ("}\n");
+    static const QString candidateResourcesPattern = QLatin1String
+            ("  FILTER(tracker:id(?resource) IN (%1)) .\n");
+
+    QString candidateRestriction;
+
+    if (not resourceIds.isEmpty()) {
+        QStringList idStrings;
+
+        foreach(uint id, resourceIds) {
+            idStrings += QString::number(id);
+        }
+
+        candidateRestriction = candidateResourcesPattern.arg(idStrings.join(QLatin1String(", ")));
+    }
 
     QString queryString;
 
@@ -1561,6 +1794,7 @@ QContactTrackerEngine::cleanupQueryString() const
     queryString += obsoleteResourcesPrefix.arg(QtContactsTrackerDefaultGraphIri,
                                                nao::Property::iri(),
                                                nao::Property::iri());
+    queryString += candidateRestriction;
     queryString += obsoleteResourcesPattern.arg(nao::hasProperty::iri());
     queryString += obsoleteResourcesSuffix;
 
@@ -1569,6 +1803,7 @@ QContactTrackerEngine::cleanupQueryString() const
         queryString += obsoleteResourcesPrefix.arg(QtContactsTrackerDefaultGraphIri,
                                                    rdfs::Resource::iri(),
                                                    t.key());
+        queryString += candidateRestriction;
 
         if (nco::IMAddress::iri() == t.key()) {
             // FIXME: Remove this workaround for NB#206404 - Saving a contact using
@@ -1685,6 +1920,7 @@ QContactTrackerEngine::startRequestImpl(QContactAbstractRequest *request,
         return 0;
     }
 
+    QTrackerAbstractRequest *const queuedWorker = worker.data();
     QScopedPointer<QctRequestTask> task(new QctRequestTask(guardedRequest.data(), worker.take()));
 
     // Check if some evil client managed to delete the request from some other thread.
@@ -1700,7 +1936,10 @@ QContactTrackerEngine::startRequestImpl(QContactAbstractRequest *request,
         // might be called from a thread which is not the one where the engine was created.
         // In that case, we would get the "QObject: Cannot create children for a parent that
         // is in a different thread" warning, and the parent would be NULL anyway...
-        d->enqueueTask(new QctResourceCacheTask(schemas()), queue);
+        // Dependencies must run before any request relying on them, whatever its priority.
+        QctTask *const resourceCacheTask = new QctResourceCacheTask(schemas());
+        resourceCacheTask->setPriority(QctTask::HighPriority);
+        d->enqueueTask(resourceCacheTask, queue);
         d->m_satisfiedDependencies |= QTrackerAbstractRequest::ResourceCache;
     }
 
@@ -1709,7 +1948,9 @@ QContactTrackerEngine::startRequestImpl(QContactAbstractRequest *request,
         not d->m_satisfiedDependencies.testFlag(QTrackerAbstractRequest::GuidAlgorithm)) {
         // Queue will take ownership of the task
         // See above why we don't set the parent here
-        d->enqueueTask(new QctGuidAlgorithmTask(this), queue);
+        QctTask *const guidAlgorithmTask = new QctGuidAlgorithmTask(this);
+        guidAlgorithmTask->setPriority(QctTask::HighPriority);
+        d->enqueueTask(guidAlgorithmTask, queue);
         d->m_satisfiedDependencies |= QTrackerAbstractRequest::GuidAlgorithm;
     }
 
@@ -1725,6 +1966,7 @@ QContactTrackerEngine::startRequestImpl(QContactAbstractRequest *request,
 
     // Transfer task ownership to the queue.
     QctRequestTask *const result = task.data();
+    registerQueuedWorker(queuedWorker, queue);
     d->enqueueTask(task.take(), queue);
     return result;
 }
@@ -1762,7 +2004,13 @@ QContactTrackerEngine::createRequestWorker(QContactAbstractRequest *request)
         break;
 
     case QContactAbstractRequest::ContactLocalIdFetchRequest:
-        worker = new QTrackerContactIdFetchRequest(request, this);
+        if (0 != qobject_cast<QctPhoneNumberMatchRequest *>(request)) {
+            worker = new QTrackerPhoneNumberMatchRequest(request, this);
+        } else if (0 != qobject_cast<QctKeypadMatchRequest *>(request)) {
+            worker = new QTrackerKeypadMatchRequest(request, this);
+        } else {
+            worker = new QTrackerContactIdFetchRequest(request, this);
+        }
         break;
 
     case QContactAbstractRequest::ContactRemoveRequest:
@@ -1771,6 +2019,7 @@ QContactTrackerEngine::createRequestWorker(QContactAbstractRequest *request)
         } else {
             worker = new QTrackerContactCopyAndRemoveRequest(request, this);
         }
+        dropSharedFetchResults();
         break;
 
     case QContactAbstractRequest::ContactSaveRequest:
@@ -1779,6 +2028,7 @@ QContactTrackerEngine::createRequestWorker(QContactAbstractRequest *request)
         } else {
             worker = new QTrackerContactSaveOrUnmergeRequest(request, this);
         }
+        dropSharedFetchResults();
         break;
 
     case QContactAbstractRequest::RelationshipFetchRequest:
@@ -1787,10 +2037,12 @@ QContactTrackerEngine::createRequestWorker(QContactAbstractRequest *request)
 
     case QContactAbstractRequest::RelationshipRemoveRequest:
         worker = new QTrackerRelationshipRemoveRequest(request, this);
+        dropSharedFetchResults();
         break;
 
     case QContactAbstractRequest::RelationshipSaveRequest:
         worker = new QTrackerRelationshipSaveRequest(request, this);
+        dropSharedFetchResults();
         break;
 
     case QContactAbstractRequest::DetailDefinitionFetchRequest:
@@ -1809,6 +2061,8 @@ QContactTrackerEngine::createRequestWorker(QContactAbstractRequest *request)
         return 0;
     }
 
+    worker->setPriority(QctRequestExtensions::get(request)->priority());
+
     if (hasDebugFlag(ShowNotes)) {
         qDebug() << Q_FUNC_INFO << "time elapsed while constructing request workers:"<< request << t.elapsed();
     }
@@ -1888,6 +2142,76 @@ QContactTrackerEngine::registerGcQuery()
 
 void
 QContactTrackerEngine::connectNotify(const char *signal)
+{
+    {
+        // Clients might connect from several threads, and the index accessors
+        // also create the change listener.
+        QCT_SYNCHRONIZED(&d->m_requestLifeGuard);
+        ensureChangeListener();
+    }
+
+    QContactManagerEngine::connectNotify(signal);
+}
+
+void
+QContactTrackerEngine::createIndexes()
+{
+    // The indexes are created with the engine, since request workers ask for them
+    // from the queue's thread: The change listener must not be created there.
+    // The phone number and keypad indexes only get populated on first use.
+    d->m_phoneNumberIndex = new QctPhoneNumberIndex;
+    connectIndex(d->m_phoneNumberIndex);
+
+    d->m_keypadIndex = new QctKeypadIndex;
+    connectIndex(d->m_keypadIndex);
+
+    if (d->m_parameters.m_nameIndexEnabled) {
+        d->m_nameIndex = new QctNameIndex;
+        connectIndex(d->m_nameIndex);
+    }
+
+    if (d->m_parameters.m_membershipIndexEnabled) {
+        d->m_membershipIndex = new QctMembershipIndex;
+        connectIndex(d->m_membershipIndex);
+    }
+}
+
+void
+QContactTrackerEngine::connectIndex(QctContactIndex *index)
+{
+    // The index must learn about changes even if the client didn't subscribe
+    // to any change signal, therefore force creation of the change listener.
+    ensureChangeListener();
+
+    // Direct connections since the index is used from the worker threads anyway.
+    switch(index->changeType()) {
+    case QctContactIndex::ContactChanges:
+        connect(d->m_changeListener, SIGNAL(contactsAdded(QList<QContactLocalId>)),
+                index, SLOT(markStale(QList<QContactLocalId>)),
+                Qt::DirectConnection);
+        connect(d->m_changeListener, SIGNAL(contactsChanged(QList<QContactLocalId>)),
+                index, SLOT(markStale(QList<QContactLocalId>)),
+                Qt::DirectConnection);
+        break;
+
+    case QctContactIndex::RelationshipChanges:
+        // The relationship signals report both, the groups and the members involved.
+        connect(d->m_changeListener, SIGNAL(relationshipsAdded(QList<QContactLocalId>)),
+                index, SLOT(markStale(QList<QContactLocalId>)),
+                Qt::DirectConnection);
+        connect(d->m_changeListener, SIGNAL(relationshipsRemoved(QList<QContactLocalId>)),
+                index, SLOT(markStale(QList<QContactLocalId>)),
+                Qt::DirectConnection);
+        break;
+    }
+
+    connect(d->m_changeListener, SIGNAL(contactsRemoved(QList<QContactLocalId>)),
+            index, SLOT(remove(QList<QContactLocalId>)),
+            Qt::DirectConnection);
+}
+
+void
+QContactTrackerEngine::ensureChangeListener()
 {
     if (0 == d->m_changeListener) {
         // Create the change listener on demand since:
@@ -1957,8 +2281,267 @@ QContactTrackerEngine::connectNotify(const char *signal)
         // Monitor the choosen listener's signals.
         connectSignals();
     }
+}
 
-    QContactManagerEngine::connectNotify(signal);
+QctPhoneNumberIndex *
+QContactTrackerEngine::phoneNumberIndex()
+{
+    return d->m_phoneNumberIndex;
+}
+
+QctKeypadIndex *
+QContactTrackerEngine::keypadIndex()
+{
+    return d->m_keypadIndex;
+}
+
+/// Returns the index of names, or \c 0 if it was disabled by the "name-index" parameter.
+QctNameIndex *
+QContactTrackerEngine::nameIndex()
+{
+    return d->m_nameIndex;
+}
+
+/// Returns the index of group memberships, or \c 0 if it was disabled by the
+/// "membership-index" parameter.
+QctMembershipIndex *
+QContactTrackerEngine::membershipIndex()
+{
+    return d->m_membershipIndex;
+}
+
+QList<QctContactIndex *>
+QContactTrackerEngine::indexes() const
+{
+    QList<QctContactIndex *> result;
+
+    result << d->m_phoneNumberIndex << d->m_keypadIndex;
+
+    if (0 != d->m_nameIndex) {
+        result << d->m_nameIndex;
+    }
+
+    if (0 != d->m_membershipIndex) {
+        result << d->m_membershipIndex;
+    }
+
+    return result;
+}
+
+/// Marks the contacts in \p contactIds as stale in the indexes built from contact details.
+/// Called by the write workers right after changing contacts, so that the next lookup
+/// sees the change without waiting for the change listener.
+void
+QContactTrackerEngine::markIndexedContactsStale(const QList<QContactLocalId> &contactIds)
+{
+    if (contactIds.isEmpty()) {
+        return;
+    }
+
+    foreach(QctContactIndex *index, indexes()) {
+        if (QctContactIndex::ContactChanges == index->changeType()) {
+            index->markStale(contactIds);
+        }
+    }
+}
+
+/// Drops the contacts in \p contactIds from all indexes.
+/// Called by the write workers right after removing contacts.
+void
+QContactTrackerEngine::removeIndexedContacts(const QList<QContactLocalId> &contactIds)
+{
+    if (contactIds.isEmpty()) {
+        return;
+    }
+
+    foreach(QctContactIndex *index, indexes()) {
+        index->remove(contactIds);
+    }
+}
+
+/// Makes save requests queued on \p queue available for merging into the save request
+/// queued directly before them, see the "save-combining-window" parameter. Any other
+/// worker separates the save requests queued before it from the ones queued after it.
+void
+QContactTrackerEngine::registerQueuedWorker(QTrackerAbstractRequest *worker, TaskQueue queue)
+{
+    if (saveCombiningWindow() <= 0) {
+        return;
+    }
+
+    QCT_SYNCHRONIZED(&d->m_combinableSaveRequestsMutex);
+
+    QList<QTrackerContactSaveRequest *> &requests = d->m_combinableSaveRequests[queue];
+    QTrackerContactSaveRequest *const saveRequest = qobject_cast<QTrackerContactSaveRequest *>(worker);
+
+    if (0 != saveRequest) {
+        requests.append(saveRequest);
+    } else if (not requests.isEmpty() && 0 != requests.last()) {
+        requests.append(0);
+    }
+
+    d->m_combinableSaveRequestsChanged.wakeAll();
+}
+
+static void
+removeLeadingSeparators(QList<QTrackerContactSaveRequest *> &requests)
+{
+    // nothing can be merged across the separators in front of the first save request
+    while(not requests.isEmpty() && 0 == requests.first()) {
+        requests.removeFirst();
+    }
+}
+
+void
+QContactTrackerEngine::unregisterCombinableSaveRequest(QTrackerContactSaveRequest *request)
+{
+    QCT_SYNCHRONIZED(&d->m_combinableSaveRequestsMutex);
+
+    typedef QMap<TaskQueue, QList<QTrackerContactSaveRequest *> > RequestsByQueue;
+
+    for(RequestsByQueue::Iterator it = d->m_combinableSaveRequests.begin();
+        it != d->m_combinableSaveRequests.end(); ++it) {
+        if (it->removeOne(request)) {
+            removeLeadingSeparators(*it);
+            d->m_combinableSaveRequestsChanged.wakeAll();
+            break;
+        }
+    }
+}
+
+/// Tells if \p leader should keep waiting for more save requests: That's the case while
+/// save requests which can be merged into \p leader are queued directly after it, and
+/// nothing else got queued after them yet.
+static bool
+isWaitingForMoreSaveRequests(const QMap<QContactTrackerEngine::TaskQueue,
+                                        QList<QTrackerContactSaveRequest *> > &requestsByQueue,
+                             const QTrackerContactSaveRequest *leader)
+{
+    foreach(const QList<QTrackerContactSaveRequest *> &requests, requestsByQueue) {
+        const int i = requests.indexOf(const_cast<QTrackerContactSaveRequest *>(leader));
+
+        if (i < 0) {
+            continue;
+        }
+
+        for(int j = i + 1; j < requests.count(); ++j) {
+            if (0 == requests.at(j) || not requests.at(j)->isCombinableWith(leader)) {
+                return false;
+            }
+        }
+
+        return (i + 1 < requests.count());
+    }
+
+    return false;
+}
+
+/*!
+ * Blocks the queue of \p leader for at most the "save-combining-window", so that more
+ * save requests can be merged into it. Returns immediately if no compatible save request
+ * is queued directly after \p leader, and as soon as any other request gets queued after
+ * them: Idle waiting would only delay the requests waiting in the same queue.
+ */
+void
+QContactTrackerEngine::waitForCombinableSaveRequests(const QTrackerContactSaveRequest *leader)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    QCT_SYNCHRONIZED(&d->m_combinableSaveRequestsMutex);
+
+    qint64 remaining = saveCombiningWindow();
+
+    while(remaining > 0 && isWaitingForMoreSaveRequests(d->m_combinableSaveRequests, leader)) {
+        d->m_combinableSaveRequestsChanged.wait(&d->m_combinableSaveRequestsMutex, remaining);
+        remaining = saveCombiningWindow() - timer.elapsed();
+    }
+}
+
+/*!
+ * Takes \p leader and the waiting save requests which can be merged into it from the list
+ * of combinable save requests. Only save requests queued directly after \p leader are taken,
+ * up to the first request which is not a compatible save request: Writes queued between them
+ * must not be overtaken. The merged requests don't do any work on their own anymore,
+ * \p leader saves their contacts and hands over the results. Returns an empty list if some
+ * other save request already took \p leader.
+ */
+QList<QTrackerContactSaveRequest *>
+QContactTrackerEngine::takeCombinableSaveRequests(QTrackerContactSaveRequest *leader)
+{
+    QCT_SYNCHRONIZED(&d->m_combinableSaveRequestsMutex);
+
+    typedef QMap<TaskQueue, QList<QTrackerContactSaveRequest *> > RequestsByQueue;
+
+    QList<QTrackerContactSaveRequest *> result;
+
+    for(RequestsByQueue::Iterator it = d->m_combinableSaveRequests.begin();
+        it != d->m_combinableSaveRequests.end(); ++it) {
+        QList<QTrackerContactSaveRequest *> &requests = *it;
+        const int i = requests.indexOf(leader);
+
+        if (i < 0) {
+            continue;
+        }
+
+        requests.removeAt(i);
+        result += leader;
+
+        // Requests queued on the leader's queue cannot run while the leader is running.
+        while(i < requests.count() && 0 != requests.at(i) && requests.at(i)->mergeInto(leader)) {
+            result += requests.takeAt(i);
+        }
+
+        removeLeadingSeparators(requests);
+        break;
+    }
+
+    return result;
+}
+
+/*!
+ * Returns the result shared by in-flight fetch requests with the same filter, sorting,
+ * fetch hint and name order as \p request. A new result is created if there is none yet,
+ * if the matching requests already finished, or if a write request was created since.
+ */
+QSharedPointer<QctSharedFetchResult>
+QContactTrackerEngine::sharedFetchResult(const QContactFetchRequest *request,
+                                         const QString &nameOrder)
+{
+    QCT_SYNCHRONIZED_WRITE(&d->m_tableLock);
+
+    QList< QWeakPointer<QctSharedFetchResult> >::Iterator it = d->m_sharedFetchResults.begin();
+
+    while(it != d->m_sharedFetchResults.end()) {
+        const QSharedPointer<QctSharedFetchResult> result = it->toStrongRef();
+
+        // Forget results which are not referenced by any worker anymore, or which have been
+        // published already: New requests might be started because the published data is stale.
+        if (result.isNull() || result->isPublished()) {
+            it = d->m_sharedFetchResults.erase(it);
+            continue;
+        }
+
+        if (result->matches(request, nameOrder)) {
+            return result;
+        }
+
+        ++it;
+    }
+
+    const QSharedPointer<QctSharedFetchResult> result(new QctSharedFetchResult(request, nameOrder));
+    d->m_sharedFetchResults.append(result);
+    return result;
+}
+
+void
+QContactTrackerEngine::dropSharedFetchResults()
+{
+    QCT_SYNCHRONIZED_WRITE(&d->m_tableLock);
+
+    // The fetch requests holding these results still share them among each other,
+    // since they were all queued before the write.
+    d->m_sharedFetchResults.clear();
 }
 
 void
@@ -2166,14 +2749,27 @@ QContactTrackerEngine::cancelRequest(QContactAbstractRequest *request)
     }
 
     QCT_SYNCHRONIZED(&d->m_requestLifeGuard);
-    QCT_SYNCHRONIZED_READ(&d->m_tableLock);
 
-    QTrackerAbstractRequest *const worker = d->m_workersByRequest.value(request);
+    QTrackerAbstractRequest *worker = 0;
 
-    if (0 != worker) {
-        return worker->cancel();
+    {
+        QCT_SYNCHRONIZED_READ(&d->m_tableLock);
+        worker = d->m_workersByRequest.value(request);
     }
-    return false;
+
+    if (0 == worker) {
+        return false;
+    }
+
+    // Requests still waiting in the queue get canceled right away. Reporting the
+    // canceled state makes the request's task finish, which removes it from the queue
+    // before it gets the chance to run any query.
+    if (worker->cancelUnstarted()) {
+        updateRequestState(request, QContactAbstractRequest::CanceledState);
+        return true;
+    }
+
+    return worker->cancel();
 }
 
 bool
@@ -35,8 +35,16 @@ QTM_USE_NAMESPACE
 
 class QTrackerAbstractRequest;
 class QTrackerContactDetailSchema;
+class QctDisplayLabelGenerator;
 class QctGuidAlgorithm;
+class QctContactIndex;
+class QctKeypadIndex;
+class QctMembershipIndex;
+class QctNameIndex;
+class QctPhoneNumberIndex;
+class QctSharedFetchResult;
 class QctTask;
+class QTrackerContactSaveRequest;
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
@@ -109,6 +117,7 @@ public:
     static const int DefaultTrackerTimeout = 30 * 1000; // 30 seconds
     static const int DefaultCoalescingDelay = 10; // 10 milliseconds
     static const int DefaultGCLimit = 100;
+    static const int DefaultFetchThreads = 0; // one per CPU core
     static const QString DefaultSyncTarget;
     static const QStringList DefaultWeakSyncTargets;
 
@@ -188,10 +197,16 @@ public: // custom attributes
     int requestTimeout() const;
     int trackerTimeout() const;
     int coalescingDelay() const;
+    int saveCombiningWindow() const;
+    int fetchThreads() const;
     QctGuidAlgorithm & guidAlgorithm() const;
     const QString & syncTarget() const;
     const QStringList & weakSyncTargets() const;
     bool mangleAllSyncTargets() const;
+    bool isScopedGcEnabled() const;
+    bool isCascadeRemoveEnabled() const;
+    int tombstoneRetention() const;
+    bool isCompactCustomDetailsEnabled() const;
 
     Cubi::Options::SparqlOptions selectQueryOptions() const;
     Cubi::Options::SparqlOptions updateQueryOptions() const;
@@ -206,10 +221,25 @@ public: // custom methods
     /// creates display label for contact, using the generator-list given by @param nameOrder,
     /// which is the default one if @param nameOrder is an empty string
     QString createDisplayLabel(const QContact &contact, const QString &nameOrder = QString()) const;
+    /// returns the display label generators used for @param nameOrder. Unlike updateDisplayLabel()
+    /// the overload taking this list can be called from any thread
+    QList<QctDisplayLabelGenerator> displayLabelGenerators(const QString &nameOrder) const;
+    void updateDisplayLabel(QContact &contact, const QList<QctDisplayLabelGenerator> &generators) const;
     void updateAvatar(QContact &contact);
     bool isWeakSyncTarget(const QString &syncTarget) const;
     QString gcQueryId() const;
-    QString cleanupQueryString() const;
+    QString cleanupQueryString(const QList<uint> &resourceIds = QList<uint>()) const;
+    QctPhoneNumberIndex * phoneNumberIndex();
+    QctNameIndex * nameIndex();
+    QctKeypadIndex * keypadIndex();
+    QctMembershipIndex * membershipIndex();
+    void markIndexedContactsStale(const QList<QContactLocalId> &contactIds);
+    void removeIndexedContacts(const QList<QContactLocalId> &contactIds);
+    QSharedPointer<QctSharedFetchResult> sharedFetchResult(const QContactFetchRequest *request,
+                                                           const QString &nameOrder);
+    void unregisterCombinableSaveRequest(QTrackerContactSaveRequest *request);
+    void waitForCombinableSaveRequests(const QTrackerContactSaveRequest *leader);
+    QList<QTrackerContactSaveRequest *> takeCombinableSaveRequests(QTrackerContactSaveRequest *leader);
 
 protected:
     void connectNotify(const char *signal);
@@ -235,8 +265,24 @@ private:
     void connectSignals();
     void disconnectSignals();
 
+    /// Creates the change listener unless it already exists.
+    void ensureChangeListener();
+
+    /// Creates the indexes enabled by the engine parameters.
+    void createIndexes();
+
+    /// Connects \p index to the change listener, creating the listener if needed.
+    void connectIndex(QctContactIndex *index);
+    QList<QctContactIndex *> indexes() const;
+
+    /// Tracks the order of the workers queued on \p queue for combining save requests.
+    void registerQueuedWorker(QTrackerAbstractRequest *worker, TaskQueue queue);
+
     void registerGcQuery();
 
+    /// Prevents requests created after a write from reusing results of earlier fetch requests.
+    void dropSharedFetchResults();
+
 private:
     QContactTrackerEngineData *d;
 };
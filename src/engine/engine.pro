@@ -40,6 +40,7 @@ HEADERS += \
     contactfetchrequest.h \
     contactfetchbyidrequest.h \
     contactidfetchrequest.h \
+    contactindex.h \
     contactremoverequest.h \
     contactsaverequest.h \
     contactunmergerequest.h \
@@ -48,10 +49,17 @@ HEADERS += \
     engine.h \
     engine_p.h \
     guidalgorithm.h \
+    keypadindex.h \
+    keypadmatchrequest.h \
+    membershipindex.h \
+    nameindex.h \
+    phonenumberindex.h \
+    phonenumbermatchrequest.h \
     relationshipfetchrequest.h \
     relationshipremoverequest.h \
     relationshipsaverequest.h \
-    tasks.h
+    tasks.h \
+    tombstones.h
 
 SOURCES += \
     abstractcontactfetchrequest.cpp \
@@ -60,6 +68,7 @@ SOURCES += \
     contactfetchrequest.cpp \
     contactfetchbyidrequest.cpp \
     contactidfetchrequest.cpp \
+    contactindex.cpp \
     contactremoverequest.cpp \
     contactsaverequest.cpp \
     contactunmergerequest.cpp \
@@ -67,10 +76,17 @@ SOURCES += \
     displaylabelgenerator.cpp \
     engine.cpp \
     guidalgorithm.cpp \
+    keypadindex.cpp \
+    keypadmatchrequest.cpp \
+    membershipindex.cpp \
+    nameindex.cpp \
+    phonenumberindex.cpp \
+    phonenumbermatchrequest.cpp \
     relationshipfetchrequest.cpp \
     relationshipremoverequest.cpp \
     relationshipsaverequest.cpp \
-    tasks.cpp
+    tasks.cpp \
+    tombstones.cpp
 
 OTHER_FILES += \
     engine.pri
@@ -37,6 +37,10 @@
 
 typedef QMap<QString, QContactDetailDefinitionMap> CustomContactDetailMap;
 
+class QctKeypadIndex;
+class QctMembershipIndex;
+class QctNameIndex;
+class QctPhoneNumberIndex;
 class QctTrackerChangeListener;
 class QctTrackerIdResolver;
 
@@ -52,7 +56,10 @@ public: // fields
     int m_requestTimeout;
     int m_trackerTimeout;
     int m_coalescingDelay;
+    int m_saveCombiningWindow;
+    int m_tombstoneRetention;
     int m_gcLimit;
+    int m_fetchThreads;
 
     QString m_syncTarget;
     QStringList m_weakSyncTargets;
@@ -71,6 +78,11 @@ public: // fields
 
     bool m_omitPresenceChanges : 1;
     bool m_mangleAllSyncTargets : 1;
+    bool m_nameIndexEnabled : 1;
+    bool m_membershipIndexEnabled : 1;
+    bool m_scopedGcEnabled : 1;
+    bool m_cascadeRemoveEnabled : 1;
+    bool m_compactCustomDetailsEnabled : 1;
 };
 
 class QContactTrackerEngineData : public QSharedData
@@ -93,12 +105,25 @@ public: // caches
 
 public: // state
     QctTrackerChangeListener *m_changeListener;
+    QctPhoneNumberIndex *m_phoneNumberIndex;
+    QctNameIndex *m_nameIndex;
+    QctKeypadIndex *m_keypadIndex;
+    QctMembershipIndex *m_membershipIndex;
 
     QHash<const QContactAbstractRequest*, QTrackerAbstractRequest*> m_workersByRequest;
     QHash<const QTrackerAbstractRequest*, QContactAbstractRequest*> m_requestsByWorker;
     QReadWriteLock m_tableLock;
     QMutex m_requestLifeGuard;
 
+    // Results of in-flight fetch requests, shared with identical requests
+    QList< QWeakPointer<QctSharedFetchResult> > m_sharedFetchResults;
+
+    // Save requests waiting to be merged into other save requests, in queue order.
+    // Null entries stand for other requests queued between them.
+    QMap<TaskQueue, QList<QTrackerContactSaveRequest *> > m_combinableSaveRequests;
+    QMutex m_combinableSaveRequestsMutex;
+    QWaitCondition m_combinableSaveRequestsChanged;
+
     void enqueueTask(QctTask *task, TaskQueue queue);
 
     CustomContactDetailMap m_customDetails;
@@ -0,0 +1,145 @@
+/*********************************************************************************
+ ** This file is part of QtContacts tracker storage plugin
+ **
+ ** Copyright (c) 2011 Nokia Corporation and/or its subsidiary(-ies).
+ **
+ ** Contact:  Nokia Corporation (info@qt.nokia.com)
+ **
+ ** GNU Lesser General Public License Usage
+ ** This file may be used under the terms of the GNU Lesser General Public License
+ ** version 2.1 as published by the Free Software Foundation and appearing in the
+ ** file LICENSE.LGPL included in the packaging of this file.  Please review the
+ ** following information to ensure the GNU Lesser General Public License version
+ ** 2.1 requirements will be met:
+ ** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+ **
+ ** In addition, as a special exception, Nokia gives you certain additional rights.
+ ** These rights are described in the Nokia Qt LGPL Exception version 1.1, included
+ ** in the file LGPL_EXCEPTION.txt in this package.
+ **
+ ** Other Usage
+ ** Alternatively, this file may be used in accordance with the terms and
+ ** conditions contained in a signed written agreement between you and Nokia.
+ *********************************************************************************/
+
+#include "keypadindex.h"
+
+#include <lib/phoneutils.h>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+QctKeypadIndex::QctKeypadIndex(const QLocale &locale, QObject *parent)
+    : QctContactDetailIndex(parent)
+    , m_locale(locale)
+{
+}
+
+QctKeypadIndex::~QctKeypadIndex()
+{
+}
+
+QStringList
+QctKeypadIndex::detailDefinitionNames()
+{
+    return QStringList() << QContactName::DefinitionName
+                         << QContactNickname::DefinitionName
+                         << QContactPhoneNumber::DefinitionName;
+}
+
+QList<QContactLocalId>
+QctKeypadIndex::lookup(const QString &digits) const
+{
+    typedef QMultiMap<QString, QContactLocalId> KeyMap;
+
+    QCT_SYNCHRONIZED_READ(&m_lock);
+
+    QList<QContactLocalId> result;
+    QSet<QContactLocalId> seen;
+
+    // all keys starting with the digits are found in one sequence following the digits itself
+    for(KeyMap::ConstIterator it = m_contactsByKey.lowerBound(digits);
+        it != m_contactsByKey.constEnd() && it.key().startsWith(digits); ++it) {
+        if (not seen.contains(it.value())) {
+            seen.insert(it.value());
+            result += it.value();
+        }
+    }
+
+    return result;
+}
+
+void
+QctKeypadIndex::clearContacts()
+{
+    m_contactsByKey.clear();
+    m_keysByContact.clear();
+}
+
+QSet<QString>
+QctKeypadIndex::makeKeys(const QContact &contact) const
+{
+    static const QRegExp wordSeparators(QLatin1String("\\W+"));
+
+    QSet<QString> keys;
+
+    // each word of the names, and the full name for typing across first and last name
+    const QContactName name = contact.detail<QContactName>();
+    QStringList words;
+
+    words += name.firstName().split(wordSeparators, QString::SkipEmptyParts);
+    words += name.lastName().split(wordSeparators, QString::SkipEmptyParts);
+
+    keys += qctMakeKeypadDigits(words.join(QString()), m_locale);
+
+    foreach(const QContactNickname &nickname, contact.details<QContactNickname>()) {
+        words += nickname.nickname().split(wordSeparators, QString::SkipEmptyParts);
+    }
+
+    foreach(const QString &word, words) {
+        keys += qctMakeKeypadDigits(word, m_locale);
+    }
+
+    // all suffixes of the phone numbers, so that prefix lookups find any part of the number
+    foreach(const QContactPhoneNumber &phoneNumber, contact.details<QContactPhoneNumber>()) {
+        QString number = qctNormalizePhoneNumber(phoneNumber.number(),
+                                                 Qct::RemoveUnicodeFormatters |
+                                                 Qct::RemoveNumberFormatters |
+                                                 Qct::ConvertToLatin);
+
+        const int dtmfIndex = number.indexOf(qctPhoneNumberDTMFChars());
+
+        if (dtmfIndex >= 0) {
+            number.truncate(dtmfIndex);
+        }
+
+        // drop the plus sign of international numbers
+        number = qctMakeKeypadDigits(number, m_locale);
+
+        for(int i = 0; i < number.length(); ++i) {
+            keys += number.mid(i);
+        }
+    }
+
+    keys.remove(QString());
+
+    return keys;
+}
+
+void
+QctKeypadIndex::insertContact(const QContact &contact)
+{
+    foreach(const QString &key, makeKeys(contact)) {
+        m_contactsByKey.insert(key, contact.localId());
+        m_keysByContact.insert(contact.localId(), key);
+    }
+}
+
+void
+QctKeypadIndex::removeContact(QContactLocalId contactId)
+{
+    foreach(const QString &key, m_keysByContact.values(contactId)) {
+        m_contactsByKey.remove(key, contactId);
+    }
+
+    m_keysByContact.remove(contactId);
+}
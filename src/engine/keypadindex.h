@@ -0,0 +1,74 @@
+/*********************************************************************************
+ ** This file is part of QtContacts tracker storage plugin
+ **
+ ** Copyright (c) 2011 Nokia Corporation and/or its subsidiary(-ies).
+ **
+ ** Contact:  Nokia Corporation (info@qt.nokia.com)
+ **
+ ** GNU Lesser General Public License Usage
+ ** This file may be used under the terms of the GNU Lesser General Public License
+ ** version 2.1 as published by the Free Software Foundation and appearing in the
+ ** file LICENSE.LGPL included in the packaging of this file.  Please review the
+ ** following information to ensure the GNU Lesser General Public License version
+ ** 2.1 requirements will be met:
+ ** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+ **
+ ** In addition, as a special exception, Nokia gives you certain additional rights.
+ ** These rights are described in the Nokia Qt LGPL Exception version 1.1, included
+ ** in the file LGPL_EXCEPTION.txt in this package.
+ **
+ ** Other Usage
+ ** Alternatively, this file may be used in accordance with the terms and
+ ** conditions contained in a signed written agreement between you and Nokia.
+ *********************************************************************************/
+
+#ifndef QCTKEYPADINDEX_H
+#define QCTKEYPADINDEX_H
+
+#include "contactindex.h"
+
+#include <QLocale>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*!
+ * Maps the keypad digits of contact names, and the digits of all phone number suffixes,
+ * to the contacts owning them. Looking up the typed digits as prefix of those keys
+ * gives the names starting with the typed letters, and the phone numbers containing
+ * the typed digits.
+ *
+ * The index gets populated and updated from the contacts fetched by
+ * QTrackerKeypadMatchRequest, see QctContactIndex for the threading details.
+ */
+class QctKeypadIndex : public QctContactDetailIndex
+{
+public: // constructors/destructors
+    explicit QctKeypadIndex(const QLocale &locale = QLocale(), QObject *parent = 0);
+    virtual ~QctKeypadIndex();
+
+public: // attributes
+    /// Returns the details which must be fetched for populate() and update().
+    static QStringList detailDefinitionNames();
+
+public: // methods
+    /// Returns the contacts with a key starting with \p digits.
+    QList<QContactLocalId> lookup(const QString &digits) const;
+
+protected: // QctContactIndex methods
+    virtual void clearContacts();
+    virtual void removeContact(QContactLocalId contactId);
+    virtual void insertContact(const QContact &contact);
+
+private: // methods
+    QSet<QString> makeKeys(const QContact &contact) const;
+
+private: // fields
+    const QLocale m_locale;
+
+    QMultiMap<QString, QContactLocalId> m_contactsByKey;
+    QMultiHash<QContactLocalId, QString> m_keysByContact;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#endif // QCTKEYPADINDEX_H
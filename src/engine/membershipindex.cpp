@@ -0,0 +1,249 @@
+/*********************************************************************************
+ ** This file is part of QtContacts tracker storage plugin
+ **
+ ** Copyright (c) 2011 Nokia Corporation and/or its subsidiary(-ies).
+ **
+ ** Contact:  Nokia Corporation (info@qt.nokia.com)
+ **
+ ** GNU Lesser General Public License Usage
+ ** This file may be used under the terms of the GNU Lesser General Public License
+ ** version 2.1 as published by the Free Software Foundation and appearing in the
+ ** file LICENSE.LGPL included in the packaging of this file.  Please review the
+ ** following information to ensure the GNU Lesser General Public License version
+ ** 2.1 requirements will be met:
+ ** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+ **
+ ** In addition, as a special exception, Nokia gives you certain additional rights.
+ ** These rights are described in the Nokia Qt LGPL Exception version 1.1, included
+ ** in the file LGPL_EXCEPTION.txt in this package.
+ **
+ ** Other Usage
+ ** Alternatively, this file may be used in accordance with the terms and
+ ** conditions contained in a signed written agreement between you and Nokia.
+ *********************************************************************************/
+
+#include "membershipindex.h"
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+QctMembershipIndex::QctMembershipIndex(QObject *parent)
+    : QctTypedContactIndex<MembersByGroup>(RelationshipChanges, parent)
+{
+}
+
+QctMembershipIndex::~QctMembershipIndex()
+{
+}
+
+QList<QContactLocalId>
+QctMembershipIndex::members(QContactLocalId groupId) const
+{
+    QCT_SYNCHRONIZED_READ(&m_lock);
+    return m_membersByGroup.value(groupId).toList();
+}
+
+QList<QContactLocalId>
+QctMembershipIndex::groups(QContactLocalId memberId) const
+{
+    QCT_SYNCHRONIZED_READ(&m_lock);
+    return m_groupsByMember.value(memberId).toList();
+}
+
+QctMembershipIndex::MembersByGroup
+QctMembershipIndex::memberships() const
+{
+    QCT_SYNCHRONIZED_READ(&m_lock);
+
+    MembersByGroup result;
+
+    for(ContactSetHash::ConstIterator it = m_membersByGroup.constBegin(); it != m_membersByGroup.constEnd(); ++it) {
+        foreach(QContactLocalId memberId, it.value()) {
+            result.insert(it.key(), memberId);
+        }
+    }
+
+    return result;
+}
+
+static bool
+isResolvableRelationshipFilter(const QContactRelationshipFilter &filter, const QString &managerUri)
+{
+    // only HasMember relationships between local groups and local contacts are stored
+    return (filter.relationshipType() == QContactRelationship::HasMember &&
+            filter.relatedContactId().managerUri() == managerUri);
+}
+
+bool
+QctMembershipIndex::isResolvable(const QContactFilter &filter, const QString &managerUri)
+{
+    switch(filter.type()) {
+    case QContactFilter::RelationshipFilter:
+        return isResolvableRelationshipFilter(static_cast<const QContactRelationshipFilter &>(filter),
+                                              managerUri);
+
+    case QContactFilter::IntersectionFilter:
+        foreach(const QContactFilter &childFilter, static_cast<const QContactIntersectionFilter &>(filter).filters()) {
+            if (isResolvable(childFilter, managerUri)) {
+                return true;
+            }
+        }
+
+        return false;
+
+    case QContactFilter::UnionFilter:
+        foreach(const QContactFilter &childFilter, static_cast<const QContactUnionFilter &>(filter).filters()) {
+            if (isResolvable(childFilter, managerUri)) {
+                return true;
+            }
+        }
+
+        return false;
+
+    default:
+        break;
+    }
+
+    return false;
+}
+
+QContactFilter
+QctMembershipIndex::resolveFilter(const QContactFilter &filter, const QString &managerUri,
+                                  int maximumCount) const
+{
+    QCT_SYNCHRONIZED_READ(&m_lock);
+
+    if (not m_populated) {
+        return filter;
+    }
+
+    return resolveFilterImpl(filter, managerUri, maximumCount);
+}
+
+QContactFilter
+QctMembershipIndex::resolveFilterImpl(const QContactFilter &filter, const QString &managerUri,
+                                      int maximumCount) const
+{
+    // caller must hold the read lock
+    switch(filter.type()) {
+    case QContactFilter::RelationshipFilter:
+    {
+        const QContactRelationshipFilter &relationshipFilter =
+                static_cast<const QContactRelationshipFilter &>(filter);
+
+        if (isResolvableRelationshipFilter(relationshipFilter, managerUri)) {
+            const QList<QContactLocalId> contactIds = findContacts(relationshipFilter);
+
+            if (contactIds.isEmpty()) {
+                // a local id filter without any ids is considered invalid
+                return QContactInvalidFilter();
+            }
+
+            if (contactIds.count() <= maximumCount) {
+                QContactLocalIdFilter localIdFilter;
+                localIdFilter.setIds(contactIds);
+                return localIdFilter;
+            }
+        }
+
+        break;
+    }
+
+    case QContactFilter::IntersectionFilter:
+    {
+        QContactIntersectionFilter intersectionFilter;
+
+        foreach(const QContactFilter &childFilter, static_cast<const QContactIntersectionFilter &>(filter).filters()) {
+            intersectionFilter.append(resolveFilterImpl(childFilter, managerUri, maximumCount));
+        }
+
+        return intersectionFilter;
+    }
+
+    case QContactFilter::UnionFilter:
+    {
+        QContactUnionFilter unionFilter;
+
+        foreach(const QContactFilter &childFilter, static_cast<const QContactUnionFilter &>(filter).filters()) {
+            unionFilter.append(resolveFilterImpl(childFilter, managerUri, maximumCount));
+        }
+
+        return unionFilter;
+    }
+
+    default:
+        break;
+    }
+
+    return filter;
+}
+
+QList<QContactLocalId>
+QctMembershipIndex::findContacts(const QContactRelationshipFilter &filter) const
+{
+    // caller must hold the read lock
+    const QContactLocalId relatedContactId = filter.relatedContactId().localId();
+    const QContactRelationship::Role role = filter.relatedContactRole();
+    QSet<QContactLocalId> result;
+
+    // all contacts in a given group?
+    if (role == QContactRelationship::First || role == QContactRelationship::Either) {
+        result += m_membersByGroup.value(relatedContactId);
+    }
+
+    // all groups a given contact is in?
+    if (role == QContactRelationship::Second || role == QContactRelationship::Either) {
+        result += m_groupsByMember.value(relatedContactId);
+    }
+
+    return result.toList();
+}
+
+void
+QctMembershipIndex::clearContacts()
+{
+    m_membersByGroup.clear();
+    m_groupsByMember.clear();
+}
+
+void
+QctMembershipIndex::insertContacts(const MembersByGroup &memberships)
+{
+    for(MembersByGroup::ConstIterator it = memberships.constBegin(); it != memberships.constEnd(); ++it) {
+        insertMembership(it.key(), it.value());
+    }
+}
+
+void
+QctMembershipIndex::insertMembership(QContactLocalId groupId, QContactLocalId memberId)
+{
+    m_membersByGroup[groupId].insert(memberId);
+    m_groupsByMember[memberId].insert(groupId);
+}
+
+void
+QctMembershipIndex::removeContact(QContactLocalId contactId)
+{
+    foreach(QContactLocalId memberId, m_membersByGroup.take(contactId)) {
+        ContactSetHash::Iterator groups = m_groupsByMember.find(memberId);
+
+        if (groups != m_groupsByMember.end()) {
+            groups->remove(contactId);
+
+            if (groups->isEmpty()) {
+                m_groupsByMember.erase(groups);
+            }
+        }
+    }
+
+    foreach(QContactLocalId groupId, m_groupsByMember.take(contactId)) {
+        ContactSetHash::Iterator members = m_membersByGroup.find(groupId);
+
+        if (members != m_membersByGroup.end()) {
+            members->remove(contactId);
+
+            if (members->isEmpty()) {
+                m_membersByGroup.erase(members);
+            }
+        }
+    }
+}
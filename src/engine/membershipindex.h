@@ -0,0 +1,86 @@
+/*********************************************************************************
+ ** This file is part of QtContacts tracker storage plugin
+ **
+ ** Copyright (c) 2011 Nokia Corporation and/or its subsidiary(-ies).
+ **
+ ** Contact:  Nokia Corporation (info@qt.nokia.com)
+ **
+ ** GNU Lesser General Public License Usage
+ ** This file may be used under the terms of the GNU Lesser General Public License
+ ** version 2.1 as published by the Free Software Foundation and appearing in the
+ ** file LICENSE.LGPL included in the packaging of this file.  Please review the
+ ** following information to ensure the GNU Lesser General Public License version
+ ** 2.1 requirements will be met:
+ ** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+ **
+ ** In addition, as a special exception, Nokia gives you certain additional rights.
+ ** These rights are described in the Nokia Qt LGPL Exception version 1.1, included
+ ** in the file LGPL_EXCEPTION.txt in this package.
+ **
+ ** Other Usage
+ ** Alternatively, this file may be used in accordance with the terms and
+ ** conditions contained in a signed written agreement between you and Nokia.
+ *********************************************************************************/
+
+#ifndef QCTMEMBERSHIPINDEX_H
+#define QCTMEMBERSHIPINDEX_H
+
+#include "contactindex.h"
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*!
+ * Maps groups to their members and members to their groups, as stored in nco:belongsToGroup.
+ *
+ * The request workers populate and update the index from the memberships they fetch,
+ * see QctContactIndex for the threading details. Updates replace the memberships of the
+ * stale contacts, no matter if they are the group or the member.
+ */
+class QctMembershipIndex : public QctTypedContactIndex< QMultiHash<QContactLocalId, QContactLocalId> >
+{
+public: // typedefs
+    typedef Data MembersByGroup;
+
+public: // constructors/destructors
+    explicit QctMembershipIndex(QObject *parent = 0);
+    virtual ~QctMembershipIndex();
+
+public: // methods
+    /// Returns the members of the group \p groupId.
+    QList<QContactLocalId> members(QContactLocalId groupId) const;
+
+    /// Returns the groups the contact \p memberId belongs to.
+    QList<QContactLocalId> groups(QContactLocalId memberId) const;
+
+    /// Returns all group memberships.
+    MembersByGroup memberships() const;
+
+    /// Returns \c true if \p filter contains a relationship filter which resolveFilter() can replace.
+    static bool isResolvable(const QContactFilter &filter, const QString &managerUri);
+
+    /// Replaces the HasMember relationship filters within \p filter by local id filters.
+    /// Filters matching more than \p maximumCount contacts are kept.
+    QContactFilter resolveFilter(const QContactFilter &filter, const QString &managerUri,
+                                 int maximumCount) const;
+
+protected: // QctContactIndex methods
+    virtual void clearContacts();
+    virtual void removeContact(QContactLocalId contactId);
+    virtual void insertContacts(const MembersByGroup &memberships);
+
+private: // methods
+    void insertMembership(QContactLocalId groupId, QContactLocalId memberId);
+    QList<QContactLocalId> findContacts(const QContactRelationshipFilter &filter) const;
+    QContactFilter resolveFilterImpl(const QContactFilter &filter, const QString &managerUri,
+                                     int maximumCount) const;
+
+private: // fields
+    typedef QHash<QContactLocalId, QSet<QContactLocalId> > ContactSetHash;
+
+    ContactSetHash m_membersByGroup;
+    ContactSetHash m_groupsByMember;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#endif // QCTMEMBERSHIPINDEX_H
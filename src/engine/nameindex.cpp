@@ -0,0 +1,278 @@
+/*********************************************************************************
+ ** This file is part of QtContacts tracker storage plugin
+ **
+ ** Copyright (c) 2011 Nokia Corporation and/or its subsidiary(-ies).
+ **
+ ** Contact:  Nokia Corporation (info@qt.nokia.com)
+ **
+ ** GNU Lesser General Public License Usage
+ ** This file may be used under the terms of the GNU Lesser General Public License
+ ** version 2.1 as published by the Free Software Foundation and appearing in the
+ ** file LICENSE.LGPL included in the packaging of this file.  Please review the
+ ** following information to ensure the GNU Lesser General Public License version
+ ** 2.1 requirements will be met:
+ ** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+ **
+ ** In addition, as a special exception, Nokia gives you certain additional rights.
+ ** These rights are described in the Nokia Qt LGPL Exception version 1.1, included
+ ** in the file LGPL_EXCEPTION.txt in this package.
+ **
+ ** Other Usage
+ ** Alternatively, this file may be used in accordance with the terms and
+ ** conditions contained in a signed written agreement between you and Nokia.
+ *********************************************************************************/
+
+#include "nameindex.h"
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+QctNameIndex::QctNameIndex(QObject *parent)
+    : QctContactDetailIndex(parent)
+{
+}
+
+QctNameIndex::~QctNameIndex()
+{
+}
+
+QStringList
+QctNameIndex::detailDefinitionNames()
+{
+    return QStringList() << QContactName::DefinitionName
+                         << QContactNickname::DefinitionName
+                         << QContactDisplayLabel::DefinitionName;
+}
+
+QList<QContactLocalId>
+QctNameIndex::lookup(Field field, const QString &prefix) const
+{
+    QCT_SYNCHRONIZED_READ(&m_lock);
+    return findContacts(field, prefix);
+}
+
+static bool
+findNameField(const QContactFilter &filter, bool withDisplayLabels, QctNameIndex::Field &field)
+{
+    if (QContactFilter::ContactDetailFilter != filter.type()) {
+        return false;
+    }
+
+    const QContactDetailFilter &detailFilter = static_cast<const QContactDetailFilter &>(filter);
+
+    // Only case-insensitive prefix matching is covered by the index.
+    if ((detailFilter.matchFlags() & ~QContactFilter::MatchFixedString) != QContactFilter::MatchStartsWith ||
+        QVariant::String != detailFilter.value().type()) {
+        return false;
+    }
+
+    const QString &definitionName = detailFilter.detailDefinitionName();
+    const QString &fieldName = detailFilter.detailFieldName();
+
+    if (QContactName::DefinitionName == definitionName) {
+        if (QContactName::FieldFirstName == fieldName) {
+            field = QctNameIndex::FirstName;
+            return true;
+        }
+
+        if (QContactName::FieldLastName == fieldName) {
+            field = QctNameIndex::LastName;
+            return true;
+        }
+
+        return false;
+    }
+
+    if (QContactNickname::DefinitionName == definitionName) {
+        if (QContactNickname::FieldNickname == fieldName) {
+            field = QctNameIndex::Nickname;
+            return true;
+        }
+
+        return false;
+    }
+
+    if (QContactDisplayLabel::DefinitionName == definitionName && withDisplayLabels) {
+        if (fieldName.isEmpty() || QContactDisplayLabel::FieldLabel == fieldName) {
+            field = QctNameIndex::DisplayLabel;
+            return true;
+        }
+
+        return false;
+    }
+
+    return false;
+}
+
+bool
+QctNameIndex::isResolvable(const QContactFilter &filter, bool withDisplayLabels)
+{
+    Field field;
+
+    switch(filter.type()) {
+    case QContactFilter::ContactDetailFilter:
+        return findNameField(filter, withDisplayLabels, field);
+
+    case QContactFilter::IntersectionFilter:
+        foreach(const QContactFilter &childFilter, static_cast<const QContactIntersectionFilter &>(filter).filters()) {
+            if (isResolvable(childFilter, withDisplayLabels)) {
+                return true;
+            }
+        }
+
+        return false;
+
+    case QContactFilter::UnionFilter:
+        foreach(const QContactFilter &childFilter, static_cast<const QContactUnionFilter &>(filter).filters()) {
+            if (isResolvable(childFilter, withDisplayLabels)) {
+                return true;
+            }
+        }
+
+        return false;
+
+    default:
+        break;
+    }
+
+    return false;
+}
+
+QContactFilter
+QctNameIndex::resolveFilter(const QContactFilter &filter, bool withDisplayLabels,
+                            int maximumCount) const
+{
+    QCT_SYNCHRONIZED_READ(&m_lock);
+
+    if (not m_populated) {
+        return filter;
+    }
+
+    return resolveFilterImpl(filter, withDisplayLabels, maximumCount);
+}
+
+QContactFilter
+QctNameIndex::resolveFilterImpl(const QContactFilter &filter, bool withDisplayLabels,
+                                int maximumCount) const
+{
+    // caller must hold the read lock
+    Field field;
+
+    switch(filter.type()) {
+    case QContactFilter::ContactDetailFilter:
+        if (findNameField(filter, withDisplayLabels, field)) {
+            const QString prefix = static_cast<const QContactDetailFilter &>(filter).value().toString();
+            const QList<QContactLocalId> contactIds = findContacts(field, prefix);
+
+            if (contactIds.isEmpty()) {
+                // a local id filter without any ids is considered invalid
+                return QContactInvalidFilter();
+            }
+
+            if (contactIds.count() <= maximumCount) {
+                QContactLocalIdFilter localIdFilter;
+                localIdFilter.setIds(contactIds);
+                return localIdFilter;
+            }
+        }
+
+        break;
+
+    case QContactFilter::IntersectionFilter:
+    {
+        QContactIntersectionFilter intersectionFilter;
+
+        foreach(const QContactFilter &childFilter, static_cast<const QContactIntersectionFilter &>(filter).filters()) {
+            intersectionFilter.append(resolveFilterImpl(childFilter, withDisplayLabels, maximumCount));
+        }
+
+        return intersectionFilter;
+    }
+
+    case QContactFilter::UnionFilter:
+    {
+        QContactUnionFilter unionFilter;
+
+        foreach(const QContactFilter &childFilter, static_cast<const QContactUnionFilter &>(filter).filters()) {
+            unionFilter.append(resolveFilterImpl(childFilter, withDisplayLabels, maximumCount));
+        }
+
+        return unionFilter;
+    }
+
+    default:
+        break;
+    }
+
+    return filter;
+}
+
+void
+QctNameIndex::clearContacts()
+{
+    for(int i = 0; i < FieldCount; ++i) {
+        m_contactsByName[i].clear();
+    }
+
+    m_namesByContact.clear();
+}
+
+void
+QctNameIndex::insertContact(const QContact &contact)
+{
+    QList<FieldValue> names;
+
+    const QContactName name = contact.detail<QContactName>();
+    names += FieldValue(FirstName, name.firstName());
+    names += FieldValue(LastName, name.lastName());
+
+    foreach(const QContactNickname &nickname, contact.details<QContactNickname>()) {
+        names += FieldValue(Nickname, nickname.nickname());
+    }
+
+    names += FieldValue(DisplayLabel, contact.displayLabel());
+
+    foreach(const FieldValue &value, names) {
+        if (value.second.isEmpty()) {
+            continue;
+        }
+
+        const QString key = value.second.toLower();
+
+        m_contactsByName[value.first].insert(key, contact.localId());
+        m_namesByContact.insert(contact.localId(), FieldValue(value.first, key));
+    }
+}
+
+void
+QctNameIndex::removeContact(QContactLocalId contactId)
+{
+    foreach(const FieldValue &value, m_namesByContact.values(contactId)) {
+        m_contactsByName[value.first].remove(value.second, contactId);
+    }
+
+    m_namesByContact.remove(contactId);
+}
+
+QList<QContactLocalId>
+QctNameIndex::findContacts(Field field, const QString &prefix) const
+{
+    // caller must hold the read lock
+    typedef QMultiMap<QString, QContactLocalId> NameMap;
+
+    const NameMap &names = m_contactsByName[field];
+    const QString key = prefix.toLower();
+
+    QList<QContactLocalId> result;
+    QSet<QContactLocalId> seen;
+
+    // all names starting with the prefix are found in one sequence following the prefix itself
+    for(NameMap::ConstIterator it = names.lowerBound(key);
+        it != names.constEnd() && it.key().startsWith(key); ++it) {
+        if (not seen.contains(it.value())) {
+            seen.insert(it.value());
+            result += it.value();
+        }
+    }
+
+    return result;
+}
@@ -0,0 +1,91 @@
+/*********************************************************************************
+ ** This file is part of QtContacts tracker storage plugin
+ **
+ ** Copyright (c) 2011 Nokia Corporation and/or its subsidiary(-ies).
+ **
+ ** Contact:  Nokia Corporation (info@qt.nokia.com)
+ **
+ ** GNU Lesser General Public License Usage
+ ** This file may be used under the terms of the GNU Lesser General Public License
+ ** version 2.1 as published by the Free Software Foundation and appearing in the
+ ** file LICENSE.LGPL included in the packaging of this file.  Please review the
+ ** following information to ensure the GNU Lesser General Public License version
+ ** 2.1 requirements will be met:
+ ** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+ **
+ ** In addition, as a special exception, Nokia gives you certain additional rights.
+ ** These rights are described in the Nokia Qt LGPL Exception version 1.1, included
+ ** in the file LGPL_EXCEPTION.txt in this package.
+ **
+ ** Other Usage
+ ** Alternatively, this file may be used in accordance with the terms and
+ ** conditions contained in a signed written agreement between you and Nokia.
+ *********************************************************************************/
+
+#ifndef QCTNAMEINDEX_H
+#define QCTNAMEINDEX_H
+
+#include "contactindex.h"
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*!
+ * Maps lower-case first names, last names, nicknames and display labels to the contacts
+ * owning them. The names are kept sorted, so that prefix searches don't have to visit each
+ * contact like fn:starts-with() in tracker does.
+ *
+ * The request workers populate and update the index from the contacts they fetch,
+ * see QctContactIndex for the threading details.
+ */
+class QctNameIndex : public QctContactDetailIndex
+{
+public: // typedefs
+    enum Field {
+        FirstName,
+        LastName,
+        Nickname,
+        DisplayLabel,
+        FieldCount
+    };
+
+public: // constructors/destructors
+    explicit QctNameIndex(QObject *parent = 0);
+    virtual ~QctNameIndex();
+
+public: // attributes
+    /// Returns the details which must be fetched for populate() and update().
+    static QStringList detailDefinitionNames();
+
+public: // methods
+    /// Returns the contacts with a \p field starting with \p prefix, ignoring case.
+    QList<QContactLocalId> lookup(Field field, const QString &prefix) const;
+
+    /// Returns \c true if \p filter contains a detail filter which resolveFilter() can replace.
+    static bool isResolvable(const QContactFilter &filter, bool withDisplayLabels);
+
+    /// Replaces the case-insensitive MatchStartsWith name filters within \p filter by
+    /// local id filters. Filters matching more than \p maximumCount contacts are kept,
+    /// since huge local id filters are slower than scanning the names in tracker.
+    QContactFilter resolveFilter(const QContactFilter &filter, bool withDisplayLabels,
+                                 int maximumCount) const;
+
+protected: // QctContactIndex methods
+    virtual void clearContacts();
+    virtual void removeContact(QContactLocalId contactId);
+    virtual void insertContact(const QContact &contact);
+
+private: // methods
+    QList<QContactLocalId> findContacts(Field field, const QString &prefix) const;
+    QContactFilter resolveFilterImpl(const QContactFilter &filter, bool withDisplayLabels,
+                                     int maximumCount) const;
+
+private: // fields
+    typedef QPair<int, QString> FieldValue;
+
+    QMultiMap<QString, QContactLocalId> m_contactsByName[FieldCount];
+    QMultiHash<QContactLocalId, FieldValue> m_namesByContact;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#endif // QCTNAMEINDEX_H
@@ -0,0 +1,77 @@
+/*********************************************************************************
+ ** This file is part of QtContacts tracker storage plugin
+ **
+ ** Copyright (c) 2011 Nokia Corporation and/or its subsidiary(-ies).
+ **
+ ** Contact:  Nokia Corporation (info@qt.nokia.com)
+ **
+ ** GNU Lesser General Public License Usage
+ ** This file may be used under the terms of the GNU Lesser General Public License
+ ** version 2.1 as published by the Free Software Foundation and appearing in the
+ ** file LICENSE.LGPL included in the packaging of this file.  Please review the
+ ** following information to ensure the GNU Lesser General Public License version
+ ** 2.1 requirements will be met:
+ ** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+ **
+ ** In addition, as a special exception, Nokia gives you certain additional rights.
+ ** These rights are described in the Nokia Qt LGPL Exception version 1.1, included
+ ** in the file LGPL_EXCEPTION.txt in this package.
+ **
+ ** Other Usage
+ ** Alternatively, this file may be used in accordance with the terms and
+ ** conditions contained in a signed written agreement between you and Nokia.
+ *********************************************************************************/
+
+#include "phonenumberindex.h"
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+QctPhoneNumberIndex::QctPhoneNumberIndex(QObject *parent)
+    : QctTypedContactIndex<NumbersByContact>(ContactChanges, parent)
+{
+}
+
+QctPhoneNumberIndex::~QctPhoneNumberIndex()
+{
+}
+
+QList<QContactLocalId>
+QctPhoneNumberIndex::lookup(const QString &localNumber) const
+{
+    QCT_SYNCHRONIZED_READ(&m_lock);
+
+    QList<QContactLocalId> result = m_contactsByNumber.values(localNumber);
+
+    // a contact can have the same number in several affiliations
+    if (result.count() > 1) {
+        result = result.toSet().toList();
+    }
+
+    return result;
+}
+
+void
+QctPhoneNumberIndex::clearContacts()
+{
+    m_contactsByNumber.clear();
+    m_numbersByContact.clear();
+}
+
+void
+QctPhoneNumberIndex::removeContact(QContactLocalId contactId)
+{
+    foreach(const QString &number, m_numbersByContact.values(contactId)) {
+        m_contactsByNumber.remove(number, contactId);
+    }
+
+    m_numbersByContact.remove(contactId);
+}
+
+void
+QctPhoneNumberIndex::insertContacts(const NumbersByContact &numbers)
+{
+    for(NumbersByContact::ConstIterator it = numbers.constBegin(); it != numbers.constEnd(); ++it) {
+        m_numbersByContact.insert(it.key(), it.value());
+        m_contactsByNumber.insert(it.value(), it.key());
+    }
+}
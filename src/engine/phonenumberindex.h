@@ -0,0 +1,63 @@
+/*********************************************************************************
+ ** This file is part of QtContacts tracker storage plugin
+ **
+ ** Copyright (c) 2011 Nokia Corporation and/or its subsidiary(-ies).
+ **
+ ** Contact:  Nokia Corporation (info@qt.nokia.com)
+ **
+ ** GNU Lesser General Public License Usage
+ ** This file may be used under the terms of the GNU Lesser General Public License
+ ** version 2.1 as published by the Free Software Foundation and appearing in the
+ ** file LICENSE.LGPL included in the packaging of this file.  Please review the
+ ** following information to ensure the GNU Lesser General Public License version
+ ** 2.1 requirements will be met:
+ ** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+ **
+ ** In addition, as a special exception, Nokia gives you certain additional rights.
+ ** These rights are described in the Nokia Qt LGPL Exception version 1.1, included
+ ** in the file LGPL_EXCEPTION.txt in this package.
+ **
+ ** Other Usage
+ ** Alternatively, this file may be used in accordance with the terms and
+ ** conditions contained in a signed written agreement between you and Nokia.
+ *********************************************************************************/
+
+#ifndef QCTPHONENUMBERINDEX_H
+#define QCTPHONENUMBERINDEX_H
+
+#include "contactindex.h"
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*!
+ * Maps local phone numbers, as stored in maemo:localPhoneNumber, to the contacts owning them.
+ *
+ * The index gets populated and updated from the local phone numbers fetched by
+ * QTrackerPhoneNumberMatchRequest, see QctContactIndex for the threading details.
+ */
+class QctPhoneNumberIndex : public QctTypedContactIndex< QMultiHash<QContactLocalId, QString> >
+{
+public: // typedefs
+    typedef Data NumbersByContact;
+
+public: // constructors/destructors
+    explicit QctPhoneNumberIndex(QObject *parent = 0);
+    virtual ~QctPhoneNumberIndex();
+
+public: // methods
+    /// Returns the contacts owning a phone number with the local phone number \p localNumber.
+    QList<QContactLocalId> lookup(const QString &localNumber) const;
+
+protected: // QctContactIndex methods
+    virtual void clearContacts();
+    virtual void removeContact(QContactLocalId contactId);
+    virtual void insertContacts(const NumbersByContact &numbers);
+
+private: // fields
+    QMultiHash<QString, QContactLocalId> m_contactsByNumber;
+    NumbersByContact m_numbersByContact;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#endif // QCTPHONENUMBERINDEX_H
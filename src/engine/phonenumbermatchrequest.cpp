@@ -0,0 +1,150 @@
+/*********************************************************************************
+ ** This file is part of QtContacts tracker storage plugin
+ **
+ ** Copyright (c) 2011 Nokia Corporation and/or its subsidiary(-ies).
+ **
+ ** Contact:  Nokia Corporation (info@qt.nokia.com)
+ **
+ ** GNU Lesser General Public License Usage
+ ** This file may be used under the terms of the GNU Lesser General Public License
+ ** version 2.1 as published by the Free Software Foundation and appearing in the
+ ** file LICENSE.LGPL included in the packaging of this file.  Please review the
+ ** following information to ensure the GNU Lesser General Public License version
+ ** 2.1 requirements will be met:
+ ** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+ **
+ ** In addition, as a special exception, Nokia gives you certain additional rights.
+ ** These rights are described in the Nokia Qt LGPL Exception version 1.1, included
+ ** in the file LGPL_EXCEPTION.txt in this package.
+ **
+ ** Other Usage
+ ** Alternatively, this file may be used in accordance with the terms and
+ ** conditions contained in a signed written agreement between you and Nokia.
+ *********************************************************************************/
+
+#include "phonenumbermatchrequest.h"
+
+#include "engine.h"
+
+#include <lib/phonenumbermatchrequest.h>
+#include <lib/phoneutils.h>
+
+#include <ontologies/maemo.h>
+#include <ontologies/nco.h>
+#include <ontologies/rdf.h>
+
+#include <QtSparql>
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+CUBI_USE_NAMESPACE
+CUBI_USE_NAMESPACE_RESOURCES
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+QTrackerPhoneNumberMatchRequest::QTrackerPhoneNumberMatchRequest(QContactAbstractRequest *request,
+                                                                 QContactTrackerEngine *engine,
+                                                                 QObject *parent)
+    : QTrackerBaseRequest<QctPhoneNumberMatchRequest>(engine, parent)
+    , m_phoneNumber(staticCast(request)->phoneNumber())
+    , m_index(engine->phoneNumberIndex())
+{
+}
+
+QTrackerPhoneNumberMatchRequest::~QTrackerPhoneNumberMatchRequest()
+{
+}
+
+QString
+QTrackerPhoneNumberMatchRequest::buildQuery(const QList<QContactLocalId> &contactIds) const
+{
+    static const ValueChain phoneNumberChain = ValueChain() << nco::hasAffiliation::resource()
+                                                            << nco::hasPhoneNumber::resource();
+
+    const Variable contact(QLatin1String("contact"));
+    const Variable phoneNumber(QLatin1String("phoneNumber"));
+    const Variable localNumber(QLatin1String("localNumber"));
+
+    Select select;
+
+    select.addProjection(Functions::trackerId.apply(contact));
+    select.addProjection(localNumber);
+
+    // Only consider real contacts, and ignore the nco:Contact instances call-ui and
+    // commhistory create for unknown callers.
+    select.addRestriction(contact, rdf::type::resource(), nco::PersonContact::resource());
+    select.addRestriction(contact, phoneNumberChain, phoneNumber);
+    select.addRestriction(phoneNumber, maemo::localPhoneNumber::resource(), localNumber);
+
+    if (not contactIds.isEmpty()) {
+        ValueList ids;
+
+        foreach(QContactLocalId id, contactIds) {
+            ids.addValue(LiteralValue(qVariantFromValue(id)));
+        }
+
+        select.setFilter(Functions::in.apply(Functions::trackerId.apply(contact), ids));
+    }
+
+    return select.sparql(engine()->selectQueryOptions());
+}
+
+bool
+QTrackerPhoneNumberMatchRequest::fetchNumbers(const QList<QContactLocalId> &contactIds,
+                                              QctPhoneNumberIndex::NumbersByContact &numbers)
+{
+    const QSparqlQuery query(buildQuery(contactIds));
+    QScopedPointer<QSparqlResult> result(runQuery(query, SyncQueryOptions));
+
+    if (result.isNull()) {
+        return false; // runQuery() called reportError()
+    }
+
+    while(result->next()) {
+        const QContactLocalId id = result->value(0).toUInt();
+        const QString localNumber = result->stringValue(1);
+
+        if (0 != id && not localNumber.isEmpty()) {
+            numbers.insert(id, localNumber);
+        }
+    }
+
+    return true;
+}
+
+void
+QTrackerPhoneNumberMatchRequest::run()
+{
+    if (m_phoneNumber.isEmpty()) {
+        setLastError(QContactManager::BadArgumentError);
+        return;
+    }
+
+    if (not refreshIndex(m_index, &QTrackerPhoneNumberMatchRequest::fetchNumbers) || isCanceled()) {
+        return;
+    }
+
+    m_localIds = m_index->lookup(qctMakeLocalPhoneNumber(m_phoneNumber));
+
+    // Like bindDTMFNumberFilter() fall back to the number without DTMF codes
+    // if there was no exact match.
+    if (m_localIds.isEmpty()) {
+        const int dtmfIndex = m_phoneNumber.indexOf(qctPhoneNumberDTMFChars());
+
+        if (dtmfIndex > 0) {
+            m_localIds = m_index->lookup(qctMakeLocalPhoneNumber(m_phoneNumber.left(dtmfIndex)));
+        }
+    }
+}
+
+void
+QTrackerPhoneNumberMatchRequest::updateRequest(QContactManager::Error error)
+{
+    engine()->updateContactLocalIdFetchRequest(staticCast(engine()->request(this).data()),
+                                               m_localIds, error,
+                                               QContactAbstractRequest::FinishedState);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "moc_phonenumbermatchrequest.cpp"
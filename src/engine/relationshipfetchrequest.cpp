@@ -25,6 +25,7 @@
 #include "relationshipfetchrequest.h"
 
 #include "engine/engine.h"
+#include "engine/membershipindex.h"
 
 #include <QtSparql>
 
@@ -79,6 +80,13 @@ QTrackerRelationshipFetchRequest::run()
         setLastError(QContactManager::NotSupportedError);
     }
 
+    QctMembershipIndex *const index = membershipIndex();
+
+    if (0 != index && refreshMembershipIndex(index)) {
+        lookupRelationships(index);
+        return;
+    }
+
     QString queryString = requestTemplatePrefix;
 
     // define group by id if given
@@ -131,6 +139,45 @@ QTrackerRelationshipFetchRequest::run()
     }
 }
 
+void
+QTrackerRelationshipFetchRequest::lookupRelationships(const QctMembershipIndex *index)
+{
+    QctMembershipIndex::MembersByGroup memberships;
+
+    if (m_firstContactId != QContactId()) {
+        foreach(QContactLocalId memberId, index->members(m_firstContactId.localId())) {
+            memberships.insert(m_firstContactId.localId(), memberId);
+        }
+    } else if (m_secondContactId != QContactId()) {
+        foreach(QContactLocalId groupId, index->groups(m_secondContactId.localId())) {
+            memberships.insert(groupId, m_secondContactId.localId());
+        }
+    } else {
+        memberships = index->memberships();
+    }
+
+    QContactId contactId;
+    contactId.setManagerUri(engine()->managerUri());
+
+    QContactRelationship relationship;
+    relationship.setRelationshipType(QContactRelationship::HasMember);
+
+    for(QctMembershipIndex::MembersByGroup::ConstIterator it = memberships.constBegin();
+        it != memberships.constEnd(); ++it) {
+        // both contacts given: only report that single relationship
+        if (m_secondContactId != QContactId() && it.value() != m_secondContactId.localId()) {
+            continue;
+        }
+
+        contactId.setLocalId(it.key());
+        relationship.setFirst(contactId);
+
+        contactId.setLocalId(it.value());
+        relationship.setSecond(contactId);
+
+        m_relationships.append(relationship);
+    }
+}
 
 void
 QTrackerRelationshipFetchRequest::updateRequest(QContactManager::Error error)
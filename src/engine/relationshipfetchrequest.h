@@ -29,6 +29,10 @@
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+class QctMembershipIndex;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 class QTrackerRelationshipFetchRequest: public QTrackerBaseRequest<QContactRelationshipFetchRequest>
 {
     Q_DISABLE_COPY(QTrackerRelationshipFetchRequest)
@@ -44,6 +48,9 @@ protected: // QTrackerAbstractRequest API
     void run();
     void updateRequest(QContactManager::Error error);
 
+private: // methods
+    void lookupRelationships(const QctMembershipIndex *index);
+
 private: // fields
     const QContactId m_firstContactId;
     const QContactId m_secondContactId;
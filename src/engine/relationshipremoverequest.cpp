@@ -25,6 +25,8 @@
 #include "relationshipremoverequest.h"
 
 #include <engine/engine.h>
+#include <engine/membershipindex.h>
+#include <lib/sparqlresolver.h>
 
 #include <QtSparql>
 
@@ -50,10 +52,10 @@ QTrackerRelationshipRemoveRequest::buildQuery()
              "  ?c nco:belongsToGroup ?g\n"
              "} WHERE {\n"
              "  ?g a nco:Contact FILTER(tracker:id(?g) = %1).\n"
-             "  ?c a nco:Contact FILTER(tracker:id(?c) = %2).\n"
+             "  ?c a nco:Contact FILTER(tracker:id(?c) IN (%2)).\n"
              "}\n");
 
-    QStringList queries;
+    QMap<QContactLocalId, QList<QContactLocalId> > membersByGroup;
 
     const QString managerUri = engine()->managerUri();
 
@@ -86,8 +88,26 @@ QTrackerRelationshipRemoveRequest::buildQuery()
             continue;
         }
 
-        queries.append(queryTemplate.arg(QString::number(firstContactId.localId()),
-                                         QString::number(secondContactId.localId())));
+        membersByGroup[firstContactId.localId()].append(secondContactId.localId());
+        m_affectedContactIds << firstContactId.localId() << secondContactId.localId();
+    }
+
+    QStringList queries;
+
+    for(QMap<QContactLocalId, QList<QContactLocalId> >::ConstIterator it = membersByGroup.constBegin();
+        it != membersByGroup.constEnd(); ++it) {
+        const QString groupId = QString::number(it.key());
+
+        // split the member list to avoid "Too many SQL variables" errors
+        for(int i = 0; i < it->count(); i += QctSparqlResolver::ColumnLimit) {
+            QStringList memberIds;
+
+            foreach(QContactLocalId memberId, it->mid(i, QctSparqlResolver::ColumnLimit)) {
+                memberIds += QString::number(memberId);
+            }
+
+            queries.append(queryTemplate.arg(groupId, memberIds.join(QLatin1String(", "))));
+        }
     }
 
     if (not m_errorMap.isEmpty()) {
@@ -117,7 +137,14 @@ QTrackerRelationshipRemoveRequest::run()
 
     const QString queryString = buildQuery();
     if (not queryString.isEmpty()) {
-        delete runQuery(QSparqlQuery(buildQuery(), QSparqlQuery::DeleteStatement), SyncQueryOptions);
+        QScopedPointer<QSparqlResult> result(runQuery(QSparqlQuery(queryString, QSparqlQuery::DeleteStatement),
+                                                      SyncQueryOptions));
+        QctMembershipIndex *const index = membershipIndex();
+
+        // don't wait for the change listener, the next fetch must not see the removed memberships
+        if (not result.isNull() && 0 != index) {
+            index->markStale(m_affectedContactIds.toList());
+        }
     }
 }
 
@@ -50,6 +50,7 @@ private: // methods
 private: // fields
     const QList<QContactRelationship> m_relationships;
     ErrorMap m_errorMap;
+    QSet<QContactLocalId> m_affectedContactIds;
 };
 
 #endif /* QTRACKERRELATIONSHIPREMOVEREQUEST_H_ */
@@ -25,7 +25,9 @@
 #include "relationshipsaverequest.h"
 
 #include <engine/engine.h>
+#include <engine/membershipindex.h>
 #include <lib/constants.h>
+#include <lib/sparqlresolver.h>
 
 #include <QtSparql>
 
@@ -51,6 +53,8 @@ QTrackerRelationshipSaveRequest::run()
         return;
     }
 
+    // Members get added to each group with set-based statements instead of one statement
+    // per relationship, which would have to scan all contacts for each single member.
     static const QString sparqlTemplate = QLatin1String
             ("INSERT {\n"
              "  GRAPH <%3> {\n"
@@ -58,14 +62,12 @@ QTrackerRelationshipSaveRequest::run()
              "  }\n"
              "}\n"
              "WHERE {\n"
-             "  ?member a nco:Contact . ?group a nco:Contact .\n"
-             "  FILTER(%1=tracker:id(?member) && %2=tracker:id(?group))\n"
+             "  ?group a nco:Contact FILTER(tracker:id(?group) = %1) .\n"
+             "  ?member a nco:Contact FILTER(tracker:id(?member) IN (%2)) .\n"
              "}\n");
 
-    QString queryString;
-
-    static const int digitsPerUInt = log(UINT_MAX) / log(10);
-    queryString.reserve((sparqlTemplate.length() + 2 * digitsPerUInt) * m_relationships.length());
+    QMap<QContactLocalId, QList<QContactLocalId> > membersByGroup;
+    QSet<QContactLocalId> affectedContactIds;
 
     // TODO: support saving of foreign relationships
     for (int i = 0; i < m_relationships.length(); ++i) {
@@ -106,13 +108,38 @@ QTrackerRelationshipSaveRequest::run()
             continue;
         }
 
-        queryString += sparqlTemplate.arg(QString::number(secondContactId.localId()),
-                                          QString::number(firstContactId.localId()),
-                                          QtContactsTrackerDefaultGraphIri);
+        membersByGroup[firstContactId.localId()].append(secondContactId.localId());
+        affectedContactIds << firstContactId.localId() << secondContactId.localId();
+    }
+
+    QString queryString;
+
+    for(QMap<QContactLocalId, QList<QContactLocalId> >::ConstIterator it = membersByGroup.constBegin();
+        it != membersByGroup.constEnd(); ++it) {
+        const QString groupId = QString::number(it.key());
+
+        // split the member list to avoid "Too many SQL variables" errors
+        for(int i = 0; i < it->count(); i += QctSparqlResolver::ColumnLimit) {
+            QStringList memberIds;
+
+            foreach(QContactLocalId memberId, it->mid(i, QctSparqlResolver::ColumnLimit)) {
+                memberIds += QString::number(memberId);
+            }
+
+            queryString += sparqlTemplate.arg(groupId, memberIds.join(QLatin1String(", ")),
+                                              QtContactsTrackerDefaultGraphIri);
+        }
     }
 
     if (not queryString.isEmpty()) {
-        delete runQuery(QSparqlQuery(queryString, QSparqlQuery::InsertStatement), SyncQueryOptions);
+        QScopedPointer<QSparqlResult> result(runQuery(QSparqlQuery(queryString, QSparqlQuery::InsertStatement),
+                                                      SyncQueryOptions));
+        QctMembershipIndex *const index = membershipIndex();
+
+        // don't wait for the change listener, the next fetch must see the new memberships
+        if (not result.isNull() && 0 != index) {
+            index->markStale(affectedContactIds.toList());
+        }
     } else if (not m_errorMap.empty()) {
         setLastError((m_errorMap.constEnd() - 1).value());
     }
@@ -110,6 +110,18 @@ QctRequestTask::QctRequestTask(QContactAbstractRequest *request,
     // the worker into the proper thread when the task is run by the task queue.
     m_worker->setParent(this);
 
+    switch(m_worker->priority()) {
+    case QctRequestExtensions::LowPriority:
+        setPriority(LowPriority);
+        break;
+    case QctRequestExtensions::NormalPriority:
+        setPriority(NormalPriority);
+        break;
+    case QctRequestExtensions::HighPriority:
+        setPriority(HighPriority);
+        break;
+    }
+
     connect(request, SIGNAL(stateChanged(QContactAbstractRequest::State)),
             this, SLOT(onStateChanged(QContactAbstractRequest::State)), Qt::DirectConnection);
     connect(request, SIGNAL(destroyed()),
@@ -0,0 +1,131 @@
+/*********************************************************************************
+ ** This file is part of QtContacts tracker storage plugin
+ **
+ ** Copyright (c) 2011 Nokia Corporation and/or its subsidiary(-ies).
+ **
+ ** Contact:  Nokia Corporation (info@qt.nokia.com)
+ **
+ ** GNU Lesser General Public License Usage
+ ** This file may be used under the terms of the GNU Lesser General Public License
+ ** version 2.1 as published by the Free Software Foundation and appearing in the
+ ** file LICENSE.LGPL included in the packaging of this file.  Please review the
+ ** following information to ensure the GNU Lesser General Public License version
+ ** 2.1 requirements will be met:
+ ** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+ **
+ ** In addition, as a special exception, Nokia gives you certain additional rights.
+ ** These rights are described in the Nokia Qt LGPL Exception version 1.1, included
+ ** in the file LGPL_EXCEPTION.txt in this package.
+ **
+ ** Other Usage
+ ** Alternatively, this file may be used in accordance with the terms and
+ ** conditions contained in a signed written agreement between you and Nokia.
+ *********************************************************************************/
+
+#include "tombstones.h"
+
+#include <lib/constants.h>
+
+#include <cubi.h>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+CUBI_USE_NAMESPACE
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+const QString &
+QctTombstones::iriPrefix()
+{
+    static const QString prefix = QLatin1String("urn:x-maemo-contacts-tombstone:");
+    return prefix;
+}
+
+QContactLocalId
+QctTombstones::parseIri(const QString &iri)
+{
+    if (not iri.startsWith(iriPrefix())) {
+        return 0;
+    }
+
+    return iri.mid(iriPrefix().length()).toUInt();
+}
+
+QString
+QctTombstones::buildPruneQuery(int retentionDays)
+{
+    static const QString queryTemplate = QLatin1String
+            ("DELETE {\n"
+             "  ?tombstone a rdfs:Resource\n"
+             "} WHERE {\n"
+             "  GRAPH <%1> {\n"
+             "    ?tombstone a nie:InformationElement ; nie:contentLastModified ?removed\n"
+             "  }\n"
+             "  FILTER(?removed < %2)\n"
+             "}\n");
+
+    const QDateTime expired = QDateTime::currentDateTimeUtc().addDays(-retentionDays);
+    return queryTemplate.arg(QtContactsTrackerTombstoneGraphIri, LiteralValue(expired).sparql());
+}
+
+QString
+QctTombstones::buildRecordQuery(const QList<QContactLocalId> &contactIds)
+{
+    // Only ids of existing contacts get tombstones, so that removing some bogus id neither
+    // records a tombstone, nor drops the tombstone of a contact removed earlier. The old
+    // tombstone must be dropped since nie:contentLastModified only permits a single value.
+    // Contacts created by other applications might lack a GUID, so it is optional.
+    static const QString queryTemplate = QLatin1String
+            ("DELETE {\n"
+             "  ?tombstone a rdfs:Resource\n"
+             "} WHERE {\n"
+             "  ?contact rdf:type nco:Contact .\n"
+             "  FILTER(tracker:id(?contact) IN (%2))\n"
+             "  GRAPH <%1> {\n"
+             "    ?tombstone a nie:InformationElement\n"
+             "  }\n"
+             "  FILTER(str(?tombstone) = fn:concat(\"%3\", tracker:id(?contact)))\n"
+             "}\n"
+             "INSERT {\n"
+             "  GRAPH <%1> {\n"
+             "    ?tombstone a nie:InformationElement ;\n"
+             "               nie:contentLastModified %4 ;\n"
+             "               nie:identifier ?guid .\n"
+             "  }\n"
+             "} WHERE {\n"
+             "  ?contact rdf:type nco:Contact .\n"
+             "  FILTER(tracker:id(?contact) IN (%2))\n"
+             "  OPTIONAL { ?contact nco:contactUID ?guid }\n"
+             "  BIND(fn:concat(\"%3\", tracker:id(?contact)) AS ?tombstone)\n"
+             "}\n");
+
+    if (contactIds.isEmpty()) {
+        return QString();
+    }
+
+    QStringList idStrings;
+
+    foreach(QContactLocalId id, contactIds) {
+        idStrings += QString::number(id);
+    }
+
+    const QString removed = LiteralValue(QDateTime::currentDateTimeUtc()).sparql();
+
+    return queryTemplate.arg(QtContactsTrackerTombstoneGraphIri,
+                             idStrings.join(QLatin1String(",")),
+                             iriPrefix(), removed);
+}
+
+QString
+QctTombstones::buildFetchQuery(const QDateTime &since)
+{
+    static const QString queryTemplate = QLatin1String
+            ("SELECT ?tombstone WHERE {\n"
+             "  GRAPH <%1> {\n"
+             "    ?tombstone a nie:InformationElement ; nie:contentLastModified ?removed\n"
+             "  }\n"
+             "  FILTER(?removed >= %2)\n"
+             "}\n");
+
+    return queryTemplate.arg(QtContactsTrackerTombstoneGraphIri, LiteralValue(since).sparql());
+}
@@ -0,0 +1,67 @@
+/*********************************************************************************
+ ** This file is part of QtContacts tracker storage plugin
+ **
+ ** Copyright (c) 2011 Nokia Corporation and/or its subsidiary(-ies).
+ **
+ ** Contact:  Nokia Corporation (info@qt.nokia.com)
+ **
+ ** GNU Lesser General Public License Usage
+ ** This file may be used under the terms of the GNU Lesser General Public License
+ ** version 2.1 as published by the Free Software Foundation and appearing in the
+ ** file LICENSE.LGPL included in the packaging of this file.  Please review the
+ ** following information to ensure the GNU Lesser General Public License version
+ ** 2.1 requirements will be met:
+ ** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+ **
+ ** In addition, as a special exception, Nokia gives you certain additional rights.
+ ** These rights are described in the Nokia Qt LGPL Exception version 1.1, included
+ ** in the file LGPL_EXCEPTION.txt in this package.
+ **
+ ** Other Usage
+ ** Alternatively, this file may be used in accordance with the terms and
+ ** conditions contained in a signed written agreement between you and Nokia.
+ *********************************************************************************/
+
+#ifndef QCTTOMBSTONES_H
+#define QCTTOMBSTONES_H
+
+#include <qtcontacts.h>
+
+QTM_USE_NAMESPACE
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*!
+ * Builds the queries which remember removed contacts, so that delta sync clients can ask
+ * for them with a QContactChangeLogFilter::EventRemoved filter.
+ *
+ * A tombstone is a nie:InformationElement in its own graph. Its IRI carries the local id of
+ * the removed contact, nie:identifier its GUID and nie:contentLastModified the time of
+ * removal. Tombstones are only written when the "tombstone-retention" engine parameter is
+ * set, and each update recording tombstones also drops the ones older than the retention period.
+ */
+class QctTombstones
+{
+public: // methods
+    /// Returns the SPARQL update dropping the tombstones older than \p retentionDays.
+    static QString buildPruneQuery(int retentionDays);
+
+    /// Returns the SPARQL update recording tombstones for the contacts in \p contactIds.
+    /// It must run in the same update, but before the contacts get deleted. The ids are
+    /// matched in a single statement, so they must be split into chunks no longer than
+    /// QctSparqlResolver::ColumnLimit.
+    static QString buildRecordQuery(const QList<QContactLocalId> &contactIds);
+
+    /// Returns the SPARQL query selecting all tombstones recorded at or after \p since.
+    static QString buildFetchQuery(const QDateTime &since);
+
+    /// Returns the local id encoded in the tombstone IRI \p iri, or 0 if it isn't one.
+    static QContactLocalId parseIri(const QString &iri);
+
+private: // methods
+    static const QString & iriPrefix();
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#endif // QCTTOMBSTONES_H
@@ -0,0 +1,504 @@
+/*********************************************************************************
+ ** This file is part of QtContacts tracker storage plugin
+ **
+ ** Copyright (c) 2010-2011 Nokia Corporation and/or its subsidiary(-ies).
+ **
+ ** Contact:  Nokia Corporation (info@qt.nokia.com)
+ **
+ ** GNU Lesser General Public License Usage
+ ** This file may be used under the terms of the GNU Lesser General Public License
+ ** version 2.1 as published by the Free Software Foundation and appearing in the
+ ** file LICENSE.LGPL included in the packaging of this file.  Please review the
+ ** following information to ensure the GNU Lesser General Public License version
+ ** 2.1 requirements will be met:
+ ** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+ **
+ ** In addition, as a special exception, Nokia gives you certain additional rights.
+ ** These rights are described in the Nokia Qt LGPL Exception version 1.1, included
+ ** in the file LGPL_EXCEPTION.txt in this package.
+ **
+ ** Other Usage
+ ** Alternatively, this file may be used in accordance with the terms and
+ ** conditions contained in a signed written agreement between you and Nokia.
+ *********************************************************************************/
+
+#include "avatarpack_p.h"
+
+#include "fileutils.h"
+#include "logger.h"
+
+#include <errno.h>
+#include <string.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <QDir>
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+class QctDefaultAvatarPack : public QctAvatarPack
+{
+public:
+    QctDefaultAvatarPack()
+        : QctAvatarPack(qctAvatarLocalDataDir().absoluteFilePath(QLatin1String("avatars.pack")))
+    {
+    }
+};
+
+Q_GLOBAL_STATIC(QctDefaultAvatarPack, defaultAvatarPack)
+
+const char QctAvatarPack::FileMagic[8] = { 'Q', 'C', 'T', 'A', 'V', 'P', 'K', '1' };
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+static quint64
+inodeOfPath(const QString &fileName)
+{
+    struct stat info;
+
+    if (0 != ::stat(QFile::encodeName(fileName).constData(), &info)) {
+        return 0;
+    }
+
+    return info.st_ino;
+}
+
+static quint64
+inodeOfFile(const QFile &file)
+{
+    struct stat info;
+
+    if (0 != ::fstat(file.handle(), &info)) {
+        return 0;
+    }
+
+    return info.st_ino;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+QctAvatarPack::QctAvatarPack(const QString &fileName)
+    : m_fileName(fileName)
+    , m_data(0)
+    , m_mappedSize(0)
+    , m_scannedSize(0)
+    , m_inode(0)
+{
+}
+
+QctAvatarPack::~QctAvatarPack()
+{
+    reset();
+}
+
+QctAvatarPack *
+QctAvatarPack::instance()
+{
+    return defaultAvatarPack();
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+void
+QctAvatarPack::reset()
+{
+    if (m_data) {
+        m_file.unmap(m_data);
+        m_data = 0;
+    }
+
+    m_file.close();
+    m_mappedSize = 0;
+    m_scannedSize = 0;
+    m_inode = 0;
+    m_records.clear();
+}
+
+/// Maps records appended since the last call, and drops the index if the pack file
+/// got replaced by compaction. Must be called with the write lock held.
+void
+QctAvatarPack::refresh()
+{
+    const quint64 inode = inodeOfPath(m_fileName);
+
+    if (0 == inode) {
+        reset();
+        return;
+    }
+
+    if (m_file.isOpen() && inode != m_inode) {
+        reset();
+    }
+
+    if (not m_file.isOpen()) {
+        m_file.setFileName(m_fileName);
+
+        if (not m_file.open(QFile::ReadOnly)) {
+            qctWarn(QString::fromLatin1("Cannot open avatar pack %1: %2").
+                    arg(m_fileName, m_file.errorString()));
+            return;
+        }
+
+        m_inode = inodeOfFile(m_file);
+    }
+
+    const qint64 fileSize = m_file.size();
+
+    if (fileSize == m_mappedSize) {
+        return;
+    }
+
+    // Appending writers truncate incomplete records, but never complete ones.
+    if (fileSize < m_scannedSize) {
+        qctWarn(QString::fromLatin1("Avatar pack %1 was truncated unexpectedly").arg(m_fileName));
+        reset();
+        refresh();
+        return;
+    }
+
+    if (m_data) {
+        m_file.unmap(m_data);
+        m_data = 0;
+        m_mappedSize = 0;
+    }
+
+    m_data = m_file.map(0, fileSize);
+
+    if (0 == m_data) {
+        qctWarn(QString::fromLatin1("Cannot map avatar pack %1: %2").
+                arg(m_fileName, m_file.errorString()));
+        reset();
+        return;
+    }
+
+    m_mappedSize = fileSize;
+
+    if (0 == m_scannedSize) {
+        if (m_mappedSize < qint64(sizeof FileMagic)) {
+            return; // some writer is still busy with the file header
+        }
+
+        if (0 != memcmp(m_data, FileMagic, sizeof FileMagic)) {
+            qctWarn(QString::fromLatin1("Ignoring avatar pack %1 of unknown format").
+                    arg(m_fileName));
+            return;
+        }
+
+        m_scannedSize = sizeof FileMagic;
+    }
+
+    // Index all complete records. Incomplete records are either still written by
+    // some other process, or got left behind by a crashed writer.
+    while (m_scannedSize + qint64(sizeof(RecordHeader)) <= m_mappedSize) {
+        RecordHeader header;
+        memcpy(&header, m_data + m_scannedSize, sizeof header);
+
+        if (RecordMagic != header.magic) {
+            qctWarn(QString::fromLatin1("Corrupt record at offset %1 of avatar pack %2").
+                    arg(QString::number(m_scannedSize), m_fileName));
+            break;
+        }
+
+        const qint64 dataOffset = m_scannedSize + sizeof header;
+
+        if (dataOffset + header.length > m_mappedSize) {
+            break;
+        }
+
+        m_records.insert(QString::fromLatin1(header.hash, HashLength),
+                         Record(dataOffset, header.length));
+        m_scannedSize = dataOffset + header.length;
+    }
+}
+
+/// Opens @p file for appending and locks it against other writers. Compaction might
+/// replace the pack file while waiting for the lock, so retry until the locked file
+/// really is the current pack file.
+bool
+QctAvatarPack::lockForAppending(QFile &file, QFile::FileError *error)
+{
+    forever {
+        if (not file.open(QFile::WriteOnly | QFile::Append | QFile::Unbuffered)) {
+            qctWarn(QString::fromLatin1("Cannot open avatar pack %1: %2").
+                    arg(m_fileName, file.errorString()));
+
+            if (error) {
+                *error = file.error();
+            }
+
+            return false;
+        }
+
+        if (0 != ::flock(file.handle(), LOCK_EX)) {
+            qctWarn(QString::fromLatin1("Cannot lock avatar pack %1: %2").
+                    arg(m_fileName, QString::fromLocal8Bit(strerror(errno))));
+
+            if (error) {
+                *error = QFile::UnspecifiedError;
+            }
+
+            return false;
+        }
+
+        if (inodeOfFile(file) == inodeOfPath(m_fileName)) {
+            return true;
+        }
+
+        file.close();
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool
+QctAvatarPack::contains(const QString &hash)
+{
+    {
+        QReadLocker locker(&m_lock);
+
+        if (m_records.contains(hash)) {
+            return true;
+        }
+    }
+
+    // maybe some other process added the avatar meanwhile
+    QWriteLocker locker(&m_lock);
+    refresh();
+    return m_records.contains(hash);
+}
+
+QImage
+QctAvatarPack::image(const QString &hash)
+{
+    {
+        QReadLocker locker(&m_lock);
+        const QHash<QString, Record>::ConstIterator record = m_records.constFind(hash);
+
+        if (record != m_records.constEnd()) {
+            return QImage::fromData(m_data + record->offset, int(record->length), "PNG");
+        }
+    }
+
+    // maybe some other process added the avatar meanwhile
+    QWriteLocker locker(&m_lock);
+    refresh();
+
+    const QHash<QString, Record>::ConstIterator record = m_records.constFind(hash);
+
+    if (record != m_records.constEnd()) {
+        return QImage::fromData(m_data + record->offset, int(record->length), "PNG");
+    }
+
+    return QImage();
+}
+
+bool
+QctAvatarPack::insert(const QString &hash, const QByteArray &data, QFile::FileError *error)
+{
+    if (error) {
+        *error = QFile::NoError;
+    }
+
+    if (hash.length() != HashLength) {
+        qctWarn(QString::fromLatin1("Invalid avatar hash: %1").arg(hash));
+
+        if (error) {
+            *error = QFile::UnspecifiedError;
+        }
+
+        return false;
+    }
+
+    QWriteLocker locker(&m_lock);
+
+    refresh();
+
+    if (m_records.contains(hash)) {
+        return true;
+    }
+
+    QFile pack(m_fileName);
+
+    if (not lockForAppending(pack, error)) {
+        return false;
+    }
+
+    // pick up records appended by other processes while we waited for the lock
+    refresh();
+
+    if (m_records.contains(hash)) {
+        return true;
+    }
+
+    const qint64 packSize = pack.size();
+
+    if (packSize > 0 && m_mappedSize != packSize) {
+        qctWarn(QString::fromLatin1("Cannot append to avatar pack %1: Cannot read existing records").
+                arg(m_fileName));
+
+        if (error) {
+            *error = QFile::UnspecifiedError;
+        }
+
+        return false;
+    }
+
+    if (packSize > 0 && 0 == m_scannedSize) {
+        qctWarn(QString::fromLatin1("Cannot append to avatar pack %1 of unknown format").
+                arg(m_fileName));
+
+        if (error) {
+            *error = QFile::UnspecifiedError;
+        }
+
+        return false;
+    }
+
+    // drop incomplete records left behind by some crashed writer
+    if (packSize > m_scannedSize) {
+        qctWarn(QString::fromLatin1("Dropping %1 bytes of incomplete records from avatar pack %2").
+                arg(QString::number(packSize - m_scannedSize), m_fileName));
+
+        if (not pack.resize(m_scannedSize)) {
+            if (error) {
+                *error = pack.error();
+            }
+
+            return false;
+        }
+    }
+
+    RecordHeader header;
+    header.magic = RecordMagic;
+    header.length = data.size();
+    memcpy(header.hash, hash.toLatin1().constData(), HashLength);
+
+    QByteArray record;
+
+    if (0 == m_scannedSize) {
+        record.append(FileMagic, sizeof FileMagic);
+    }
+
+    record.append(reinterpret_cast<const char *>(&header), sizeof header);
+    record.append(data);
+
+    if (pack.write(record) != record.size()) {
+        qctWarn(QString::fromLatin1("Cannot append to avatar pack %1: %2").
+                arg(m_fileName, pack.errorString()));
+
+        if (error) {
+            *error = (QFile::NoError != pack.error() ? pack.error() : QFile::UnspecifiedError);
+        }
+
+        // don't leave an incomplete record behind
+        pack.resize(m_scannedSize);
+
+        return false;
+    }
+
+    // closing the file releases the lock
+    pack.close();
+    refresh();
+
+    return m_records.contains(hash);
+}
+
+bool
+QctAvatarPack::compact(const QSet<QString> &hashes)
+{
+    QWriteLocker locker(&m_lock);
+
+    if (not QFile::exists(m_fileName)) {
+        return true;
+    }
+
+    QFile pack(m_fileName);
+
+    if (not lockForAppending(pack, 0)) {
+        return false;
+    }
+
+    refresh();
+
+    if (m_mappedSize != pack.size() || 0 == m_scannedSize) {
+        qctWarn(QString::fromLatin1("Cannot compact avatar pack %1: Cannot read existing records").
+                arg(m_fileName));
+        return false;
+    }
+
+    // figure out which records to keep, and if compaction is worth the effort
+    QList<QString> liveHashes;
+    qint64 liveSize = sizeof FileMagic;
+
+    for(QHash<QString, Record>::ConstIterator it = m_records.constBegin(); it != m_records.constEnd(); ++it) {
+        if (hashes.contains(it.key())) {
+            liveHashes += it.key();
+            liveSize += sizeof(RecordHeader) + it->length;
+        }
+    }
+
+    if (liveSize == m_mappedSize) {
+        return true;
+    }
+
+    // write the live records into a new pack file, and atomically replace the old one
+    const QString compactedFileName = m_fileName + QLatin1String(".compacted");
+    QFile compacted(compactedFileName);
+
+    if (not compacted.open(QFile::WriteOnly | QFile::Truncate)) {
+        qctWarn(QString::fromLatin1("Cannot compact avatar pack %1: %2").
+                arg(m_fileName, compacted.errorString()));
+        return false;
+    }
+
+    compacted.write(FileMagic, sizeof FileMagic);
+
+    foreach(const QString &hash, liveHashes) {
+        const Record &record = m_records[hash];
+        const char *const recordData = reinterpret_cast<const char *>(m_data + record.offset);
+        compacted.write(recordData - sizeof(RecordHeader), sizeof(RecordHeader) + record.length);
+    }
+
+    if (not compacted.flush() || compacted.size() != liveSize || 0 != ::fsync(compacted.handle())) {
+        qctWarn(QString::fromLatin1("Cannot compact avatar pack %1: %2").
+                arg(m_fileName, compacted.errorString()));
+        compacted.remove();
+        return false;
+    }
+
+    compacted.close();
+
+    if (0 != ::rename(QFile::encodeName(compactedFileName).constData(),
+                      QFile::encodeName(m_fileName).constData())) {
+        qctWarn(QString::fromLatin1("Cannot replace avatar pack %1: %2").
+                arg(m_fileName, QString::fromLocal8Bit(strerror(errno))));
+        compacted.remove();
+        return false;
+    }
+
+    // Closing the old pack releases its lock. Writers waiting for that lock
+    // notice the replacement and retry with the compacted pack.
+    pack.close();
+
+    reset();
+    refresh();
+
+    return true;
+}
+
+int
+QctAvatarPack::count()
+{
+    QWriteLocker locker(&m_lock);
+    refresh();
+    return m_records.count();
+}
+
+qint64
+QctAvatarPack::size()
+{
+    QWriteLocker locker(&m_lock);
+    refresh();
+    return m_mappedSize;
+}
@@ -0,0 +1,107 @@
+/*********************************************************************************
+ ** This file is part of QtContacts tracker storage plugin
+ **
+ ** Copyright (c) 2010-2011 Nokia Corporation and/or its subsidiary(-ies).
+ **
+ ** Contact:  Nokia Corporation (info@qt.nokia.com)
+ **
+ ** GNU Lesser General Public License Usage
+ ** This file may be used under the terms of the GNU Lesser General Public License
+ ** version 2.1 as published by the Free Software Foundation and appearing in the
+ ** file LICENSE.LGPL included in the packaging of this file.  Please review the
+ ** following information to ensure the GNU Lesser General Public License version
+ ** 2.1 requirements will be met:
+ ** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+ **
+ ** In addition, as a special exception, Nokia gives you certain additional rights.
+ ** These rights are described in the Nokia Qt LGPL Exception version 1.1, included
+ ** in the file LGPL_EXCEPTION.txt in this package.
+ **
+ ** Other Usage
+ ** Alternatively, this file may be used in accordance with the terms and
+ ** conditions contained in a signed written agreement between you and Nokia.
+ *********************************************************************************/
+
+#ifndef QCTAVATARPACK_P_H
+#define QCTAVATARPACK_P_H
+
+#include <QFile>
+#include <QHash>
+#include <QImage>
+#include <QReadWriteLock>
+#include <QSet>
+
+#include "libqtcontacts_extensions_tracker_global.h"
+
+/**
+ * Stores avatar thumbnails in a single append-only pack file, instead of one PNG
+ * file per avatar. Each record of the pack holds the PNG encoded image, and the
+ * hex encoded SHA1 hash of its pixels, which also names the avatar. The pack gets
+ * memory mapped for reading, an in-memory index maps avatar hashes to records.
+ *
+ * Several processes can share the same pack file: Appending and compaction are
+ * serialized by an advisory lock on the file, readers pick up records appended
+ * by other processes when a lookup fails.
+ **/
+class LIBQTCONTACTS_EXTENSIONS_TRACKER_EXPORT QctAvatarPack
+{
+    Q_DISABLE_COPY(QctAvatarPack)
+
+public: // constants
+    static const char FileMagic[8];
+    static const quint32 RecordMagic = 0x52564151; // "QAVR"
+    static const int HashLength = 40;
+
+public:
+    explicit QctAvatarPack(const QString &fileName);
+    ~QctAvatarPack();
+
+    static QctAvatarPack * instance();
+
+public:
+    QString fileName() const { return m_fileName; }
+
+    bool contains(const QString &hash);
+    QImage image(const QString &hash);
+    bool insert(const QString &hash, const QByteArray &data, QFile::FileError *error = 0);
+
+    /// Removes all records not listed in @p hashes by writing a new pack file.
+    bool compact(const QSet<QString> &hashes);
+
+    int count();
+    qint64 size();
+
+private:
+    struct RecordHeader
+    {
+        quint32 magic;
+        quint32 length;
+        char hash[HashLength];
+    };
+
+    struct Record
+    {
+        Record() : offset(0), length(0) {}
+        Record(qint64 offset, quint32 length) : offset(offset), length(length) {}
+
+        qint64 offset;
+        quint32 length;
+    };
+
+    void refresh();
+    void reset();
+    bool lockForAppending(QFile &file, QFile::FileError *error);
+
+private:
+    const QString m_fileName;
+
+    QReadWriteLock m_lock;
+    QFile m_file;
+    uchar *m_data;
+    qint64 m_mappedSize;
+    qint64 m_scannedSize;
+    quint64 m_inode;
+    QHash<QString, Record> m_records;
+};
+
+#endif // QCTAVATARPACK_P_H
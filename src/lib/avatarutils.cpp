@@ -23,6 +23,7 @@
  *********************************************************************************/
 
 #include "avatarutils.h"
+#include "avatarpack_p.h"
 
 #include "logger.h"
 #include "fileutils.h"
@@ -31,14 +32,67 @@
 
 #include <errno.h>
 
+#include <QBuffer>
 #include <QImageWriter>
 #include <QCryptographicHash>
+#include <QFileInfo>
+#include <QMutex>
+#include <QSet>
+#include <QWaitCondition>
 
-static QString
-makeAvatarCacheFileName(const QImage &image, QFile::FileError *error)
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Remembers the avatar files this process already found or wrote, so that saving
+/// the same avatar again neither hits the file system nor encodes the image again.
+/// Also makes sure that only one thread at a time writes some avatar file.
+class QctWrittenAvatarCache
 {
-    const QDir avatarCacheDir = qctAvatarLocalDataDir();
+public:
+    /// Returns \c true if the calling thread shall write the file,
+    /// and \c false if some other thread already has written it.
+    bool acquire(const QString &fileName)
+    {
+        QMutexLocker locker(&m_mutex);
+
+        while (m_pendingFileNames.contains(fileName)) {
+            m_fileWritten.wait(&m_mutex);
+        }
+
+        if (m_fileNames.contains(fileName)) {
+            return false;
+        }
+
+        m_pendingFileNames.insert(fileName);
+        return true;
+    }
+
+    void release(const QString &fileName, bool written)
+    {
+        QMutexLocker locker(&m_mutex);
+
+        m_pendingFileNames.remove(fileName);
+
+        if (written) {
+            m_fileNames.insert(fileName);
+        }
+
+        m_fileWritten.wakeAll();
+    }
 
+private:
+    QMutex m_mutex;
+    QWaitCondition m_fileWritten;
+    QSet<QString> m_fileNames;
+    QSet<QString> m_pendingFileNames;
+};
+
+Q_GLOBAL_STATIC(QctWrittenAvatarCache, writtenAvatarCache)
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static bool
+makeAvatarCacheDir(const QDir &avatarCacheDir, QFile::FileError *error)
+{
     // Create avatar cache directory when needed.
     if (not avatarCacheDir.mkpath(QLatin1String("."))) {
         qctWarn(QString::fromLatin1("Cannot create avatar cache folder %1: %2").
@@ -58,9 +112,15 @@ makeAvatarCacheFileName(const QImage &image, QFile::FileError *error)
             }
         }
 
-        return QString();
+        return false;
     }
 
+    return true;
+}
+
+static QString
+makeAvatarHash(const QImage &image)
+{
     // Create filename from cryptographic hash of the pixel data. Probability that two
     // different pictures on the same device have the same hash code, is significantly
     // smaller than probability that we mess up because of miscalculations caused by
@@ -69,13 +129,126 @@ makeAvatarCacheFileName(const QImage &image, QFile::FileError *error)
     const char *const rawPixelData = reinterpret_cast<const char *>(image.constBits());
     const QByteArray pixels = QByteArray::fromRawData(rawPixelData, image.byteCount());
     const QByteArray pixelHash = QCryptographicHash::hash(pixels, QCryptographicHash::Sha1).toHex();
-    const QString fileName = QString::fromLatin1("%1.png").arg(QString::fromLatin1(pixelHash));
 
-    if (error) {
-        *error = QFile::NoError;
+    return QString::fromLatin1(pixelHash);
+}
+
+static QString
+makeAvatarCacheFileName(const QDir &avatarCacheDir, const QString &avatarHash)
+{
+    return avatarCacheDir.absoluteFilePath(QString::fromLatin1("%1.png").arg(avatarHash));
+}
+
+static const QString avatarPackScheme = QLatin1String("avatarpack");
+
+static QString
+makeAvatarPackUri(const QString &avatarHash)
+{
+    return avatarPackScheme + QLatin1Char(':') + avatarHash;
+}
+
+static bool
+isAvatarPackUri(const QString &fileName)
+{
+    return (fileName.startsWith(avatarPackScheme) &&
+            fileName.length() == avatarPackScheme.length() + 1 + QctAvatarPack::HashLength &&
+            fileName.at(avatarPackScheme.length()) == QLatin1Char(':'));
+}
+
+/// Returns the hash naming the avatar file or avatar pack URI @p fileName,
+/// or a null string if this file is not in the avatar cache.
+static QString
+findAvatarHash(const QString &fileName)
+{
+    if (isAvatarPackUri(fileName)) {
+        return fileName.right(QctAvatarPack::HashLength);
+    }
+
+    const QFileInfo fileInfo(fileName);
+
+    if (fileInfo.suffix() != QLatin1String("png")
+            || fileInfo.completeBaseName().length() != QctAvatarPack::HashLength
+            || fileInfo.absoluteDir() != qctAvatarLocalDataDir()) {
+        return QString();
     }
 
-    return avatarCacheDir.absoluteFilePath(fileName);
+    return fileInfo.completeBaseName();
+}
+
+static bool
+writeAvatarFile(const QDir &avatarCacheDir, const QString &avatarFileName,
+                const QImage &image, QFile::FileError *error)
+{
+    if (not makeAvatarCacheDir(avatarCacheDir, error)) {
+        // failed to create the cache folder
+        return false;
+    }
+
+    QFile avatarFile(avatarFileName);
+
+    if (avatarFile.exists()) {
+        return true;
+    }
+
+    QImageWriter writer;
+
+    writer.setDevice(&avatarFile);
+
+    if (not writer.write(image)) {
+        qctWarn(QString::fromLatin1("Cannot save avatar thumbnail: %1").
+                arg(writer.errorString()));
+
+        if (error) {
+            if (QFile::NoError != avatarFile.error()) {
+                *error = avatarFile.error();
+            } else {
+                *error = QFile::UnspecifiedError;
+            }
+        }
+
+        if (not avatarFile.remove()) {
+            qctWarn(QString::fromLatin1("Cannot remove invalid avatar file %1").
+                    arg(avatarFileName));
+        }
+
+        return false;
+    }
+
+    return true;
+}
+
+static bool
+writeAvatarRecord(const QDir &avatarCacheDir, const QString &avatarHash,
+                  const QImage &image, QFile::FileError *error)
+{
+    QctAvatarPack *const pack = QctAvatarPack::instance();
+
+    if (pack->contains(avatarHash)) {
+        return true;
+    }
+
+    if (not makeAvatarCacheDir(avatarCacheDir, error)) {
+        // failed to create the cache folder
+        return false;
+    }
+
+    QBuffer buffer;
+    buffer.open(QBuffer::WriteOnly);
+
+    QImageWriter writer(&buffer, "PNG");
+
+    if (not writer.write(image)) {
+        qctWarn(QString::fromLatin1("Cannot encode avatar thumbnail: %1").
+                arg(writer.errorString()));
+
+        if (error) {
+            *error = QFile::UnspecifiedError;
+        }
+
+        return false;
+    }
+
+    return pack->insert(avatarHash, buffer.data(), error);
 }
 
 QString
@@ -94,50 +267,98 @@ qctWriteThumbnail(QImage &image, QFile::FileError *error)
         image = image.scaled(avatarSize, Qt::KeepAspectRatio);
     }
 
+    if (error) {
+        *error = QFile::NoError;
+    }
+
     // Save the avatar image when neeed. The cached file name is based on
     // a cryptographic hash of the thumbnail's pixels. So if there already
     // exists a image file with the calculated name, there is an incredibly
     // high probability the existing file is equal to this current avatar.
     // We prefer to not write the file in this case for better performance
     // and for better lifetime of the storage medium.
-    const QString avatarFileName = makeAvatarCacheFileName(image, error);
+    const QDir avatarCacheDir = qctAvatarLocalDataDir();
+    const QString avatarHash = makeAvatarHash(image);
+    const QString avatarFileName = makeAvatarCacheFileName(avatarCacheDir, avatarHash);
 
-    if (avatarFileName.isEmpty()) {
-        // failed to build file name
-        return QString();
+    // In pack mode no file gets written, so return an URI which clients can recognize
+    // as such, instead of the name of some file that doesn't exist.
+    if (QctThreadLocalData::instance()->settings()->packAvatars()) {
+        const bool written = writeAvatarRecord(avatarCacheDir, avatarHash, image, error);
+        return (written ? makeAvatarPackUri(avatarHash) : QString());
     }
 
-    QFile avatarFile(avatarFileName);
+    // Avatars seen before by this process don't even need a stat() call.
+    if (not writtenAvatarCache()->acquire(avatarFileName)) {
+        return avatarFileName;
+    }
 
-    if (not avatarFile.exists()) {
-        QImageWriter writer;
+    const bool written = writeAvatarFile(avatarCacheDir, avatarFileName, image, error);
+    writtenAvatarCache()->release(avatarFileName, written);
 
-        writer.setDevice(&avatarFile);
+    return (written ? avatarFileName : QString());
+}
 
-        if (not writer.write(image)) {
-            qctWarn(QString::fromLatin1("Cannot save avatar thumbnail: %1").
-                    arg(writer.errorString()));
+QUrl
+qctThumbnailUrl(const QString &fileName)
+{
+    if (isAvatarPackUri(fileName)) {
+        return QUrl(fileName);
+    }
 
-            if (error) {
-                if (QFile::NoError != avatarFile.error()) {
-                    *error = avatarFile.error();
-                } else {
-                    *error = QFile::UnspecifiedError;
-                }
-            }
+    return QUrl::fromLocalFile(fileName);
+}
 
-            if (not avatarFile.remove()) {
-                qctWarn(QString::fromLatin1("Cannot remove invalid avatar file %1").
-                        arg(avatarFileName));
-            }
+QImage
+qctReadThumbnail(const QString &fileName)
+{
+    const QString avatarHash = findAvatarHash(fileName);
 
-            return QString();
-        }
+    if (isAvatarPackUri(fileName)) {
+        return QctAvatarPack::instance()->image(avatarHash);
     }
 
-    if (error) {
-        *error = QFile::NoError;
+    const bool preferPack = QctThreadLocalData::instance()->settings()->packAvatars();
+    QImage image;
+
+    if (preferPack && not avatarHash.isEmpty()) {
+        image = QctAvatarPack::instance()->image(avatarHash);
+    }
+
+    if (image.isNull()) {
+        image.load(fileName);
+    }
+
+    // Avatars written before leaving pack mode still are in the pack.
+    if (image.isNull() && not preferPack && not avatarHash.isEmpty()) {
+        image = QctAvatarPack::instance()->image(avatarHash);
+    }
+
+    return image;
+}
+
+QImage
+qctReadThumbnail(const QUrl &imageUrl)
+{
+    if (imageUrl.scheme() == avatarPackScheme) {
+        return qctReadThumbnail(imageUrl.toString());
+    }
+
+    return qctReadThumbnail(imageUrl.toLocalFile());
+}
+
+bool
+qctCompactAvatarPack(const QStringList &fileNames)
+{
+    QSet<QString> avatarHashes;
+
+    foreach(const QString &fileName, fileNames) {
+        const QString avatarHash = findAvatarHash(fileName);
+
+        if (not avatarHash.isEmpty()) {
+            avatarHashes += avatarHash;
+        }
     }
 
-    return avatarFileName;
+    return QctAvatarPack::instance()->compact(avatarHashes);
 }
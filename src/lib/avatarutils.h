@@ -27,6 +27,8 @@
 
 #include <QImage>
 #include <QFile>
+#include <QStringList>
+#include <QUrl>
 
 #include "libqtcontacts_extensions_tracker_global.h"
 
@@ -40,9 +42,43 @@ qctWriteThumbnail(QImage &image);
 /*!
  * \brief Thumbnails the given \p image in place, and returns its full path.
  * Possible errors are reported in \p unless null is passed.
+ * Thumbnails stored in the avatar pack have no file of their own, for them an
+ * "avatarpack:" URI is returned instead of a path, see QctSettings::packAvatars().
  * \return the full path if the thumbnailing succeeds, a null QString else
  */
 LIBQTCONTACTS_EXTENSIONS_TRACKER_EXPORT QString
 qctWriteThumbnail(QImage &image, QFile::FileError *error);
 
+/*!
+ * \brief Returns the image URL to store for the thumbnail \p fileName returned by
+ * qctWriteThumbnail(): A file URL, or the "avatarpack:" URI of packed thumbnails.
+ */
+LIBQTCONTACTS_EXTENSIONS_TRACKER_EXPORT QUrl
+qctThumbnailUrl(const QString &fileName);
+
+/*!
+ * \brief Loads the avatar thumbnail \p fileName returned by qctWriteThumbnail().
+ * Other than just opening the file this also finds thumbnails stored in the
+ * avatar pack, see QctSettings::packAvatars().
+ * \return the thumbnail, or a null QImage if the thumbnail cannot be found
+ */
+LIBQTCONTACTS_EXTENSIONS_TRACKER_EXPORT QImage
+qctReadThumbnail(const QString &fileName);
+
+/*!
+ * \brief Loads the avatar thumbnail referenced by \p imageUrl, as found in
+ * QContactAvatar::imageUrl(). Other than opening the URL's local file this
+ * also resolves the "avatarpack:" URIs of thumbnails stored in the avatar pack.
+ * \return the thumbnail, or a null QImage if the thumbnail cannot be found
+ */
+LIBQTCONTACTS_EXTENSIONS_TRACKER_EXPORT QImage
+qctReadThumbnail(const QUrl &imageUrl);
+
+/*!
+ * \brief Removes all thumbnails from the avatar pack, which are not listed in \p fileNames.
+ * \return \c true on success, \c false else
+ */
+LIBQTCONTACTS_EXTENSIONS_TRACKER_EXPORT bool
+qctCompactAvatarPack(const QStringList &fileNames);
+
 #endif // QCTAVATARUTILS_H
@@ -28,5 +28,6 @@ QTM_BEGIN_NAMESPACE
 
 Q_DEFINE_LATIN1_CONSTANT(QtContactsTrackerDefaultGraphIri, "urn:uuid:08070f5c-a334-4d19-a8b0-12a3071bfab9");
 Q_DEFINE_LATIN1_CONSTANT(QtContactsTrackerTelepathyGraphIri, "urn:uuid:679293d4-60f0-49c7-8d63-f1528fe31f66");
+Q_DEFINE_LATIN1_CONSTANT(QtContactsTrackerTombstoneGraphIri, "urn:uuid:23e8a279-dc3c-4f48-a086-42ba8e462042");
 
 QTM_END_NAMESPACE
@@ -23,8 +23,136 @@
  *********************************************************************************/
 
 #include "garbagecollector.h"
+#include "garbagecollector_p.h"
 
 #include "logger.h"
+#include "threadutils.h"
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+Q_GLOBAL_STATIC(QctGarbageCollectorSingleton, garbageCollectorSingleton)
+
+const double QctGarbageCollectorSingleton::FlushThreshold = 1.0;
+
+QctGarbageCollectorSingleton::QctGarbageCollectorSingleton()
+    : m_idleTimer(new QTimer(this))
+    , m_requestedTriggers(0)
+    , m_sentTriggers(0)
+    , m_coalescedTriggers(0)
+{
+    m_idleTimer->setInterval(IdleTimeout);
+    m_idleTimer->setSingleShot(true);
+
+    connect(m_idleTimer, SIGNAL(timeout()), SLOT(flush()));
+
+    if (qApp) {
+        // Ensure the idle timer runs in a thread with an event loop. Without this step
+        // the singleton would belong to the random, potentially short living thread
+        // triggering the garbage collector first.
+        moveToThread(qApp->thread());
+
+        // Don't lose the accumulated load when the application quits.
+        connect(qApp, SIGNAL(aboutToQuit()), SLOT(flush()));
+    } else {
+        qctWarn("QctGarbageCollector: Cannot coalesce triggers without QCoreApplication");
+    }
+}
+
+bool
+QctGarbageCollectorSingleton::trigger(const QString &id, double load)
+{
+    // Without application object there is no event loop running the idle timer.
+    bool flushNow = (0 == qApp);
+
+    {
+        QCT_SYNCHRONIZED(&m_mutex);
+
+        PendingLoad &pending = m_pendingLoads[id];
+        pending.load += load;
+        pending.triggerCount += 1;
+
+        m_requestedTriggers += 1;
+
+        if (pending.load >= FlushThreshold) {
+            flushNow = true;
+        }
+    }
+
+    if (flushNow) {
+        return flush(id);
+    }
+
+    // Restart the idle timer. We might get called from any thread,
+    // therefore the timer must be restarted from within its own thread.
+    QMetaObject::invokeMethod(m_idleTimer, "start", Qt::QueuedConnection);
+
+    return true;
+}
+
+bool
+QctGarbageCollectorSingleton::flush()
+{
+    QList<QString> ids;
+
+    {
+        QCT_SYNCHRONIZED(&m_mutex);
+        ids = m_pendingLoads.keys();
+    }
+
+    bool success = true;
+
+    foreach(const QString &id, ids) {
+        if (not flush(id)) {
+            success = false;
+        }
+    }
+
+    return success;
+}
+
+bool
+QctGarbageCollectorSingleton::flush(const QString &id)
+{
+    PendingLoad pending;
+
+    {
+        QCT_SYNCHRONIZED(&m_mutex);
+
+        pending = m_pendingLoads.take(id);
+
+        if (0 == pending.triggerCount) {
+            return true; // another thread was faster
+        }
+
+        m_sentTriggers += 1;
+        m_coalescedTriggers += pending.triggerCount - 1;
+    }
+
+    return QctGarbageCollector::sendTrigger(id, pending.load);
+}
+
+int
+QctGarbageCollectorSingleton::requestedTriggers() const
+{
+    QCT_SYNCHRONIZED(&m_mutex);
+    return m_requestedTriggers;
+}
+
+int
+QctGarbageCollectorSingleton::sentTriggers() const
+{
+    QCT_SYNCHRONIZED(&m_mutex);
+    return m_sentTriggers;
+}
+
+int
+QctGarbageCollectorSingleton::coalescedTriggers() const
+{
+    QCT_SYNCHRONIZED(&m_mutex);
+    return m_coalescedTriggers;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
 
 bool
 QctGarbageCollector::registerQuery(const QString &id, const QString &query)
@@ -53,6 +181,47 @@ QctGarbageCollector::registerQuery(const QString &id, const QString &query)
 
 bool
 QctGarbageCollector::trigger(const QString &id, double load)
+{
+    QctGarbageCollectorSingleton *const singleton = garbageCollectorSingleton();
+
+    if (0 == singleton) {
+        // the singleton is already gone during application shutdown
+        return sendTrigger(id, load);
+    }
+
+    return singleton->trigger(id, load);
+}
+
+bool
+QctGarbageCollector::flush()
+{
+    QctGarbageCollectorSingleton *const singleton = garbageCollectorSingleton();
+    return (0 == singleton || singleton->flush());
+}
+
+int
+QctGarbageCollector::requestedTriggers()
+{
+    QctGarbageCollectorSingleton *const singleton = garbageCollectorSingleton();
+    return (singleton ? singleton->requestedTriggers() : 0);
+}
+
+int
+QctGarbageCollector::sentTriggers()
+{
+    QctGarbageCollectorSingleton *const singleton = garbageCollectorSingleton();
+    return (singleton ? singleton->sentTriggers() : 0);
+}
+
+int
+QctGarbageCollector::coalescedTriggers()
+{
+    QctGarbageCollectorSingleton *const singleton = garbageCollectorSingleton();
+    return (singleton ? singleton->coalescedTriggers() : 0);
+}
+
+bool
+QctGarbageCollector::sendTrigger(const QString &id, double load)
 {
     static const QString triggerMethod = QString::fromLatin1("Trigger");
 
@@ -43,6 +43,11 @@
  * the load of a query reaches 1 (there is a small delay between the moment when
  * the load reaches 1 and the actual garbage collection, to ease the load on the
  * device).
+ *
+ * Calls to trigger() are coalesced: the load is accumulated locally for each
+ * query and only sent to contactsd once it reaches 1, or after a short period
+ * without further triggers. Call flush() to send the accumulated load right
+ * away, e.g. before shutting down.
  */
 class LIBQTCONTACTS_EXTENSIONS_TRACKER_EXPORT QctGarbageCollector
 {
@@ -66,7 +71,34 @@ public: // methods
      */
     static bool trigger(const QString &id, double load);
 
+    /*!
+     * Sends the load accumulated by trigger() for all queries
+     *
+     * This happens automatically after a short idle period, and when the
+     * application is about to quit.
+     */
+    static bool flush();
+
+    /*!
+     * Returns the number of times trigger() was called
+     */
+    static int requestedTriggers();
+
+    /*!
+     * Returns the number of trigger messages sent to contactsd
+     */
+    static int sentTriggers();
+
+    /*!
+     * Returns the number of trigger() calls which were merged into
+     * the message of an earlier call instead of sending their own one
+     */
+    static int coalescedTriggers();
+
 private: // methods
+    friend class QctGarbageCollectorSingleton;
+
+    static bool sendTrigger(const QString &id, double load);
     static QDBusMessage createCall(const QString &method);
 };
 
@@ -0,0 +1,82 @@
+/*********************************************************************************
+ ** This file is part of QtContacts tracker storage plugin
+ **
+ ** Copyright (c) 2010-2011 Nokia Corporation and/or its subsidiary(-ies).
+ **
+ ** Contact:  Nokia Corporation (info@qt.nokia.com)
+ **
+ ** GNU Lesser General Public License Usage
+ ** This file may be used under the terms of the GNU Lesser General Public License
+ ** version 2.1 as published by the Free Software Foundation and appearing in the
+ ** file LICENSE.LGPL included in the packaging of this file.  Please review the
+ ** following information to ensure the GNU Lesser General Public License version
+ ** 2.1 requirements will be met:
+ ** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+ **
+ ** In addition, as a special exception, Nokia gives you certain additional rights.
+ ** These rights are described in the Nokia Qt LGPL Exception version 1.1, included
+ ** in the file LGPL_EXCEPTION.txt in this package.
+ **
+ ** Other Usage
+ ** Alternatively, this file may be used in accordance with the terms and
+ ** conditions contained in a signed written agreement between you and Nokia.
+ *********************************************************************************/
+
+#ifndef QCTGARBAGECOLLECTOR_P_H
+#define QCTGARBAGECOLLECTOR_P_H
+
+#include <QCoreApplication>
+#include <QHash>
+#include <QMutex>
+#include <QTimer>
+
+/**
+ * Accumulates the load reported by QctGarbageCollector::trigger() for each query,
+ * and forwards it to contactsd once the accumulated load reaches FlushThreshold,
+ * or when no further triggers arrived for IdleTimeout milliseconds. This way a
+ * sync run saving hundreds of contacts in small batches results in very few D-Bus
+ * messages instead of one message per request.
+ **/
+class QctGarbageCollectorSingleton : public QObject
+{
+    Q_OBJECT
+
+public: // constants
+    static const int IdleTimeout = 1000;
+    static const double FlushThreshold;
+
+public:
+    QctGarbageCollectorSingleton();
+
+public:
+    bool trigger(const QString &id, double load);
+
+    int requestedTriggers() const;
+    int sentTriggers() const;
+    int coalescedTriggers() const;
+
+public slots:
+    bool flush();
+
+private:
+    bool flush(const QString &id);
+
+private:
+    struct PendingLoad
+    {
+        PendingLoad() : load(0), triggerCount(0) {}
+
+        double load;
+        int triggerCount;
+    };
+
+    mutable QMutex m_mutex;
+    QHash<QString, PendingLoad> m_pendingLoads;
+    QTimer *m_idleTimer;
+
+    int m_requestedTriggers;
+    int m_sentTriggers;
+    int m_coalescedTriggers;
+};
+
+#endif // QCTGARBAGECOLLECTOR_P_H
@@ -0,0 +1,89 @@
+/*********************************************************************************
+ ** This file is part of QtContacts tracker storage plugin
+ **
+ ** Copyright (c) 2011 Nokia Corporation and/or its subsidiary(-ies).
+ **
+ ** Contact:  Nokia Corporation (info@qt.nokia.com)
+ **
+ ** GNU Lesser General Public License Usage
+ ** This file may be used under the terms of the GNU Lesser General Public License
+ ** version 2.1 as published by the Free Software Foundation and appearing in the
+ ** file LICENSE.LGPL included in the packaging of this file.  Please review the
+ ** following information to ensure the GNU Lesser General Public License version
+ ** 2.1 requirements will be met:
+ ** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+ **
+ ** In addition, as a special exception, Nokia gives you certain additional rights.
+ ** These rights are described in the Nokia Qt LGPL Exception version 1.1, included
+ ** in the file LGPL_EXCEPTION.txt in this package.
+ **
+ ** Other Usage
+ ** Alternatively, this file may be used in accordance with the terms and
+ ** conditions contained in a signed written agreement between you and Nokia.
+ *********************************************************************************/
+
+#include "keypadmatchrequest.h"
+#include "threadutils.h"
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+class QctKeypadMatchRequestData : public QObjectUserData
+{
+public: // attributes
+    void setDigits(const QString &digits)
+    {
+        QCT_SYNCHRONIZED_WRITE(&m_lock);
+        m_digits = digits;
+    }
+
+    QString digits() const
+    {
+        QCT_SYNCHRONIZED_READ(&m_lock);
+        return m_digits;
+    }
+
+    static uint id()
+    {
+        static const uint userDataId = QObject::registerUserData();
+        return userDataId;
+    }
+
+private: // fields
+    mutable QReadWriteLock m_lock;
+
+    QString m_digits;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+QctKeypadMatchRequest::QctKeypadMatchRequest(QObject *parent)
+    : QContactLocalIdFetchRequest(parent)
+{
+    setUserData(QctKeypadMatchRequestData::id(), new QctKeypadMatchRequestData);
+}
+
+void
+QctKeypadMatchRequest::setDigits(const QString &digits)
+{
+    data()->setDigits(digits);
+}
+
+QString
+QctKeypadMatchRequest::digits() const
+{
+    return data()->digits();
+}
+
+const QctKeypadMatchRequestData *
+QctKeypadMatchRequest::data() const
+{
+    return static_cast<const QctKeypadMatchRequestData *>
+            (userData(QctKeypadMatchRequestData::id()));
+}
+
+QctKeypadMatchRequestData *
+QctKeypadMatchRequest::data()
+{
+    return static_cast<QctKeypadMatchRequestData *>
+            (userData(QctKeypadMatchRequestData::id()));
+}
@@ -0,0 +1,77 @@
+/*********************************************************************************
+ ** This file is part of QtContacts tracker storage plugin
+ **
+ ** Copyright (c) 2011 Nokia Corporation and/or its subsidiary(-ies).
+ **
+ ** Contact:  Nokia Corporation (info@qt.nokia.com)
+ **
+ ** GNU Lesser General Public License Usage
+ ** This file may be used under the terms of the GNU Lesser General Public License
+ ** version 2.1 as published by the Free Software Foundation and appearing in the
+ ** file LICENSE.LGPL included in the packaging of this file.  Please review the
+ ** following information to ensure the GNU Lesser General Public License version
+ ** 2.1 requirements will be met:
+ ** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+ **
+ ** In addition, as a special exception, Nokia gives you certain additional rights.
+ ** These rights are described in the Nokia Qt LGPL Exception version 1.1, included
+ ** in the file LGPL_EXCEPTION.txt in this package.
+ **
+ ** Other Usage
+ ** Alternatively, this file may be used in accordance with the terms and
+ ** conditions contained in a signed written agreement between you and Nokia.
+ *********************************************************************************/
+
+#ifndef QCTKEYPADMATCHREQUEST_H
+#define QCTKEYPADMATCHREQUEST_H
+
+#include "qtcontactsglobal.h"
+#include "qcontactlocalidfetchrequest.h"
+
+#include "libqtcontacts_extensions_tracker_global.h"
+
+QTM_USE_NAMESPACE
+
+/*!
+ * \class QctKeypadMatchRequest
+ * \brief Custom qtcontacts-tracker request for smart-dial style searches
+ *
+ * This request finds the contacts matching a sequence of digits typed on a phone keypad.
+ * A contact matches if a word of its first name, last name or nickname, or its first and
+ * last name written together, starts with letters on the typed keys, or if one of its
+ * phone numbers contains the digits. The letters are mapped to keys by
+ * qctMakeKeypadDigits() using the current locale.
+ *
+ * Like QctPhoneNumberMatchRequest this request is answered from an in-process index,
+ * which is built with a single query on first use, and kept up to date from tracker's
+ * change notifications.
+ *
+ * The filter and sort orders inherited from QContactLocalIdFetchRequest are ignored.
+ * Use ids() to read the result.
+ *
+ * \note type() returns QContactAbstractRequest::ContactLocalIdFetchRequest.
+ */
+class LIBQTCONTACTS_EXTENSIONS_TRACKER_EXPORT QctKeypadMatchRequestData;
+class LIBQTCONTACTS_EXTENSIONS_TRACKER_EXPORT QctKeypadMatchRequest : public QContactLocalIdFetchRequest
+{
+    Q_OBJECT
+
+public:
+    /*! Constructs a new keypad match request whose parent is the specified \a parent */
+    QctKeypadMatchRequest(QObject *parent = 0);
+
+    /*! Sets the digits typed on the keypad */
+    void setDigits(const QString &digits);
+    /*! Returns the digits typed on the keypad */
+    QString digits() const;
+
+protected:
+    const QctKeypadMatchRequestData * data() const;
+    QctKeypadMatchRequestData * data();
+
+private:
+    Q_DISABLE_COPY(QctKeypadMatchRequest)
+    friend class QContactManagerEngine;
+};
+
+#endif // QCTKEYPADMATCHREQUEST_H
@@ -44,11 +44,14 @@ QCONTACTS_EXTENSIONS_TRACKER_PUBLIC_HEADERS = \
     customdetails.h \
     fileutils.h \
     garbagecollector.h \
+    keypadmatchrequest.h \
     libqtcontacts_extensions_tracker_global.h \
+    phonenumbermatchrequest.h \
     phoneutils.h \
     presenceutils.h \
     requestextensions.h \
     resourcecache.h \
+    searchsession.h \
     settings.h \
     sparqlconnectionmanager.h \
     sparqlresolver.h \
@@ -57,6 +60,8 @@ QCONTACTS_EXTENSIONS_TRACKER_PUBLIC_HEADERS = \
     unmergeimcontactsrequest.h
 
 QCONTACTS_EXTENSIONS_TRACKER_PRIVATE_HEADERS = \
+    avatarpack_p.h \
+    garbagecollector_p.h \
     logger.h \
     metatypedcontactdetail_p.h \
     queue.h \
@@ -69,6 +74,7 @@ HEADERS += \
     $$QCONTACTS_EXTENSIONS_TRACKER_PRIVATE_HEADERS
 
 SOURCES += \
+    avatarpack.cpp \
     avatarutils.cpp \
     constants.cpp \
     contactlocalidfetchrequest.cpp \
@@ -76,13 +82,16 @@ SOURCES += \
     customdetails.cpp \
     fileutils.cpp \
     garbagecollector.cpp \
+    keypadmatchrequest.cpp \
     logger.cpp \
+    phonenumbermatchrequest.cpp \
     phoneutils.cpp \
     presenceutils.cpp \
     queue.cpp \
     requestextensions.cpp \
     resolvertask.cpp \
     resourcecache.cpp \
+    searchsession.cpp \
     settings.cpp \
     sparqlconnectionmanager.cpp \
     sparqlresolver.cpp \
@@ -0,0 +1,89 @@
+/*********************************************************************************
+ ** This file is part of QtContacts tracker storage plugin
+ **
+ ** Copyright (c) 2011 Nokia Corporation and/or its subsidiary(-ies).
+ **
+ ** Contact:  Nokia Corporation (info@qt.nokia.com)
+ **
+ ** GNU Lesser General Public License Usage
+ ** This file may be used under the terms of the GNU Lesser General Public License
+ ** version 2.1 as published by the Free Software Foundation and appearing in the
+ ** file LICENSE.LGPL included in the packaging of this file.  Please review the
+ ** following information to ensure the GNU Lesser General Public License version
+ ** 2.1 requirements will be met:
+ ** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+ **
+ ** In addition, as a special exception, Nokia gives you certain additional rights.
+ ** These rights are described in the Nokia Qt LGPL Exception version 1.1, included
+ ** in the file LGPL_EXCEPTION.txt in this package.
+ **
+ ** Other Usage
+ ** Alternatively, this file may be used in accordance with the terms and
+ ** conditions contained in a signed written agreement between you and Nokia.
+ *********************************************************************************/
+
+#include "phonenumbermatchrequest.h"
+#include "threadutils.h"
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+class QctPhoneNumberMatchRequestData : public QObjectUserData
+{
+public: // attributes
+    void setPhoneNumber(const QString &phoneNumber)
+    {
+        QCT_SYNCHRONIZED_WRITE(&m_lock);
+        m_phoneNumber = phoneNumber;
+    }
+
+    QString phoneNumber() const
+    {
+        QCT_SYNCHRONIZED_READ(&m_lock);
+        return m_phoneNumber;
+    }
+
+    static uint id()
+    {
+        static const uint userDataId = QObject::registerUserData();
+        return userDataId;
+    }
+
+private: // fields
+    mutable QReadWriteLock m_lock;
+
+    QString m_phoneNumber;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+QctPhoneNumberMatchRequest::QctPhoneNumberMatchRequest(QObject *parent)
+    : QContactLocalIdFetchRequest(parent)
+{
+    setUserData(QctPhoneNumberMatchRequestData::id(), new QctPhoneNumberMatchRequestData);
+}
+
+void
+QctPhoneNumberMatchRequest::setPhoneNumber(const QString &phoneNumber)
+{
+    data()->setPhoneNumber(phoneNumber);
+}
+
+QString
+QctPhoneNumberMatchRequest::phoneNumber() const
+{
+    return data()->phoneNumber();
+}
+
+const QctPhoneNumberMatchRequestData *
+QctPhoneNumberMatchRequest::data() const
+{
+    return static_cast<const QctPhoneNumberMatchRequestData *>
+            (userData(QctPhoneNumberMatchRequestData::id()));
+}
+
+QctPhoneNumberMatchRequestData *
+QctPhoneNumberMatchRequest::data()
+{
+    return static_cast<QctPhoneNumberMatchRequestData *>
+            (userData(QctPhoneNumberMatchRequestData::id()));
+}
@@ -0,0 +1,76 @@
+/*********************************************************************************
+ ** This file is part of QtContacts tracker storage plugin
+ **
+ ** Copyright (c) 2011 Nokia Corporation and/or its subsidiary(-ies).
+ **
+ ** Contact:  Nokia Corporation (info@qt.nokia.com)
+ **
+ ** GNU Lesser General Public License Usage
+ ** This file may be used under the terms of the GNU Lesser General Public License
+ ** version 2.1 as published by the Free Software Foundation and appearing in the
+ ** file LICENSE.LGPL included in the packaging of this file.  Please review the
+ ** following information to ensure the GNU Lesser General Public License version
+ ** 2.1 requirements will be met:
+ ** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+ **
+ ** In addition, as a special exception, Nokia gives you certain additional rights.
+ ** These rights are described in the Nokia Qt LGPL Exception version 1.1, included
+ ** in the file LGPL_EXCEPTION.txt in this package.
+ **
+ ** Other Usage
+ ** Alternatively, this file may be used in accordance with the terms and
+ ** conditions contained in a signed written agreement between you and Nokia.
+ *********************************************************************************/
+
+#ifndef QCTPHONENUMBERMATCHREQUEST_H
+#define QCTPHONENUMBERMATCHREQUEST_H
+
+#include "qtcontactsglobal.h"
+#include "qcontactlocalidfetchrequest.h"
+
+#include "libqtcontacts_extensions_tracker_global.h"
+
+QTM_USE_NAMESPACE
+
+/*!
+ * \class QctPhoneNumberMatchRequest
+ * \brief Custom qtcontacts-tracker request for quickly finding the contacts owning a phone number
+ *
+ * This request is intended for caller-id style lookups. Instead of compiling a
+ * QContactDetailFilter with QContactFilter::MatchPhoneNumber into SPARQL, the request
+ * is answered from an in-process index which maps local phone numbers (see
+ * qctMakeLocalPhoneNumber()) to contact ids. The index is built with a single query
+ * on first use, and kept up to date from tracker's change notifications.
+ *
+ * Like a phone number filter, the request first looks for an exact match of numbers
+ * with DTMF codes, and falls back to the number without DTMF codes.
+ *
+ * The filter and sort orders inherited from QContactLocalIdFetchRequest are ignored.
+ * Use ids() to read the result.
+ *
+ * \note type() returns QContactAbstractRequest::ContactLocalIdFetchRequest.
+ */
+class LIBQTCONTACTS_EXTENSIONS_TRACKER_EXPORT QctPhoneNumberMatchRequestData;
+class LIBQTCONTACTS_EXTENSIONS_TRACKER_EXPORT QctPhoneNumberMatchRequest : public QContactLocalIdFetchRequest
+{
+    Q_OBJECT
+
+public:
+    /*! Constructs a new phone number match request whose parent is the specified \a parent */
+    QctPhoneNumberMatchRequest(QObject *parent = 0);
+
+    /*! Sets the phone number to look up */
+    void setPhoneNumber(const QString &phoneNumber);
+    /*! Returns the phone number to look up */
+    QString phoneNumber() const;
+
+protected:
+    const QctPhoneNumberMatchRequestData * data() const;
+    QctPhoneNumberMatchRequestData * data();
+
+private:
+    Q_DISABLE_COPY(QctPhoneNumberMatchRequest)
+    friend class QContactManagerEngine;
+};
+
+#endif // QCTPHONENUMBERMATCHREQUEST_H
@@ -44,8 +44,8 @@ qctNormalizePhoneNumber(const QString& value)
     return qctNormalizePhoneNumber(value, Qct::RemoveUnicodeFormatters | Qct::RemoveFormatters);
 }
 
-QString
-qctNormalizePhoneNumber(const QString& value, Qct::NumberNormalizationOptions options)
+static QString
+normalizePhoneNumberSlow(const QString& value, Qct::NumberNormalizationOptions options)
 {
     static const QString visualSeparators = QLatin1String("[() .-]");
 
@@ -77,6 +77,98 @@ qctNormalizePhoneNumber(const QString& value, Qct::NumberNormalizationOptions op
     return result;
 }
 
+/// Classifies the Latin-1 characters for normalizePhoneNumberFast().
+/// The table is derived from the same rules used by normalizePhoneNumberSlow(),
+/// so that both code paths produce identical results for Latin-1 input.
+class QctLatin1CharTable
+{
+public:
+    enum CharClass {
+        NumberFormatter = 1 << 0,
+        UnicodeFormatter = 1 << 1
+    };
+
+    QctLatin1CharTable()
+    {
+        static const QString visualSeparators = QLatin1String("[() .-]");
+
+        for(int i = 0; i < 256; ++i) {
+            const QChar ch = QChar(ushort(i));
+
+            m_classes[i] = 0;
+
+            if (visualSeparators.contains(ch)) {
+                m_classes[i] |= NumberFormatter;
+            }
+
+            if (ch.category() == QChar::Other_Format) {
+                m_classes[i] |= UnicodeFormatter;
+            }
+        }
+    }
+
+    uchar operator[](ushort ch) const { return m_classes[ch]; }
+
+private:
+    uchar m_classes[256];
+};
+
+Q_GLOBAL_STATIC(QctLatin1CharTable, latin1CharTable)
+
+/// Normalizes \p value using a lookup table, and returns \c false if the number contains
+/// characters outside of Latin-1, which must be handled by normalizePhoneNumberSlow().
+static bool
+normalizePhoneNumberFast(const QString& value, Qct::NumberNormalizationOptions options,
+                         QString &result)
+{
+    const QctLatin1CharTable &table = *latin1CharTable();
+
+    // Within Latin-1 only the ASCII digits are decimal digits,
+    // so there is nothing to do for Qct::ConvertToLatin.
+    uchar skippedClasses = 0;
+
+    if (options.testFlag(Qct::RemoveNumberFormatters)) {
+        skippedClasses |= QctLatin1CharTable::NumberFormatter;
+    }
+
+    if (options.testFlag(Qct::RemoveUnicodeFormatters)) {
+        skippedClasses |= QctLatin1CharTable::UnicodeFormatter;
+    }
+
+    const QChar *const end = value.constData() + value.length();
+
+    result.resize(value.length());
+    QChar *out = result.data();
+
+    for(const QChar *in = value.constData(); in != end; ++in) {
+        const ushort ch = in->unicode();
+
+        if (ch > 0xff) {
+            return false;
+        }
+
+        if (not (table[ch] & skippedClasses)) {
+            *out++ = *in;
+        }
+    }
+
+    result.resize(out - result.constData());
+
+    return true;
+}
+
+QString
+qctNormalizePhoneNumber(const QString& value, Qct::NumberNormalizationOptions options)
+{
+    QString result;
+
+    if (normalizePhoneNumberFast(value, options, result)) {
+        return result;
+    }
+
+    return normalizePhoneNumberSlow(value, options);
+}
+
 QString
 qctMakeLocalPhoneNumber(const QString& value)
 {
@@ -90,6 +182,116 @@ qctMakeLocalPhoneNumber(const QString& value)
     return number.mid(first);
 }
 
+/// Maps the letters of one script to the keys of a phone keypad.
+class QctKeypadMap
+{
+public:
+    /// \p keys lists the UTF-8 encoded lower-case letters for each key from 2 to 9.
+    explicit QctKeypadMap(const char *const keys[8])
+    {
+        for(int i = 0; i < 8; ++i) {
+            foreach(const QChar ch, QString::fromUtf8(keys[i])) {
+                m_digits.insert(ch.unicode(), QChar::fromLatin1('2' + i));
+            }
+        }
+    }
+
+    QChar digit(QChar ch) const { return m_digits.value(ch.unicode()); }
+
+private:
+    QHash<ushort, QChar> m_digits;
+};
+
+static const char *const latinKeys[8] = {
+    "abc", "def", "ghi", "jkl", "mno", "pqrs", "tuv", "wxyz"
+};
+
+static const char *const cyrillicKeys[8] = {
+    "\xd0\xb0\xd0\xb1\xd0\xb2\xd0\xb3\xd2\x91",                 // а б в г ґ
+    "\xd0\xb4\xd0\xb5\xd1\x91\xd0\xb6\xd0\xb7\xd1\x94",         // д е ё ж з є
+    "\xd0\xb8\xd0\xb9\xd0\xba\xd0\xbb\xd1\x96\xd1\x97",         // и й к л і ї
+    "\xd0\xbc\xd0\xbd\xd0\xbe\xd0\xbf",                         // м н о п
+    "\xd1\x80\xd1\x81\xd1\x82\xd1\x83\xd1\x9e",                 // р с т у ў
+    "\xd1\x84\xd1\x85\xd1\x86\xd1\x87",                         // ф х ц ч
+    "\xd1\x88\xd1\x89\xd1\x8a\xd1\x8b",                         // ш щ ъ ы
+    "\xd1\x8c\xd1\x8d\xd1\x8e\xd1\x8f"                          // ь э ю я
+};
+
+static const char *const greekKeys[8] = {
+    "\xce\xb1\xce\xb2\xce\xb3",                                 // α β γ
+    "\xce\xb4\xce\xb5\xce\xb6",                                 // δ ε ζ
+    "\xce\xb7\xce\xb8\xce\xb9",                                 // η θ ι
+    "\xce\xba\xce\xbb\xce\xbc",                                 // κ λ μ
+    "\xce\xbd\xce\xbe\xce\xbf",                                 // ν ξ ο
+    "\xcf\x80\xcf\x81\xcf\x83\xcf\x82",                         // π ρ σ ς
+    "\xcf\x84\xcf\x85\xcf\x86",                                 // τ υ φ
+    "\xcf\x87\xcf\x88\xcf\x89"                                  // χ ψ ω
+};
+
+Q_GLOBAL_STATIC_WITH_ARGS(QctKeypadMap, latinKeypadMap, (latinKeys))
+Q_GLOBAL_STATIC_WITH_ARGS(QctKeypadMap, cyrillicKeypadMap, (cyrillicKeys))
+Q_GLOBAL_STATIC_WITH_ARGS(QctKeypadMap, greekKeypadMap, (greekKeys))
+
+static const QctKeypadMap *
+nativeKeypadMap(const QLocale &locale)
+{
+    switch(locale.language()) {
+    case QLocale::Bulgarian:
+    case QLocale::Byelorussian:
+    case QLocale::Kazakh:
+    case QLocale::Macedonian:
+    case QLocale::Russian:
+    case QLocale::Serbian:
+    case QLocale::Ukrainian:
+        return cyrillicKeypadMap();
+
+    case QLocale::Greek:
+        return greekKeypadMap();
+
+    default:
+        break;
+    }
+
+    return 0;
+}
+
+QString
+qctMakeKeypadDigits(const QString &text, const QLocale &locale)
+{
+    const QctKeypadMap *const latinMap = latinKeypadMap();
+    const QctKeypadMap *const nativeMap = nativeKeypadMap(locale);
+
+    QString result;
+    result.reserve(text.length());
+
+    foreach(const QChar ch, text) {
+        if (ch.isDigit()) {
+            result += QChar::fromLatin1('0' + ch.digitValue());
+            continue;
+        }
+
+        if (not ch.isLetter()) {
+            continue;
+        }
+
+        // strip diacritics by taking the base letter of the canonical decomposition
+        const QChar letter = (ch.decompositionTag() == QChar::Canonical
+                              ? ch.decomposition().at(0) : ch).toLower();
+
+        QChar digit = latinMap->digit(letter);
+
+        if (digit.isNull() && 0 != nativeMap) {
+            digit = nativeMap->digit(letter);
+        }
+
+        if (not digit.isNull()) {
+            result += digit;
+        }
+    }
+
+    return result;
+}
+
 QString
 qctMakePhoneNumberIri(const QString &number, const QStringList &subtypes, bool escape)
 {
@@ -26,6 +26,7 @@
 #define QCTPHONEUTILS_H
 
 #include <QContactPhoneNumber>
+#include <QLocale>
 
 #include <cubi.h>
 
@@ -87,6 +88,17 @@ LIBQTCONTACTS_EXTENSIONS_TRACKER_EXPORT QString qctNormalizePhoneNumber(const QS
  */
 LIBQTCONTACTS_EXTENSIONS_TRACKER_EXPORT QString qctMakeLocalPhoneNumber(const QString& value);
 
+/*!
+ * \brief Returns the digits to press on a phone keypad for typing \p text
+ *
+ * Latin letters are mapped to keys as described by ITU E.161, after stripping their
+ * diacritics. If the language of \p locale is written in Cyrillic or Greek script, the
+ * letters of that script are mapped following the keypad layout common for it.
+ * Digits are converted to Latin digits, all other characters are skipped.
+ */
+LIBQTCONTACTS_EXTENSIONS_TRACKER_EXPORT QString qctMakeKeypadDigits(const QString &text,
+                                                                    const QLocale &locale = QLocale());
+
 /*!
  * \brief Generates a normalized IRI from a phone number and its subtypes
  *
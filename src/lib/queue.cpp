@@ -41,6 +41,7 @@ public:
 
 QctTask::QctTask(QObject *parent)
     : QObject(parent)
+    , m_priority(NormalPriority)
 {
 }
 
@@ -49,6 +50,22 @@ QctTask::~QctTask()
     Q_ASSERT(QThread::currentThread() == thread());
 }
 
+void
+QctTask::setPriority(int priority)
+{
+    m_priority = priority;
+}
+
+int
+QctTask::priority() const
+{
+    return m_priority;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+const int QctQueue::AgingInterval = 2000; // 2 seconds
+
 ////////////////////////////////////////////////////////////////////////////////
 
 QctQueue::QctQueue(QObject *parent)
@@ -132,6 +149,7 @@ QctQueue::enqueue(QctTask *task)
     // since moveToThread() only works from an object's current thread.
     task->setParent(0);
     task->moveToThread(&d->m_backgroundThread);
+    task->m_queueTimer.start();
     d->m_queue->enqueue(task);
 
     // Connect signals to remove finished tasks from queue.
@@ -177,6 +195,24 @@ QctQueue::processQueue()
     }
 
     if (d->m_queue != 0 && not d->m_queue->isEmpty()) {
+        // Move the most important waiting task to the head of the queue.
+        // On ties the task that was queued first wins.
+        int bestIndex = 0;
+        int bestPriority = effectivePriority(d->m_queue->first());
+
+        for(int i = 1; i < d->m_queue->count(); ++i) {
+            const int priority = effectivePriority(d->m_queue->at(i));
+
+            if (priority > bestPriority) {
+                bestPriority = priority;
+                bestIndex = i;
+            }
+        }
+
+        if (bestIndex > 0) {
+            d->m_queue->move(bestIndex, 0);
+        }
+
         // QctTask::run() shall run within the background thread. It is always queued, even
         // when processQueue() is called from that said thread, to prevent a dead locking,
         // when run() terminates instantly and emits() finished from inside.
@@ -189,6 +225,12 @@ QctQueue::processQueue()
     }
 }
 
+int
+QctQueue::effectivePriority(const QctTask *task)
+{
+    return task->priority() + int(task->m_queueTimer.elapsed() / AgingInterval);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 
 void
@@ -35,6 +35,11 @@
  * created it, but QctRequestTask does not delete the request. QctTask is a
  * controller, not a wrapper.
  *
+ * Tasks are run one after the other. When choosing the next task to run, the
+ * queue picks the waiting task with the highest QctTask::priority(). Tasks of
+ * equal priority run in FIFO order. To avoid starvation of low priority tasks
+ * waiting tasks gain one priority level per QctQueue::AgingInterval.
+ *
  * QctQueue is NOT reentrant, that means if you nest calls modifying the
  * queue, you'll hit a deadlock. To make the queue reentrant, we'd have to
  * move some method calls to the mainloop, but then that fails is no global
@@ -57,15 +62,32 @@ class LIBQTCONTACTS_EXTENSIONS_TRACKER_EXPORT QctTask : public QObject
 {
     Q_OBJECT
 
+public: // types
+    enum Priority {
+        LowPriority = -1,
+        NormalPriority = 0,
+        HighPriority = 1
+    };
+
 public:
     explicit QctTask(QObject *parent = 0);
     virtual ~QctTask();
 
+public: // attributes
+    void setPriority(int priority);
+    int priority() const;
+
 public slots: // abstract interface
     virtual void run() = 0;
 
 signals:
     void finished(QctTask *task = 0);
+
+private: // fields
+    friend class QctQueue;
+
+    int m_priority;
+    QElapsedTimer m_queueTimer;
 };
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -75,6 +97,9 @@ class LIBQTCONTACTS_EXTENSIONS_TRACKER_EXPORT QctQueue : public QObject
 {
     Q_OBJECT
 
+public: // constants
+    static const int AgingInterval;
+
 public:
     explicit QctQueue(QObject *parent = 0);
     virtual ~QctQueue();
@@ -85,6 +110,7 @@ public: // methods
 
 private:
     void processQueue();
+    static int effectivePriority(const QctTask *task);
 
 private slots:
     void onTaskDestroyed(QObject *object);
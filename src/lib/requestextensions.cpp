@@ -24,6 +24,11 @@
 
 #include "requestextensions.h"
 
+QctRequestExtensions::QctRequestExtensions()
+    : m_priority(NormalPriority)
+{
+}
+
 QctRequestExtensions *
 QctRequestExtensions::get(QContactAbstractRequest *request)
 {
@@ -49,3 +54,15 @@ QctRequestExtensions::nameOrder() const
 {
     return m_nameOrder;
 }
+
+void
+QctRequestExtensions::setPriority(Priority priority)
+{
+    m_priority = priority;
+}
+
+QctRequestExtensions::Priority
+QctRequestExtensions::priority() const
+{
+    return m_priority;
+}
@@ -34,13 +34,29 @@ QTM_USE_NAMESPACE
 class LIBQTCONTACTS_EXTENSIONS_TRACKER_EXPORT QctRequestExtensions : public QObjectUserData
 {
 public:
+    /// Scheduling class of a request. Higher priority requests are run before lower priority
+    /// requests queued earlier, e.g. to answer a caller-id lookup while a sync is saving contacts.
+    /// Low priority requests also get their tracker queries scheduled with low priority.
+    enum Priority {
+        LowPriority = -1,
+        NormalPriority = 0,
+        HighPriority = 1
+    };
+
+public:
+    QctRequestExtensions();
+
     static QctRequestExtensions * get(QContactAbstractRequest *request);
 
     void setNameOrder(const QString &order);
     QString nameOrder() const;
 
+    void setPriority(Priority priority);
+    Priority priority() const;
+
 private: // fields
     QString m_nameOrder;
+    Priority m_priority;
 };
 
 /// @deprecated: redundant with QctRequestExtensions::get()
@@ -0,0 +1,223 @@
+/*********************************************************************************
+ ** This file is part of QtContacts tracker storage plugin
+ **
+ ** Copyright (c) 2011 Nokia Corporation and/or its subsidiary(-ies).
+ **
+ ** Contact:  Nokia Corporation (info@qt.nokia.com)
+ **
+ ** GNU Lesser General Public License Usage
+ ** This file may be used under the terms of the GNU Lesser General Public License
+ ** version 2.1 as published by the Free Software Foundation and appearing in the
+ ** file LICENSE.LGPL included in the packaging of this file.  Please review the
+ ** following information to ensure the GNU Lesser General Public License version
+ ** 2.1 requirements will be met:
+ ** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+ **
+ ** In addition, as a special exception, Nokia gives you certain additional rights.
+ ** These rights are described in the Nokia Qt LGPL Exception version 1.1, included
+ ** in the file LGPL_EXCEPTION.txt in this package.
+ **
+ ** Other Usage
+ ** Alternatively, this file may be used in accordance with the terms and
+ ** conditions contained in a signed written agreement between you and Nokia.
+ *********************************************************************************/
+
+#include "searchsession.h"
+
+#include <QContactName>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+QctSearchSession::QctSearchSession(QContactManager *manager, QObject *parent)
+    : QObject(parent)
+    , m_manager(manager)
+    , m_definitionName(QContactName::DefinitionName)
+    , m_error(QContactManager::NoError)
+    , m_valid(false)
+    , m_incremental(false)
+{
+    // previous results cannot be refined anymore once contacts have changed
+    connect(m_manager, SIGNAL(contactsAdded(QList<QContactLocalId>)), this, SLOT(invalidate()));
+    connect(m_manager, SIGNAL(contactsChanged(QList<QContactLocalId>)), this, SLOT(invalidate()));
+    connect(m_manager, SIGNAL(contactsRemoved(QList<QContactLocalId>)), this, SLOT(invalidate()));
+    connect(m_manager, SIGNAL(dataChanged()), this, SLOT(invalidate()));
+}
+
+QctSearchSession::~QctSearchSession()
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void
+QctSearchSession::setDetailDefinitionName(const QString &definitionName, const QString &fieldName)
+{
+    m_definitionName = definitionName;
+    m_fieldName = fieldName;
+    invalidate();
+}
+
+QString
+QctSearchSession::detailDefinitionName() const
+{
+    return m_definitionName;
+}
+
+QString
+QctSearchSession::detailFieldName() const
+{
+    return m_fieldName;
+}
+
+void
+QctSearchSession::setFetchHint(const QContactFetchHint &fetchHint)
+{
+    m_fetchHint = fetchHint;
+    invalidate();
+}
+
+QContactFetchHint
+QctSearchSession::fetchHint() const
+{
+    return m_fetchHint;
+}
+
+void
+QctSearchSession::setSorting(const QList<QContactSortOrder> &sorting)
+{
+    m_sorting = sorting;
+    invalidate();
+}
+
+QList<QContactSortOrder>
+QctSearchSession::sorting() const
+{
+    return m_sorting;
+}
+
+QString
+QctSearchSession::term() const
+{
+    return m_term;
+}
+
+QList<QContact>
+QctSearchSession::contacts() const
+{
+    return m_contacts;
+}
+
+QContactManager::Error
+QctSearchSession::error() const
+{
+    return m_error;
+}
+
+bool
+QctSearchSession::isIncrementalResult() const
+{
+    return m_incremental;
+}
+
+bool
+QctSearchSession::isActive() const
+{
+    return not m_request.isNull() && m_request->isActive();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+QContactDetailFilter
+QctSearchSession::makeFilter(const QString &term) const
+{
+    QContactDetailFilter filter;
+    filter.setDetailDefinitionName(m_definitionName, m_fieldName);
+    filter.setMatchFlags(QContactFilter::MatchStartsWith);
+    filter.setValue(term);
+    return filter;
+}
+
+bool
+QctSearchSession::refine(const QString &term)
+{
+    // Filtering in memory only gives the same result when the previous results are
+    // still current, and are a superset of what we are looking for now.
+    if (not m_valid || not term.startsWith(m_term, Qt::CaseInsensitive)) {
+        return false;
+    }
+
+    const QContactDetailFilter filter = makeFilter(term);
+    QList<QContact> contacts;
+
+    foreach(const QContact &contact, m_contacts) {
+        if (QContactManagerEngine::testFilter(filter, contact)) {
+            contacts += contact;
+        }
+    }
+
+    m_contacts = contacts;
+    m_term = term;
+    m_incremental = true;
+
+    return true;
+}
+
+void
+QctSearchSession::search(const QString &term)
+{
+    // Whatever is running now is stale.
+    if (isActive()) {
+        m_request->cancel();
+    }
+
+    m_request.reset();
+
+    if (refine(term)) {
+        emit finished();
+        return;
+    }
+
+    // The detail to match must be fetched to permit refining the results later.
+    QContactFetchHint fetchHint = m_fetchHint;
+    QStringList detailHint = fetchHint.detailDefinitionsHint();
+
+    if (not detailHint.isEmpty() && not detailHint.contains(m_definitionName)) {
+        detailHint += m_definitionName;
+        fetchHint.setDetailDefinitionsHint(detailHint);
+    }
+
+    m_pendingTerm = term;
+
+    m_request.reset(new QContactFetchRequest);
+    m_request->setManager(m_manager);
+    m_request->setFilter(makeFilter(term));
+    m_request->setFetchHint(fetchHint);
+    m_request->setSorting(m_sorting);
+
+    connect(m_request.data(), SIGNAL(stateChanged(QContactAbstractRequest::State)),
+            this, SLOT(onStateChanged(QContactAbstractRequest::State)));
+
+    m_request->start();
+}
+
+void
+QctSearchSession::invalidate()
+{
+    m_valid = false;
+}
+
+void
+QctSearchSession::onStateChanged(QContactAbstractRequest::State state)
+{
+    if (state != QContactAbstractRequest::FinishedState) {
+        return;
+    }
+
+    m_term = m_pendingTerm;
+    m_contacts = m_request->contacts();
+    m_error = m_request->error();
+    m_valid = (m_error == QContactManager::NoError);
+    m_incremental = false;
+
+    emit finished();
+}
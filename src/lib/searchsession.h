@@ -0,0 +1,119 @@
+/*********************************************************************************
+ ** This file is part of QtContacts tracker storage plugin
+ **
+ ** Copyright (c) 2011 Nokia Corporation and/or its subsidiary(-ies).
+ **
+ ** Contact:  Nokia Corporation (info@qt.nokia.com)
+ **
+ ** GNU Lesser General Public License Usage
+ ** This file may be used under the terms of the GNU Lesser General Public License
+ ** version 2.1 as published by the Free Software Foundation and appearing in the
+ ** file LICENSE.LGPL included in the packaging of this file.  Please review the
+ ** following information to ensure the GNU Lesser General Public License version
+ ** 2.1 requirements will be met:
+ ** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+ **
+ ** In addition, as a special exception, Nokia gives you certain additional rights.
+ ** These rights are described in the Nokia Qt LGPL Exception version 1.1, included
+ ** in the file LGPL_EXCEPTION.txt in this package.
+ **
+ ** Other Usage
+ ** Alternatively, this file may be used in accordance with the terms and
+ ** conditions contained in a signed written agreement between you and Nokia.
+ *********************************************************************************/
+
+#ifndef QCTSEARCHSESSION_H
+#define QCTSEARCHSESSION_H
+
+#include <QContactManager>
+#include <QContactDetailFilter>
+#include <QContactFetchRequest>
+
+#include "libqtcontacts_extensions_tracker_global.h"
+
+QTM_USE_NAMESPACE
+
+/*!
+ * \class QctSearchSession
+ * \brief Helper for as-you-type contact search
+ *
+ * Each call of search() looks for contacts which have a detail starting with the given term,
+ * like a QContactDetailFilter with QContactFilter::MatchStartsWith would do. When the new
+ * term extends the term of the previous search, and no contact has changed in between,
+ * the previous results are filtered in memory instead of running another query.
+ * Otherwise, e.g. after pressing backspace, a new fetch request is started. A search which
+ * still is running when the next search is started gets canceled.
+ *
+ * The finished() signal is emitted when the results of a search are available. For in
+ * memory searches this happens before search() returns.
+ */
+class LIBQTCONTACTS_EXTENSIONS_TRACKER_EXPORT QctSearchSession : public QObject
+{
+    Q_OBJECT
+
+public:
+    /*! Constructs a new search session for contacts of \a manager */
+    explicit QctSearchSession(QContactManager *manager, QObject *parent = 0);
+    virtual ~QctSearchSession();
+
+public: // attributes
+    /*! Selects the detail to match, by default the QContactName detail */
+    void setDetailDefinitionName(const QString &definitionName, const QString &fieldName = QString());
+    QString detailDefinitionName() const;
+    QString detailFieldName() const;
+
+    /*! Sets the fetch hint for the contacts. The detail to match always is fetched. */
+    void setFetchHint(const QContactFetchHint &fetchHint);
+    QContactFetchHint fetchHint() const;
+
+    void setSorting(const QList<QContactSortOrder> &sorting);
+    QList<QContactSortOrder> sorting() const;
+
+    /*! The term of the last finished search */
+    QString term() const;
+    /*! The contacts found by the last finished search */
+    QList<QContact> contacts() const;
+    /*! The error of the last finished search */
+    QContactManager::Error error() const;
+    /*! Returns true if the last finished search was answered from the previous results */
+    bool isIncrementalResult() const;
+    /*! Returns true if a search request is running */
+    bool isActive() const;
+
+public slots:
+    /*! Starts searching for contacts matching \a term */
+    void search(const QString &term);
+    /*! Forgets the previous results, so that the next search runs a full query */
+    void invalidate();
+
+signals:
+    void finished();
+
+private slots:
+    void onStateChanged(QContactAbstractRequest::State state);
+
+private: // methods
+    QContactDetailFilter makeFilter(const QString &term) const;
+    bool refine(const QString &term);
+
+private: // fields
+    QContactManager *const m_manager;
+    QString m_definitionName;
+    QString m_fieldName;
+    QContactFetchHint m_fetchHint;
+    QList<QContactSortOrder> m_sorting;
+
+    QScopedPointer<QContactFetchRequest> m_request;
+    QString m_pendingTerm;
+
+    QString m_term;
+    QList<QContact> m_contacts;
+    QContactManager::Error m_error;
+
+    bool m_valid : 1;
+    bool m_incremental : 1;
+
+    Q_DISABLE_COPY(QctSearchSession)
+};
+
+#endif // QCTSEARCHSESSION_H
@@ -42,6 +42,7 @@ const QString QctSettings::GuidAlgorithmNameKey = QLatin1String("guidAlgorithmNa
 const QString QctSettings::LastMSISDNKey        = QLatin1String("lastMSISDN");
 const QString QctSettings::SparqlBackendsKey    = QLatin1String("sparqlBackends");
 const QString QctSettings::PreferNicknameKey    = QLatin1String("preferNickname");
+const QString QctSettings::PackAvatarsKey       = QLatin1String("packAvatars");
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 
@@ -157,6 +158,7 @@ QctSettings::QctSettings(QObject *parent)
         registerSetting(LastMSISDNKey);
         registerSetting(SparqlBackendsKey, DefaultSparqlBackends);
         registerSetting(PreferNicknameKey, DefaultPreferNickname);
+        registerSetting(PackAvatarsKey, DefaultPackAvatars);
 
         isSettingsRegistered = true;
     }
@@ -301,3 +303,15 @@ QctSettings::preferNickname() const
 {
     return value(PreferNicknameKey).toBool();
 }
+
+void
+QctSettings::setPackAvatars(bool packAvatars)
+{
+    setValue(PackAvatarsKey, packAvatars);
+}
+
+bool
+QctSettings::packAvatars() const
+{
+    return value(PackAvatarsKey).toBool();
+}
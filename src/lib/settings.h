@@ -64,6 +64,7 @@ public: // key constants
     static const QString LastMSISDNKey;
     static const QString SparqlBackendsKey;
     static const QString PreferNicknameKey;
+    static const QString PackAvatarsKey;
 
 public: // default values
     static const int DefaultPhoneNumberLength = 7;
@@ -71,6 +72,7 @@ public: // default values
     static const QString DefaultNameOrder;
     static const QStringList DefaultSparqlBackends;
     static const bool DefaultPreferNickname = false;
+    static const bool DefaultPackAvatars = false;
 
 public: // constructors
     explicit QctSettings(QObject *parent = 0);
@@ -107,6 +109,12 @@ public: // attributes
     void setPreferNickname(bool preferNickname);
     bool preferNickname() const;
 
+    /// stores avatar thumbnails in a single pack file, instead of one image file per avatar.
+    /// The image URLs of avatars stored this way use the "avatarpack:" scheme instead of
+    /// pointing to a file. Applications must use qctReadThumbnail() to load them.
+    void setPackAvatars(bool packAvatars);
+    bool packAvatars() const;
+
 public:
     /// does immediate synchronisation with the storage system, instead of automatically only after some timeout.
     void sync();
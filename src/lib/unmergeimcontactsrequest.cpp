@@ -54,6 +54,18 @@ public: // attributes
         return m_unmergeOnlineAccounts;
     }
 
+    void setSourceContactOnlineAccounts(const QMap<QContactLocalId, QList<QContactOnlineAccount> > &accounts)
+    {
+        QCT_SYNCHRONIZED_WRITE(&m_lock);
+        m_sourceContactOnlineAccounts = accounts;
+    }
+
+    QMap<QContactLocalId, QList<QContactOnlineAccount> > sourceContactOnlineAccounts() const
+    {
+        QCT_SYNCHRONIZED_READ(&m_lock);
+        return m_sourceContactOnlineAccounts;
+    }
+
     void setUnmergedContactIds(const QList<QContactLocalId> &ids)
     {
         QCT_SYNCHRONIZED_WRITE(&m_lock);
@@ -79,6 +91,7 @@ private: // fields
     // modified by Qt Mobility
     QContact m_sourceContact;
     QList<QContactOnlineAccount> m_unmergeOnlineAccounts;
+    QMap<QContactLocalId, QList<QContactOnlineAccount> > m_sourceContactOnlineAccounts;
     QList<QContactLocalId> m_unmergedContactIds;
 };
 
@@ -114,6 +127,18 @@ QctUnmergeIMContactsRequest::sourceContact() const
     return data()->sourceContact();
 }
 
+void
+QctUnmergeIMContactsRequest::setSourceContactOnlineAccounts(const QMap<QContactLocalId, QList<QContactOnlineAccount> > &accounts)
+{
+    data()->setSourceContactOnlineAccounts(accounts);
+}
+
+QMap<QContactLocalId, QList<QContactOnlineAccount> >
+QctUnmergeIMContactsRequest::sourceContactOnlineAccounts() const
+{
+    return data()->sourceContactOnlineAccounts();
+}
+
 QList<QContactLocalId>
 QctUnmergeIMContactsRequest::unmergedContactIds() const
 {
@@ -43,6 +43,10 @@ QTM_USE_NAMESPACE
  * of QContactOnlineAccount to detach from this contact. For each detached (unmerged) online
  * account, a new contact will be created.
  *
+ * To unmerge accounts from many contacts at once, for instance when an IM account got removed,
+ * use setSourceContactOnlineAccounts() instead. All source contacts are then processed with
+ * batched queries in a single request.
+ *
  * \note QContactAbstractRequest doesnt support extension. Instead, QctUnmergeIMContactsRequest is extending
  * QContactSaveRequest, so QContactAbstractRequest::type() will return QContactAbstractRequest::ContactSaveRequest .
  */
@@ -67,7 +71,16 @@ public:
     /*! Contact which \sa unmergeOnlineAccounts() details should be unmerged to new contacts */
     QContact sourceContact() const;
 
-    /*! Result of operation - new contacts created containing data related to \sa unmergeOnlineAccounts()*/
+    /*! Sets the online accounts to detach, for several source contacts at once.
+     * When not empty this takes precedence over \sa sourceContact() and \sa unmergeOnlineAccounts() */
+    void setSourceContactOnlineAccounts(const QMap<QContactLocalId, QList<QContactOnlineAccount> > &accounts);
+
+    /*! The online accounts to detach per source contact - \sa setSourceContactOnlineAccounts() */
+    QMap<QContactLocalId, QList<QContactOnlineAccount> > sourceContactOnlineAccounts() const;
+
+    /*! Result of operation - new contacts created containing data related to \sa unmergeOnlineAccounts()
+     * When using \sa setSourceContactOnlineAccounts() the ids are ordered by source contact id,
+     * and then by the order of the accounts given for each source contact. */
     QList<QContactLocalId> unmergedContactIds() const;
 
 protected:
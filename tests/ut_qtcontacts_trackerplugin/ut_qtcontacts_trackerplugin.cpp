@@ -35,14 +35,21 @@
 #include <engine/relationshipsaverequest.h>
 #include <engine/relationshipfetchrequest.h>
 
+#include <lib/avatarpack_p.h>
+#include <lib/avatarutils.h>
 #include <lib/constants.h>
 #include <lib/contactmergerequest.h>
 #include <lib/customdetails.h>
+#include <lib/garbagecollector.h>
+#include <lib/keypadmatchrequest.h>
+#include <lib/phonenumbermatchrequest.h>
 #include <lib/phoneutils.h>
 #include <lib/contactlocalidfetchrequest.h>
 #include <lib/settings.h>
 #include <lib/sparqlresolver.h>
 #include <lib/trackerchangelistener.h>
+#include <lib/requestextensions.h>
+#include <lib/searchsession.h>
 #include <lib/unmergeimcontactsrequest.h>
 
 #include <ontologies/nco.h>
@@ -68,6 +75,7 @@ CUBI_USE_NAMESPACE_RESOURCES
 #define LRE "\342\200\252"
 #define RLE "\342\200\253"
 #define PDF "\342\200\254"
+#define SHY "\302\255"
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
@@ -1810,6 +1818,27 @@ ut_qtcontacts_trackerplugin::testAvatar()
     avatars = contactWithAvatar.details<QContactAvatar>();
     QCOMPARE(avatars.size(), 3);
 
+    // each avatar only links to its own online account, and no detail of the merged
+    // contact links to the online avatars the avatars were computed from
+    QSet<QString> detailUris;
+
+    foreach(const QContactDetail &detail, contactWithAvatar.details()) {
+        if (not detail.detailUri().isEmpty()) {
+            detailUris += detail.detailUri();
+        }
+    }
+
+    foreach(const QContactAvatar &avatar, avatars) {
+        QCOMPARE(avatar.linkedDetailUris().count(), 1);
+        QVERIFY(avatar.linkedDetailUris().first().startsWith(QLatin1String("telepathy:")));
+    }
+
+    foreach(const QContactDetail &detail, contactWithAvatar.details()) {
+        foreach(const QString &linkedDetailUri, detail.linkedDetailUris()) {
+            QVERIFY2(detailUris.contains(linkedDetailUri), qPrintable(linkedDetailUri));
+        }
+    }
+
     QContactName nameDetail = contactWithAvatar.detail<QContactName>();
     nameDetail.setCustomLabel(__func__);
 
@@ -4299,6 +4328,14 @@ ut_qtcontacts_trackerplugin::testNormalizePhoneNumber_data()
             << QString::fromUtf8("+" A9 A7 A1 A1 A1 A3 A3 A4 A4 A5 A5)
             << QString::fromUtf8("+971-11.33.44.55")
             << QString::fromUtf8("+97111334455");
+
+    // only Latin-1 characters, with a soft hyphen as unicode formatter
+    QTest::newRow("latin-1")
+            << QString::fromUtf8("+44 (20)" SHY "7946.0958")
+            << QString::fromUtf8("+44 (20)7946.0958")
+            << QString::fromUtf8("+442079460958")
+            << QString::fromUtf8("+44 (20)7946.0958")
+            << QString::fromUtf8("+442079460958");
 }
 
 void
@@ -4421,6 +4458,230 @@ ut_qtcontacts_trackerplugin::testFilterDTMFNumber()
     QCOMPARE(request.contacts().first().localId(), idExactMatchShort);
 }
 
+static QList<QContactLocalId>
+matchPhoneNumber(QContactTrackerEngine *engine, const QString &phoneNumber,
+                 QContactManager::Error *error)
+{
+    QctPhoneNumberMatchRequest request;
+    request.setPhoneNumber(phoneNumber);
+
+    if (not engine->startRequest(&request) ||
+        not engine->waitForRequestFinishedImpl(&request, 0)) {
+        *error = QContactManager::UnspecifiedError;
+        return QList<QContactLocalId>();
+    }
+
+    *error = request.error();
+    return request.ids();
+}
+
+void
+ut_qtcontacts_trackerplugin::testPhoneNumberMatchRequest()
+{
+    QContactLocalId idExactMatch, idExactMatchShort, idStrippedMatch, idLateAddition;
+    QContactManager::Error error(QContactManager::UnspecifiedError);
+    QList<QContactLocalId> ids;
+
+    const QStringList numbers = QStringList()
+            << QLatin1String("223456789p678")
+            << QLatin1String("223456789")
+            << QLatin1String("964p98");
+
+    QList<QContactLocalId> savedIds;
+
+    foreach(const QString &n, numbers) {
+        QContact contact;
+        QContactPhoneNumber number;
+        number.setNumber(n);
+        contact.saveDetail(&number);
+
+        QVERIFY(engine()->saveContact(&contact, &error));
+        QCOMPARE(error, QContactManager::NoError);
+        savedIds += contact.localId();
+    }
+
+    idExactMatch = savedIds.at(0);
+    idStrippedMatch = savedIds.at(1);
+    idExactMatchShort = savedIds.at(2);
+
+    // Check that exact match works
+    ids = matchPhoneNumber(engine(), QLatin1String("223456789p678"), &error);
+    QCOMPARE(error, QContactManager::NoError);
+    QVERIFY(ids.contains(idExactMatch));
+    QVERIFY(not ids.contains(idStrippedMatch));
+
+    // Check that "drop DTMF if no exact match" works
+    ids = matchPhoneNumber(engine(), QLatin1String("223456789p999"), &error);
+    QCOMPARE(error, QContactManager::NoError);
+    QVERIFY(ids.contains(idStrippedMatch));
+    QVERIFY(not ids.contains(idExactMatch));
+
+    // Check that international prefixes and formatters are ignored
+    ids = matchPhoneNumber(engine(), QLatin1String("+358 (0) 22-345-6789"), &error);
+    QCOMPARE(error, QContactManager::NoError);
+    QVERIFY(ids.contains(idStrippedMatch));
+
+    // Check that exact match for short numbers works
+    ids = matchPhoneNumber(engine(), QLatin1String("964p98"), &error);
+    QCOMPARE(error, QContactManager::NoError);
+    QVERIFY(ids.contains(idExactMatchShort));
+
+    // Check that the index notices contacts added after it got built
+    {
+        QContact contact;
+        QContactPhoneNumber number;
+        number.setNumber(QLatin1String("5550199887"));
+        contact.saveDetail(&number);
+
+        QVERIFY(engine()->saveContact(&contact, &error));
+        QCOMPARE(error, QContactManager::NoError);
+        idLateAddition = contact.localId();
+    }
+
+    // wait for tracker's change notification
+    QTest::qWait(1000);
+
+    ids = matchPhoneNumber(engine(), QLatin1String("5550199887"), &error);
+    QCOMPARE(error, QContactManager::NoError);
+    QVERIFY(ids.contains(idLateAddition));
+
+    // Check that the index notices removed contacts
+    QVERIFY(engine()->removeContact(idLateAddition, &error));
+    QCOMPARE(error, QContactManager::NoError);
+
+    QTest::qWait(1000);
+
+    ids = matchPhoneNumber(engine(), QLatin1String("5550199887"), &error);
+    QCOMPARE(error, QContactManager::NoError);
+    QVERIFY(not ids.contains(idLateAddition));
+
+    // Check that empty numbers are rejected
+    matchPhoneNumber(engine(), QString(), &error);
+    QCOMPARE(error, QContactManager::BadArgumentError);
+}
+
+void
+ut_qtcontacts_trackerplugin::testMakeKeypadDigits_data()
+{
+    QTest::addColumn<QString>("text");
+    QTest::addColumn<QString>("locale");
+    QTest::addColumn<QString>("digits");
+
+    QTest::newRow("latin")
+            << QString::fromLatin1("John Smith") << QString::fromLatin1("en_GB")
+            << QString::fromLatin1("56467648");
+    QTest::newRow("diacritics")
+            << QString::fromUtf8("Zo\xc3\xab \xc3\x85str\xc3\xb6m") << QString::fromLatin1("sv_SE")
+            << QString::fromLatin1("963278766");
+    QTest::newRow("digits")
+            << QString::fromLatin1("+358 (40) 123") << QString::fromLatin1("fi_FI")
+            << QString::fromLatin1("35840123");
+    QTest::newRow("cyrillic")
+            << QString::fromUtf8("\xd0\x98\xd0\xb2\xd0\xb0\xd0\xbd") << QString::fromLatin1("ru_RU")
+            << QString::fromLatin1("4226");
+    QTest::newRow("cyrillic-in-latin-locale")
+            << QString::fromUtf8("\xd0\x98\xd0\xb2\xd0\xb0\xd0\xbd") << QString::fromLatin1("en_GB")
+            << QString();
+    QTest::newRow("greek")
+            << QString::fromUtf8("\xce\x9d\xce\xaf\xce\xba\xce\xbf\xcf\x82") << QString::fromLatin1("el_GR")
+            << QString::fromLatin1("64567");
+}
+
+void
+ut_qtcontacts_trackerplugin::testMakeKeypadDigits()
+{
+    QFETCH(QString, text);
+    QFETCH(QString, locale);
+    QFETCH(QString, digits);
+
+    QCOMPARE(qctMakeKeypadDigits(text, QLocale(locale)), digits);
+}
+
+static QList<QContactLocalId>
+matchKeypadDigits(QContactTrackerEngine *engine, const QString &digits,
+                  QContactManager::Error *error)
+{
+    QctKeypadMatchRequest request;
+    request.setDigits(digits);
+
+    if (not engine->startRequest(&request) ||
+        not engine->waitForRequestFinishedImpl(&request, 0)) {
+        *error = QContactManager::UnspecifiedError;
+        return QList<QContactLocalId>();
+    }
+
+    *error = request.error();
+    return request.ids();
+}
+
+void
+ut_qtcontacts_trackerplugin::testKeypadMatchRequest()
+{
+    QContactManager::Error error(QContactManager::UnspecifiedError);
+    QList<QContactLocalId> ids;
+
+    QContact contact;
+    QContactName name;
+    name.setFirstName(QLatin1String("Jonathan"));
+    name.setLastName(QLatin1String("Quixote-Wexler"));
+    QVERIFY(contact.saveDetail(&name));
+    QContactPhoneNumber number;
+    number.setNumber(QLatin1String("+358 (40) 987-6543p12"));
+    QVERIFY(contact.saveDetail(&number));
+    QVERIFY(engine()->saveContact(&contact, &error));
+    QCOMPARE(error, QContactManager::NoError);
+    addedContacts.append(contact.localId());
+
+    // Check that the start of each name word matches
+    ids = matchKeypadDigits(engine(), QLatin1String("5662"), &error);
+    QCOMPARE(error, QContactManager::NoError);
+    QVERIFY(ids.contains(contact.localId()));
+
+    ids = matchKeypadDigits(engine(), QLatin1String("939"), &error);
+    QCOMPARE(error, QContactManager::NoError);
+    QVERIFY(ids.contains(contact.localId()));
+
+    // Check that typing across first and last name matches
+    ids = matchKeypadDigits(engine(), QLatin1String("56628426784"), &error);
+    QCOMPARE(error, QContactManager::NoError);
+    QVERIFY(ids.contains(contact.localId()));
+
+    // Check that names only match at word starts
+    ids = matchKeypadDigits(engine(), QLatin1String("6628426784"), &error);
+    QCOMPARE(error, QContactManager::NoError);
+    QVERIFY(not ids.contains(contact.localId()));
+
+    // Check that any part of the phone number matches, but not the DTMF code
+    ids = matchKeypadDigits(engine(), QLatin1String("4098765"), &error);
+    QCOMPARE(error, QContactManager::NoError);
+    QVERIFY(ids.contains(contact.localId()));
+
+    ids = matchKeypadDigits(engine(), QLatin1String("654312"), &error);
+    QCOMPARE(error, QContactManager::NoError);
+    QVERIFY(not ids.contains(contact.localId()));
+
+    // Check that the index notices changed contacts
+    name.setFirstName(QLatin1String("Sancho"));
+    QVERIFY(contact.saveDetail(&name));
+    QVERIFY(engine()->saveContact(&contact, &error));
+    QCOMPARE(error, QContactManager::NoError);
+
+    // wait for tracker's change notification
+    QTest::qWait(1000);
+
+    ids = matchKeypadDigits(engine(), QLatin1String("5662"), &error);
+    QCOMPARE(error, QContactManager::NoError);
+    QVERIFY(not ids.contains(contact.localId()));
+
+    ids = matchKeypadDigits(engine(), QLatin1String("72624"), &error);
+    QCOMPARE(error, QContactManager::NoError);
+    QVERIFY(ids.contains(contact.localId()));
+
+    // Check that empty input is rejected
+    matchKeypadDigits(engine(), QLatin1String("-"), &error);
+    QCOMPARE(error, QContactManager::BadArgumentError);
+}
+
 void
 ut_qtcontacts_trackerplugin::testFilterContactsMatchPhoneNumberWithShortNumber_data()
 {
@@ -5776,6 +6037,85 @@ ut_qtcontacts_trackerplugin::testMergeOnlineContacts()
     QCOMPARE(result->value(0).toInt(), 1);
 }
 
+void
+ut_qtcontacts_trackerplugin::testBulkUnmergeOnlineContacts()
+{
+    QMap<QContactLocalId, QList<QContactOnlineAccount> > unmergeAccounts;
+    QList<QContact> masterContacts;
+
+    for (int i = 0; i < 2; ++i) {
+        QList<QContactLocalId> idsToMerge;
+
+        for (int j = 0; j < 3; ++j) {
+            const QString suffix = QString::fromLatin1("%1.%2").arg(i + 1).arg(j + 1);
+            const QString contactIri =
+                    QString::fromLatin1("contact:%1:%2").
+                    arg(QLatin1String(__func__), suffix);
+            const QString imId =
+                    QString::fromLatin1("%1.%2@ovi.com").
+                    arg(QLatin1String(__func__), suffix);
+            const QString accountId =
+                    QString::fromLatin1("/org/freedesktop/testBulkUnmergeOnlineContacts/account/%1").
+                    arg(suffix);
+
+            const uint contactId = insertIMContact(contactIri, imId,
+                                                   QLatin1String("nco:presence-status-available"),
+                                                   QLatin1String("Lost in Transition"), accountId);
+            QVERIFY(contactId != 0);
+            idsToMerge += contactId;
+        }
+
+        QContact masterContact = contact(idsToMerge.takeFirst());
+        mergeContacts(masterContact, idsToMerge);
+
+        const QList<QContactOnlineAccount> onlineAccounts = masterContact.details<QContactOnlineAccount>();
+        QCOMPARE(onlineAccounts.size(), 3);
+
+        // detach all but one account
+        unmergeAccounts.insert(masterContact.localId(), onlineAccounts.mid(1));
+        masterContacts += masterContact;
+    }
+
+    QctUnmergeIMContactsRequest unmergeRequest;
+    unmergeRequest.setSourceContactOnlineAccounts(unmergeAccounts);
+    QCOMPARE(unmergeRequest.sourceContactOnlineAccounts(), unmergeAccounts);
+
+    QVERIFY(engine()->startRequest(&unmergeRequest));
+    QVERIFY(engine()->waitForRequestFinished(&unmergeRequest, 5000));
+    QCOMPARE(unmergeRequest.error(), QContactManager::NoError);
+
+    // two contacts got created for each source contact
+    const QList<QContactLocalId> unmergedContactIds = unmergeRequest.unmergedContactIds();
+    QCOMPARE(unmergedContactIds.size(), 4);
+
+    const QList<QContact> unmergedContacts = contacts(unmergedContactIds);
+    QCOMPARE(unmergedContacts.size(), unmergedContactIds.size());
+
+    foreach (const QContact &contact, unmergedContacts) {
+        QCOMPARE(contact.details<QContactOnlineAccount>().size(), 1);
+    }
+
+    foreach (const QContact &masterContact, masterContacts) {
+        const QContact fetchedContact = contact(masterContact.localId());
+        const QList<QContactOnlineAccount> accounts = fetchedContact.details<QContactOnlineAccount>();
+        QCOMPARE(accounts.size(), 1);
+        QCOMPARE(accounts.first().accountUri(),
+                 masterContact.details<QContactOnlineAccount>().first().accountUri());
+    }
+
+    // unknown source contacts make the whole request fail
+    QMap<QContactLocalId, QList<QContactOnlineAccount> > invalidAccounts;
+    invalidAccounts.insert(masterContacts.first().localId(), QList<QContactOnlineAccount>());
+    invalidAccounts.insert(0xdeadbeef, QList<QContactOnlineAccount>());
+
+    QctUnmergeIMContactsRequest invalidRequest;
+    invalidRequest.setSourceContactOnlineAccounts(invalidAccounts);
+
+    QVERIFY(engine()->startRequest(&invalidRequest));
+    QVERIFY(engine()->waitForRequestFinished(&invalidRequest, 5000));
+    QCOMPARE(invalidRequest.error(), QContactManager::DoesNotExistError);
+}
+
 void
 ut_qtcontacts_trackerplugin::testIMContactsAndMetacontactMasterPresence()
 {
@@ -9870,6 +10210,25 @@ ut_qtcontacts_trackerplugin::testOnlineAccount()
     QCOMPARE(c.detail<QContactOnlineAccount>().accountUri(), accountUri);
 }
 
+RequestFinishRecorder::RequestFinishRecorder(QList<QContactAbstractRequest *> &finishedRequests,
+                                             QContactAbstractRequest *request)
+    : QObject(request)
+    , m_finishedRequests(finishedRequests)
+    , m_request(request)
+{
+    connect(m_request, SIGNAL(stateChanged(QContactAbstractRequest::State)),
+            this, SLOT(onStateChanged(QContactAbstractRequest::State)),
+            Qt::DirectConnection);
+}
+
+void
+RequestFinishRecorder::onStateChanged(QContactAbstractRequest::State state)
+{
+    if (QContactAbstractRequest::FinishedState == state) {
+        m_finishedRequests += m_request;
+    }
+}
+
 EvilRequestKiller::EvilRequestKiller(QContactAbstractRequest *request,
                                      Qt::ConnectionType connectionType,
                                      QContactAbstractRequest::State deletionState,
@@ -9937,6 +10296,1221 @@ ut_qtcontacts_trackerplugin::testDeleteFromStateChangedHandler()
     }
 }
 
+void
+ut_qtcontacts_trackerplugin::testRequestPriority()
+{
+    QList<QContactAbstractRequest *> finishedRequests;
+    QList<QContactAbstractRequest *> normalRequests;
+
+    // queue some regular requests
+    for(int i = 0; i < 5; ++i) {
+        QContactFetchRequest *const request = new QContactFetchRequest(this);
+        new RequestFinishRecorder(finishedRequests, request);
+        normalRequests += request;
+
+        QVERIFY(engine()->startRequest(request));
+    }
+
+    // the high priority request must overtake all regular requests still waiting
+    QContactLocalIdFetchRequest highPriorityRequest;
+    QctRequestExtensions::get(&highPriorityRequest)->setPriority(QctRequestExtensions::HighPriority);
+    new RequestFinishRecorder(finishedRequests, &highPriorityRequest);
+
+    QVERIFY(engine()->startRequest(&highPriorityRequest));
+
+    foreach(QContactAbstractRequest *request, normalRequests) {
+        QVERIFY(engine()->waitForRequestFinished(request, 5000));
+    }
+
+    QVERIFY(engine()->waitForRequestFinished(&highPriorityRequest, 5000));
+    QCOMPARE(highPriorityRequest.error(), QContactManager::NoError);
+
+    QCOMPARE(finishedRequests.count(), normalRequests.count() + 1);
+
+    // only the regular request which already was running can finish before
+    QVERIFY(finishedRequests.indexOf(&highPriorityRequest) <= 1);
+
+    qDeleteAll(normalRequests);
+}
+
+void
+ut_qtcontacts_trackerplugin::testIdenticalFetchRequests()
+{
+    const QString firstName = QLatin1String(__func__);
+    QContactManager::Error error = QContactManager::UnspecifiedError;
+
+    // reused results are reported as notes
+    QMap<QString, QString> params = makeEngineParams();
+    params.insert(QLatin1String("debug"), QLatin1String("no-nagging,notes"));
+    QContactTrackerEngine engine(params);
+
+    QContact contact;
+    QContactName name;
+    name.setFirstName(firstName);
+    QVERIFY(contact.saveDetail(&name));
+    QVERIFY(engine.saveContact(&contact, &error));
+    QCOMPARE(error, QContactManager::NoError);
+    addedContacts.append(contact.localId());
+
+    QContactDetailFilter filter;
+    filter.setDetailDefinitionName(QContactName::DefinitionName, QContactName::FieldFirstName);
+    filter.setValue(firstName);
+
+    // keep the queue busy, so that the identical requests are queued before any of them runs
+    QList<QContactFetchRequest *> requests;
+
+    for(int i = 0; i < 3; ++i) {
+        QContactFetchRequest *const request = new QContactFetchRequest(this);
+        requests += request;
+
+        QVERIFY(engine.startRequest(request));
+    }
+
+    // identical requests share their results, only the first one queries tracker
+    QList<QContactFetchRequest *> identicalRequests;
+
+    for(int i = 0; i < 3; ++i) {
+        QContactFetchRequest *const request = new QContactFetchRequest(this);
+        request->setFilter(filter);
+        identicalRequests += request;
+        requests += request;
+
+        QVERIFY(engine.startRequest(request));
+    }
+
+    for(int i = 1; i < identicalRequests.count(); ++i) {
+        QTest::ignoreMessage(QtDebugMsg, "QTrackerContactFetchRequest : "
+                             "reusing results of identical request");
+    }
+
+    // this one differs in its fetch hint and therefore must run its own query
+    QContactFetchHint fetchHint;
+    fetchHint.setDetailDefinitionsHint(QStringList(QContactName::DefinitionName));
+
+    QContactFetchRequest otherRequest;
+    otherRequest.setFilter(filter);
+    otherRequest.setFetchHint(fetchHint);
+    QVERIFY(engine.startRequest(&otherRequest));
+
+    foreach(QContactFetchRequest *request, requests) {
+        QVERIFY(engine.waitForRequestFinished(request, 5000));
+        QCOMPARE(request->error(), QContactManager::NoError);
+    }
+
+    foreach(QContactFetchRequest *request, identicalRequests) {
+        QCOMPARE(request->contacts().count(), 1);
+        QCOMPARE(request->contacts().first().localId(), contact.localId());
+    }
+
+    QVERIFY(engine.waitForRequestFinished(&otherRequest, 5000));
+    QCOMPARE(otherRequest.error(), QContactManager::NoError);
+    QCOMPARE(otherRequest.contacts().count(), 1);
+    QCOMPARE(otherRequest.contacts().first().details<QContactName>().count(), 1);
+
+    // once finished results are not shared anymore
+    QContact otherContact;
+    QVERIFY(otherContact.saveDetail(&name));
+    QVERIFY(engine.saveContact(&otherContact, &error));
+    QCOMPARE(error, QContactManager::NoError);
+    addedContacts.append(otherContact.localId());
+
+    QContactFetchRequest laterRequest;
+    laterRequest.setFilter(filter);
+    QVERIFY(engine.startRequest(&laterRequest));
+    QVERIFY(engine.waitForRequestFinished(&laterRequest, 5000));
+    QCOMPARE(laterRequest.error(), QContactManager::NoError);
+    QCOMPARE(laterRequest.contacts().count(), 2);
+
+    // requests queued after a write must not reuse results of requests queued before it
+    QContactFetchRequest busyRequest;
+    QVERIFY(engine.startRequest(&busyRequest));
+
+    QContactFetchRequest requestBeforeSave;
+    requestBeforeSave.setFilter(filter);
+    QVERIFY(engine.startRequest(&requestBeforeSave));
+
+    QContact thirdContact;
+    QVERIFY(thirdContact.saveDetail(&name));
+
+    QContactSaveRequest saveRequest;
+    saveRequest.setContacts(QList<QContact>() << thirdContact);
+    QVERIFY(engine.startRequest(&saveRequest));
+
+    QContactFetchRequest requestAfterSave;
+    requestAfterSave.setFilter(filter);
+    QVERIFY(engine.startRequest(&requestAfterSave));
+
+    QVERIFY(engine.waitForRequestFinished(&busyRequest, 5000));
+    QVERIFY(engine.waitForRequestFinished(&requestBeforeSave, 5000));
+    QVERIFY(engine.waitForRequestFinished(&saveRequest, 5000));
+    QVERIFY(engine.waitForRequestFinished(&requestAfterSave, 5000));
+
+    QCOMPARE(saveRequest.error(), QContactManager::NoError);
+    QCOMPARE(saveRequest.contacts().count(), 1);
+    addedContacts.append(saveRequest.contacts().first().localId());
+
+    QCOMPARE(requestBeforeSave.error(), QContactManager::NoError);
+    QCOMPARE(requestBeforeSave.contacts().count(), 2);
+    QCOMPARE(requestAfterSave.error(), QContactManager::NoError);
+    QCOMPARE(requestAfterSave.contacts().count(), 3);
+
+    qDeleteAll(requests);
+}
+
+void
+ut_qtcontacts_trackerplugin::testCancelQueuedRequest()
+{
+    QList<QContactAbstractRequest *> finishedRequests;
+
+    // keep the queue busy
+    QContactFetchRequest runningRequest;
+    new RequestFinishRecorder(finishedRequests, &runningRequest);
+    QVERIFY(engine()->startRequest(&runningRequest));
+
+    QContactFetchRequest queuedRequest;
+    queuedRequest.setFilter(QContactLocalIdFilter());
+    new RequestFinishRecorder(finishedRequests, &queuedRequest);
+    QVERIFY(engine()->startRequest(&queuedRequest));
+
+    // requests waiting in the queue are canceled immediately
+    QVERIFY(engine()->cancelRequest(&queuedRequest));
+    QCOMPARE(queuedRequest.state(), QContactAbstractRequest::CanceledState);
+
+    // canceling again does nothing
+    QVERIFY(not engine()->cancelRequest(&queuedRequest));
+
+    QVERIFY(engine()->waitForRequestFinished(&runningRequest, 5000));
+    QCOMPARE(runningRequest.error(), QContactManager::NoError);
+
+    // give the queue a chance to run the canceled request, which must not happen
+    QTest::qWait(100);
+
+    QCOMPARE(finishedRequests.count(), 1);
+    QCOMPARE(finishedRequests.first(), &runningRequest);
+    QCOMPARE(queuedRequest.state(), QContactAbstractRequest::CanceledState);
+}
+
+static bool
+waitForSearchSession(QctSearchSession &session, int timeout = 5000)
+{
+    if (session.isActive()) {
+        QEventLoop loop;
+        QObject::connect(&session, SIGNAL(finished()), &loop, SLOT(quit()));
+        QTimer::singleShot(timeout, &loop, SLOT(quit()));
+        loop.exec();
+    }
+
+    return not session.isActive();
+}
+
+void
+ut_qtcontacts_trackerplugin::testSearchSession()
+{
+    const QString prefix = QLatin1String(__func__);
+    QContactManager::Error error = QContactManager::UnspecifiedError;
+
+    QList<QContact> contacts;
+    contacts << QContact() << QContact();
+
+    for(int i = 0; i < contacts.count(); ++i) {
+        QContactName name;
+        name.setFirstName(prefix + (i ? QLatin1String("Beta") : QLatin1String("Alpha")));
+        QVERIFY(contacts[i].saveDetail(&name));
+        QVERIFY(engine()->saveContact(&contacts[i], &error));
+        QCOMPARE(error, QContactManager::NoError);
+        addedContacts.append(contacts[i].localId());
+    }
+
+    QContactManager manager(QLatin1String("tracker"), makeEngineParams());
+    QctSearchSession session(&manager);
+    session.setDetailDefinitionName(QContactName::DefinitionName, QContactName::FieldFirstName);
+
+    // the first search must query the database
+    session.search(prefix);
+    QVERIFY(waitForSearchSession(session));
+    QCOMPARE(session.error(), QContactManager::NoError);
+    QCOMPARE(session.term(), prefix);
+    QCOMPARE(session.contacts().count(), 2);
+    QVERIFY(not session.isIncrementalResult());
+
+    // extending the term refines the previous results
+    session.search(prefix + QLatin1String("A"));
+    QVERIFY(not session.isActive());
+    QCOMPARE(session.error(), QContactManager::NoError);
+    QCOMPARE(session.contacts().count(), 1);
+    QCOMPARE(session.contacts().first().localId(), contacts.first().localId());
+    QVERIFY(session.isIncrementalResult());
+
+    // backspace needs another query
+    session.search(prefix);
+    QVERIFY(waitForSearchSession(session));
+    QCOMPARE(session.error(), QContactManager::NoError);
+    QCOMPARE(session.contacts().count(), 2);
+    QVERIFY(not session.isIncrementalResult());
+
+    // invalidated results are not refined
+    session.invalidate();
+    session.search(prefix + QLatin1String("B"));
+    QVERIFY(waitForSearchSession(session));
+    QCOMPARE(session.error(), QContactManager::NoError);
+    QCOMPARE(session.contacts().count(), 1);
+    QCOMPARE(session.contacts().first().localId(), contacts.last().localId());
+    QVERIFY(not session.isIncrementalResult());
+}
+
+void
+ut_qtcontacts_trackerplugin::testNameIndex()
+{
+    const QString prefix = QLatin1String(__func__);
+
+    QMap<QString, QString> params = makeEngineParams();
+    params.insert(QLatin1String("name-index"), QLatin1String("true"));
+
+    QContactManager manager(QLatin1String("tracker"), params);
+
+    QContact contact;
+    QContactName name;
+    name.setFirstName(prefix + QLatin1String("Alpha"));
+    name.setLastName(prefix + QLatin1String("Omega"));
+    QVERIFY(contact.saveDetail(&name));
+    QContactNickname nickname;
+    nickname.setNickname(prefix + QLatin1String("Nick"));
+    QVERIFY(contact.saveDetail(&nickname));
+    QVERIFY(manager.saveContact(&contact));
+    addedContacts.append(contact.localId());
+
+    const QList<QContactLocalId> expectedIds = QList<QContactLocalId>() << contact.localId();
+
+    // lookups ignore case like tracker does
+    QContactDetailFilter filter;
+    filter.setDetailDefinitionName(QContactName::DefinitionName, QContactName::FieldFirstName);
+    filter.setMatchFlags(QContactFilter::MatchStartsWith);
+    filter.setValue(prefix.toLower() + QLatin1String("al"));
+    QCOMPARE(manager.contactIds(filter), expectedIds);
+
+    filter.setDetailDefinitionName(QContactName::DefinitionName, QContactName::FieldLastName);
+    filter.setValue(prefix.toUpper() + QLatin1String("OM"));
+    QCOMPARE(manager.contactIds(filter), expectedIds);
+
+    filter.setDetailDefinitionName(QContactNickname::DefinitionName, QContactNickname::FieldNickname);
+    filter.setValue(prefix + QLatin1String("N"));
+    QCOMPARE(manager.contactIds(filter), expectedIds);
+
+    // display labels are synthesized, therefore only the index can find them
+    const QString displayLabel = manager.contact(contact.localId()).displayLabel();
+    QVERIFY(not displayLabel.isEmpty());
+
+    filter.setDetailDefinitionName(QContactDisplayLabel::DefinitionName, QContactDisplayLabel::FieldLabel);
+    filter.setValue(displayLabel.left(displayLabel.length() - 1));
+    QCOMPARE(manager.contactIds(filter), expectedIds);
+
+    // names not starting with the prefix are not found
+    filter.setDetailDefinitionName(QContactName::DefinitionName, QContactName::FieldFirstName);
+    filter.setValue(prefix + QLatin1String("Omega"));
+    QCOMPARE(manager.contactIds(filter), QList<QContactLocalId>());
+
+    // saved contacts are found without waiting for the change listener
+    QContact otherContact;
+    name.setFirstName(prefix + QLatin1String("Omega"));
+    name.setLastName(QString());
+    QVERIFY(otherContact.saveDetail(&name));
+    QVERIFY(manager.saveContact(&otherContact));
+    addedContacts.append(otherContact.localId());
+
+    QCOMPARE(manager.contactIds(filter), QList<QContactLocalId>() << otherContact.localId());
+
+    // so are renamed contacts
+    name = otherContact.detail<QContactName>();
+    name.setFirstName(prefix + QLatin1String("Theta"));
+    QVERIFY(otherContact.saveDetail(&name));
+    QVERIFY(manager.saveContact(&otherContact));
+
+    QCOMPARE(manager.contactIds(filter), QList<QContactLocalId>());
+
+    filter.setValue(prefix + QLatin1String("Th"));
+    QCOMPARE(manager.contactIds(filter), QList<QContactLocalId>() << otherContact.localId());
+
+    name.setFirstName(prefix + QLatin1String("Omega"));
+    QVERIFY(otherContact.saveDetail(&name));
+    QVERIFY(manager.saveContact(&otherContact));
+
+    filter.setValue(prefix + QLatin1String("Omega"));
+    QCOMPARE(manager.contactIds(filter), QList<QContactLocalId>() << otherContact.localId());
+
+    // filters within compound filters are resolved, too
+    QContactDetailFilter otherFilter;
+    otherFilter.setDetailDefinitionName(QContactNickname::DefinitionName, QContactNickname::FieldNickname);
+    otherFilter.setMatchFlags(QContactFilter::MatchStartsWith);
+    otherFilter.setValue(prefix);
+
+    QCOMPARE(manager.contacts(filter | otherFilter).count(), 2);
+    QCOMPARE(manager.contacts(filter & otherFilter).count(), 0);
+}
+
+void
+ut_qtcontacts_trackerplugin::testMembershipIndex()
+{
+    QMap<QString, QString> params = makeEngineParams();
+    params.insert(QLatin1String("membership-index"), QLatin1String("true"));
+
+    QContactManager manager(QLatin1String("tracker"), params);
+
+    QContact group;
+    group.setType(QContactType::TypeGroup);
+    QVERIFY(manager.saveContact(&group));
+    addedContacts.append(group.localId());
+
+    QContact member1, member2;
+    QVERIFY(manager.saveContact(&member1));
+    addedContacts.append(member1.localId());
+    QVERIFY(manager.saveContact(&member2));
+    addedContacts.append(member2.localId());
+
+    // the index gets populated by the first lookup
+    QCOMPARE(manager.relationships(QContactRelationship::HasMember, group.id(),
+                                   QContactRelationship::First).count(), 0);
+
+    QContactRelationship relationship;
+    relationship.setRelationshipType(QContactRelationship::HasMember);
+    relationship.setFirst(group.id());
+    relationship.setSecond(member1.id());
+    QVERIFY(manager.saveRelationship(&relationship));
+
+    // saved relationships are visible without waiting for the change listener
+    QList<QContactRelationship> relationships =
+            manager.relationships(QContactRelationship::HasMember, group.id(),
+                                  QContactRelationship::First);
+    QCOMPARE(relationships, QList<QContactRelationship>() << relationship);
+
+    relationships = manager.relationships(QContactRelationship::HasMember, member1.id(),
+                                          QContactRelationship::Either);
+    QCOMPARE(relationships, QList<QContactRelationship>() << relationship);
+
+    relationships = manager.relationships(QContactRelationship::HasMember, group.id(),
+                                          QContactRelationship::Either);
+    QCOMPARE(relationships, QList<QContactRelationship>() << relationship);
+
+    // relationship filters are resolved by the index
+    QContactRelationshipFilter filter;
+    filter.setRelationshipType(QContactRelationship::HasMember);
+    filter.setRelatedContactId(group.id());
+    filter.setRelatedContactRole(QContactRelationship::First);
+    QCOMPARE(manager.contactIds(filter), QList<QContactLocalId>() << member1.localId());
+
+    filter.setRelatedContactId(member1.id());
+    filter.setRelatedContactRole(QContactRelationship::Second);
+    QCOMPARE(manager.contactIds(filter), QList<QContactLocalId>() << group.localId());
+
+    filter.setRelatedContactId(member2.id());
+    QCOMPARE(manager.contactIds(filter), QList<QContactLocalId>());
+
+    // fetched contacts get their relationships from the index
+    QCOMPARE(manager.contact(group.localId()).relationships(QContactRelationship::HasMember),
+             QList<QContactRelationship>() << relationship);
+    QCOMPARE(manager.contact(member1.localId()).relationships(QContactRelationship::HasMember),
+             QList<QContactRelationship>() << relationship);
+    QCOMPARE(manager.contact(member2.localId()).relationships(QContactRelationship::HasMember),
+             QList<QContactRelationship>());
+
+    // the index learns about changes from other managers via the change listener
+    QContactRelationship otherRelationship = relationship;
+    otherRelationship.setSecond(member2.id());
+
+    QContactManager::Error error = QContactManager::UnspecifiedError;
+    QVERIFY(engine()->saveRelationship(&otherRelationship, &error));
+    QCOMPARE(error, QContactManager::NoError);
+
+    QTest::qWait(2000);
+
+    QCOMPARE(manager.relationships(QContactRelationship::HasMember, group.id(),
+                                   QContactRelationship::First).count(), 2);
+
+    // removed relationships vanish immediately
+    QVERIFY(manager.removeRelationship(relationship));
+    QCOMPARE(manager.relationships(QContactRelationship::HasMember, group.id(),
+                                   QContactRelationship::First),
+             QList<QContactRelationship>() << otherRelationship);
+}
+
+void
+ut_qtcontacts_trackerplugin::testScopedGarbageCollection()
+{
+    QMap<QString, QString> params = makeEngineParams();
+    params.insert(QLatin1String("scoped-gc"), QLatin1String("true"));
+
+    QContactManager manager(QLatin1String("tracker"), params);
+
+    const QString oldAddress = QString::fromLatin1("%1.old@example.com").arg(QLatin1String(__func__));
+    const QString newAddress = QString::fromLatin1("%1.new@example.com").arg(QLatin1String(__func__));
+    static const QString askTemplate = QLatin1String
+            ("ASK { ?e a nco:EmailAddress ; nco:emailAddress \"%1\" }");
+
+    QContactEmailAddress email;
+    email.setEmailAddress(oldAddress);
+
+    QContact contact;
+    QVERIFY(contact.saveDetail(&email));
+    QVERIFY(manager.saveContact(&contact));
+    addedContacts.append(contact.localId());
+
+    QScopedPointer<QSparqlResult> result(executeQuery(askTemplate.arg(oldAddress),
+                                                      QSparqlQuery::AskStatement));
+    QVERIFY(not result.isNull());
+    QVERIFY(result->next());
+    QCOMPARE(result->value(0).toBool(), true);
+
+    // replacing the email address detaches the old resource, which must get collected
+    email.setEmailAddress(newAddress);
+    QVERIFY(contact.saveDetail(&email));
+    QVERIFY(manager.saveContact(&contact));
+
+    result.reset(executeQuery(askTemplate.arg(oldAddress), QSparqlQuery::AskStatement));
+    QVERIFY(not result.isNull());
+    QVERIFY(result->next());
+    QCOMPARE(result->value(0).toBool(), false);
+
+    // resources still referenced by the contact survive the cleanup
+    result.reset(executeQuery(askTemplate.arg(newAddress), QSparqlQuery::AskStatement));
+    QVERIFY(not result.isNull());
+    QVERIFY(result->next());
+    QCOMPARE(result->value(0).toBool(), true);
+
+    const QContact fetchedContact = manager.contact(contact.localId());
+    QCOMPARE(fetchedContact.detail<QContactEmailAddress>().emailAddress(), newAddress);
+}
+
+void
+ut_qtcontacts_trackerplugin::testGarbageCollectorCoalescing()
+{
+    QContact contact;
+    QContactManager::Error error = QContactManager::UnspecifiedError;
+    QVERIFY(engine()->saveContact(&contact, &error));
+    QCOMPARE(error, QContactManager::NoError);
+    addedContacts.append(contact.localId());
+
+    // start with a clean slate
+    QVERIFY(QctGarbageCollector::flush());
+
+    const int requestedBefore = QctGarbageCollector::requestedTriggers();
+    const int sentBefore = QctGarbageCollector::sentTriggers();
+    const int coalescedBefore = QctGarbageCollector::coalescedTriggers();
+
+    // each update of an existing contact triggers the garbage collector
+    for(int i = 0; i < 3; ++i) {
+        QContactNickname nickname = contact.detail<QContactNickname>();
+        nickname.setNickname(QString::fromLatin1("%1 %2").arg(QLatin1String(__func__)).arg(i));
+        QVERIFY(contact.saveDetail(&nickname));
+
+        error = QContactManager::UnspecifiedError;
+        QVERIFY(engine()->saveContact(&contact, &error));
+        QCOMPARE(error, QContactManager::NoError);
+    }
+
+    QVERIFY(QctGarbageCollector::flush());
+
+    const int requested = QctGarbageCollector::requestedTriggers() - requestedBefore;
+    const int sent = QctGarbageCollector::sentTriggers() - sentBefore;
+    const int coalesced = QctGarbageCollector::coalescedTriggers() - coalescedBefore;
+
+    QCOMPARE(requested, 3);
+    QCOMPARE(sent + coalesced, requested);
+    QVERIFY(sent < requested);
+}
+
+void
+ut_qtcontacts_trackerplugin::testCascadeRemove()
+{
+    QMap<QString, QString> params = makeEngineParams();
+    params.insert(QLatin1String("cascade-remove"), QLatin1String("true"));
+
+    QContactManager manager(QLatin1String("tracker"), params);
+
+    const QString street = QString::fromLatin1("%1 Street").arg(QLatin1String(__func__));
+    const QString sharedStreet = QString::fromLatin1("%1 Shared Street").arg(QLatin1String(__func__));
+    const QString customValue = QString::fromLatin1("%1 Value").arg(QLatin1String(__func__));
+
+    const QString addressQuery = QString::fromLatin1
+            ("ASK { ?a a nco:PostalAddress ; nco:streetAddress \"%1\" }");
+    const QString propertyQuery = QString::fromLatin1
+            ("ASK { ?p a nao:Property ; nao:propertyValue \"%1\" }").arg(customValue);
+
+    QContactAddress address;
+    address.setStreet(street);
+    address.setContexts(QContactDetail::ContextHome);
+
+    QContactName name;
+    name.setFirstName(QLatin1String(__func__));
+
+    // custom detail fields are stored as nested nao:Property resources
+    QContactDetail customDetail(QLatin1String("CascadeDetail"));
+    customDetail.setValue(QLatin1String("Field"), customValue);
+
+    QContactOnlineAccount account;
+    account.setValue(QContactOnlineAccount::FieldAccountUri,
+                     QString::fromLatin1("%1@example.com").arg(QLatin1String(__func__)));
+
+    QContact contact;
+    QVERIFY(contact.saveDetail(&address));
+    QVERIFY(contact.saveDetail(&name));
+    QVERIFY(contact.saveDetail(&customDetail));
+    QVERIFY(contact.saveDetail(&account));
+    QVERIFY(manager.saveContact(&contact));
+    addedContacts.append(contact.localId());
+
+    // the other contact shares its postal address with the first one
+    QContactAddress sharedAddress;
+    sharedAddress.setStreet(sharedStreet);
+
+    QContact otherContact;
+    QVERIFY(otherContact.saveDetail(&sharedAddress));
+    QVERIFY(manager.saveContact(&otherContact));
+    addedContacts.append(otherContact.localId());
+
+    const QString shareQuery = QString::fromLatin1
+            ("INSERT { ?c nco:hasPostalAddress ?a } WHERE {\n"
+             "  ?c a nco:Contact . ?o nco:hasPostalAddress ?a .\n"
+             "  FILTER(tracker:id(?c) = %1 && tracker:id(?o) = %2)\n"
+             "}").arg(contact.localId()).arg(otherContact.localId());
+
+    QScopedPointer<QSparqlResult> result(executeQuery(shareQuery, QSparqlQuery::InsertStatement));
+    QVERIFY(not result.isNull());
+
+    foreach(const QString &query, QStringList()
+            << addressQuery.arg(street) << addressQuery.arg(sharedStreet) << propertyQuery) {
+        result.reset(executeQuery(query, QSparqlQuery::AskStatement));
+        QVERIFY(not result.isNull());
+        QVERIFY(result->next());
+        QCOMPARE(result->value(0).toBool(), true);
+    }
+
+    QVERIFY(QctGarbageCollector::flush());
+    const int requestedBefore = QctGarbageCollector::requestedTriggers();
+
+    // owned resources vanish with their contacts, even if shared by the removed contacts
+    QVERIFY(manager.removeContacts(QList<QContactLocalId>()
+                                   << contact.localId() << otherContact.localId()));
+    QCOMPARE(manager.error(), QContactManager::NoError);
+
+    foreach(const QString &query, QStringList()
+            << addressQuery.arg(street) << addressQuery.arg(sharedStreet) << propertyQuery) {
+        result.reset(executeQuery(query, QSparqlQuery::AskStatement));
+        QVERIFY(not result.isNull());
+        QVERIFY(result->next());
+        QCOMPARE(result->value(0).toBool(), false);
+    }
+
+    // IM addresses are left to the garbage collector
+    QVERIFY(QctGarbageCollector::flush());
+    QVERIFY(QctGarbageCollector::requestedTriggers() > requestedBefore);
+}
+
+void
+ut_qtcontacts_trackerplugin::testSaveRequestCombining()
+{
+    QMap<QString, QString> params = makeEngineParams();
+    params.insert(QLatin1String("save-combining-window"), QLatin1String("200"));
+    params.insert(QLatin1String("debug"), QLatin1String("no-nagging,notes"));
+
+    QContactManager manager(QLatin1String("tracker"), params);
+
+    // a save request with nothing to merge doesn't wait for the window to pass
+    params.insert(QLatin1String("save-combining-window"), QLatin1String("10000"));
+    QContactManager slowManager(QLatin1String("tracker"), params);
+
+    QContact lonelyContact;
+    QElapsedTimer timer;
+    timer.start();
+
+    QVERIFY(slowManager.saveContact(&lonelyContact));
+    addedContacts.append(lonelyContact.localId());
+    QVERIFY(timer.elapsed() < 5000);
+
+    // keep the queue busy while issuing the burst, so that the first save request
+    // finds the others queued behind it when it starts working
+    QContactFetchRequest fetchRequest;
+    fetchRequest.setManager(&manager);
+    QVERIFY(fetchRequest.start());
+
+    // issue a burst of single contact save requests
+    QList< QSharedPointer<QContactSaveRequest> > requests;
+
+    for(int i = 0; i < 5; ++i) {
+        QContactName name;
+        name.setFirstName(QString::fromLatin1("%1 %2").arg(QLatin1String(__func__)).arg(i));
+
+        QContact contact;
+        QVERIFY(contact.saveDetail(&name));
+
+        // the third request refers to a contact which doesn't exist
+        if (2 == i) {
+            QContactId id;
+            id.setManagerUri(manager.managerUri());
+            id.setLocalId(0x7fffffff);
+            contact.setId(id);
+        }
+
+        const QSharedPointer<QContactSaveRequest> request(new QContactSaveRequest);
+        request->setManager(&manager);
+        request->setContacts(QList<QContact>() << contact);
+        QVERIFY(request->start());
+
+        requests += request;
+    }
+
+    // the first request saves the contacts of all requests in one go
+    QTest::ignoreMessage(QtDebugMsg, "QTrackerContactSaveRequest 0 : combining 5 save requests");
+
+    // each request is finished with its own results
+    for(int i = 0; i < requests.count(); ++i) {
+        QContactSaveRequest *const request = requests.at(i).data();
+        QVERIFY(request->waitForFinished(5000));
+        QCOMPARE(request->contacts().count(), 1);
+
+        if (2 == i) {
+            QCOMPARE(request->error(), QContactManager::DoesNotExistError);
+            QCOMPARE(request->errorMap().count(), 1);
+            QCOMPARE(request->errorMap().value(0), QContactManager::DoesNotExistError);
+            continue;
+        }
+
+        QCOMPARE(request->error(), QContactManager::NoError);
+        QVERIFY(request->errorMap().isEmpty());
+
+        const QContact &contact = request->contacts().first();
+        QVERIFY(0 != contact.localId());
+        addedContacts.append(contact.localId());
+
+        const QContact fetchedContact = manager.contact(contact.localId());
+        QCOMPARE(manager.error(), QContactManager::NoError);
+        QCOMPARE(fetchedContact.detail<QContactName>().firstName(),
+                 contact.detail<QContactName>().firstName());
+    }
+
+    // save requests separated by some other request must not overtake that request
+    QContact contact = requests.first()->contacts().first();
+    QContactName name = contact.detail<QContactName>();
+    name.setLastName(QLatin1String(__func__));
+    QVERIFY(contact.saveDetail(&name));
+
+    QContactSaveRequest saveRequest;
+    saveRequest.setManager(&manager);
+    saveRequest.setContacts(QList<QContact>() << contact);
+
+    QContactRemoveRequest removeRequest;
+    removeRequest.setManager(&manager);
+    removeRequest.setContactIds(QList<QContactLocalId>() << contact.localId());
+
+    QContactSaveRequest laterSaveRequest;
+    laterSaveRequest.setManager(&manager);
+    laterSaveRequest.setContacts(QList<QContact>() << contact);
+
+    QVERIFY(saveRequest.start());
+    QVERIFY(removeRequest.start());
+    QVERIFY(laterSaveRequest.start());
+
+    QVERIFY(saveRequest.waitForFinished(5000));
+    QCOMPARE(saveRequest.error(), QContactManager::NoError);
+
+    QVERIFY(removeRequest.waitForFinished(5000));
+    QCOMPARE(removeRequest.error(), QContactManager::NoError);
+
+    // the contact is gone when the later save request runs
+    QVERIFY(laterSaveRequest.waitForFinished(5000));
+    QCOMPARE(laterSaveRequest.error(), QContactManager::DoesNotExistError);
+}
+
+static QByteArray
+makePngAvatar(QRgb color, QString *hash)
+{
+    QImage image(16, 16, QImage::Format_RGB32);
+    image.fill(color);
+
+    QBuffer buffer;
+    buffer.open(QBuffer::WriteOnly);
+    image.save(&buffer, "PNG");
+
+    *hash = QString::fromLatin1(QCryptographicHash::hash(buffer.data(), QCryptographicHash::Sha1).toHex());
+
+    return buffer.data();
+}
+
+void
+ut_qtcontacts_trackerplugin::testAvatarPack()
+{
+    const QString fileName = QDir::temp().filePath(QString::fromLatin1("%1-%2.pack").
+                                                   arg(QLatin1String(__func__)).
+                                                   arg(QCoreApplication::applicationPid()));
+    QFile::remove(fileName);
+
+    QString redHash, greenHash, blueHash;
+    const QByteArray red = makePngAvatar(qRgb(255, 0, 0), &redHash);
+    const QByteArray green = makePngAvatar(qRgb(0, 255, 0), &greenHash);
+    const QByteArray blue = makePngAvatar(qRgb(0, 0, 255), &blueHash);
+
+    QctAvatarPack pack(fileName);
+    QCOMPARE(pack.count(), 0);
+    QVERIFY(not pack.contains(redHash));
+    QVERIFY(pack.image(redHash).isNull());
+
+    // store an avatar and read it back from the mapped pack
+    QVERIFY(pack.insert(redHash, red));
+    QVERIFY(pack.contains(redHash));
+    QCOMPARE(pack.count(), 1);
+    QCOMPARE(pack.image(redHash).size(), QSize(16, 16));
+    QCOMPARE(pack.image(redHash).pixel(8, 8), qRgb(255, 0, 0));
+
+    // storing the same avatar again doesn't grow the pack
+    const qint64 packSize = pack.size();
+    QVERIFY(pack.insert(redHash, red));
+    QCOMPARE(pack.size(), packSize);
+
+    // some other process sharing the pack sees our avatars, and we see its avatars
+    QctAvatarPack otherPack(fileName);
+    QVERIFY(otherPack.contains(redHash));
+    QVERIFY(otherPack.insert(greenHash, green));
+    QVERIFY(pack.contains(greenHash));
+    QCOMPARE(pack.image(greenHash).pixel(8, 8), qRgb(0, 255, 0));
+
+    // incomplete records left behind by a crashed writer get dropped
+    QFile file(fileName);
+    QVERIFY(file.open(QFile::WriteOnly | QFile::Append));
+    QVERIFY(file.write(QByteArray(7, 'x')) == 7);
+    file.close();
+
+    QVERIFY(pack.insert(blueHash, blue));
+    QCOMPARE(pack.count(), 3);
+    QCOMPARE(otherPack.count(), 3);
+    QCOMPARE(otherPack.image(blueHash).pixel(8, 8), qRgb(0, 0, 255));
+
+    // compaction only keeps the listed avatars
+    QVERIFY(pack.compact(QSet<QString>() << greenHash));
+    QCOMPARE(pack.count(), 1);
+    QVERIFY(not pack.contains(redHash));
+    QCOMPARE(pack.image(greenHash).pixel(8, 8), qRgb(0, 255, 0));
+
+    // other processes notice the compacted pack
+    QCOMPARE(otherPack.count(), 1);
+    QCOMPARE(otherPack.image(greenHash).pixel(8, 8), qRgb(0, 255, 0));
+    QVERIFY(otherPack.insert(redHash, red));
+    QCOMPARE(pack.count(), 2);
+
+    QVERIFY(QFile::remove(fileName));
+}
+
+void
+ut_qtcontacts_trackerplugin::testCompactCustomDetails()
+{
+    QMap<QString, QString> params = makeEngineParams();
+    params.insert(QLatin1String("compact-custom-details"), QLatin1String("true"));
+
+    QContactManager manager(QLatin1String("tracker"), params);
+
+    const QString detailName = QLatin1String("CompactDetail");
+    const QStringList listValue = QStringList() << QLatin1String("c") << QLatin1String("a") << QLatin1String("b");
+    const QString singleValue = QString::fromLatin1("%1 Value").arg(QLatin1String(__func__));
+
+    QContactDetail customDetail(detailName);
+    customDetail.setValue(QLatin1String("Single"), singleValue);
+    customDetail.setValue(QLatin1String("List"), listValue);
+
+    QContact contact;
+    QVERIFY(contact.saveDetail(&customDetail));
+    QVERIFY(manager.saveContact(&contact));
+    QCOMPARE(manager.error(), QContactManager::NoError);
+    addedContacts.append(contact.localId());
+
+    const QString encodedQuery = QString::fromLatin1
+            ("ASK { ?c nao:hasProperty ?p . ?p nao:propertyName \"%1\" ; nao:propertyValue ?v ."
+             "      FILTER(tracker:id(?c) = %2) }").arg(detailName).arg(contact.localId());
+    const QString perFieldQuery = QString::fromLatin1
+            ("ASK { ?c nao:hasProperty ?p . ?p nao:propertyName \"%1\" ; nao:hasProperty ?f ."
+             "      FILTER(tracker:id(?c) = %2) }").arg(detailName).arg(contact.localId());
+
+    // all fields are stored in a single literal
+    QScopedPointer<QSparqlResult> result(executeQuery(encodedQuery, QSparqlQuery::AskStatement));
+    QVERIFY(not result.isNull());
+    QVERIFY(result->next());
+    QCOMPARE(result->value(0).toBool(), true);
+
+    result.reset(executeQuery(perFieldQuery, QSparqlQuery::AskStatement));
+    QVERIFY(not result.isNull());
+    QVERIFY(result->next());
+    QCOMPARE(result->value(0).toBool(), false);
+
+    // both engines read the compact form
+    QContactManager::Error error = QContactManager::UnspecifiedError;
+
+    foreach(const QContact &fetchedContact, QList<QContact>()
+            << manager.contact(contact.localId())
+            << engine()->contactImpl(contact.localId(), NoFetchHint, &error)) {
+        const QContactDetail fetchedDetail = fetchedContact.detail(detailName);
+        QCOMPARE(fetchedDetail.value(QLatin1String("Single")), singleValue);
+        QCOMPARE(fetchedDetail.value<QStringList>(QLatin1String("List")), listValue);
+    }
+
+    // saving with the default encoding migrates the detail back to per-field properties
+    contact = manager.contact(contact.localId());
+    error = QContactManager::UnspecifiedError;
+    QVERIFY(engine()->saveContact(&contact, &error));
+    QCOMPARE(error, QContactManager::NoError);
+
+    result.reset(executeQuery(perFieldQuery, QSparqlQuery::AskStatement));
+    QVERIFY(not result.isNull());
+    QVERIFY(result->next());
+    QCOMPARE(result->value(0).toBool(), true);
+
+    const QContactDetail fetchedDetail = manager.contact(contact.localId()).detail(detailName);
+    QCOMPARE(fetchedDetail.value(QLatin1String("Single")), singleValue);
+    QCOMPARE(fetchedDetail.value<QStringList>(QLatin1String("List")), listValue);
+}
+
+void
+ut_qtcontacts_trackerplugin::testTombstones()
+{
+    QMap<QString, QString> params = makeEngineParams();
+    params.insert(QLatin1String("tombstone-retention"), QLatin1String("7"));
+
+    QContactManager manager(QLatin1String("tracker"), params);
+
+    QContact removedContact, otherRemovedContact, keptContact;
+    QVERIFY(manager.saveContact(&removedContact));
+    addedContacts.append(removedContact.localId());
+    QVERIFY(manager.saveContact(&otherRemovedContact));
+    addedContacts.append(otherRemovedContact.localId());
+    QVERIFY(manager.saveContact(&keptContact));
+    addedContacts.append(keptContact.localId());
+
+    const QString guid = manager.contact(removedContact.localId()).detail<QContactGuid>().guid();
+    QVERIFY(not guid.isEmpty());
+    const QString otherGuid = manager.contact(otherRemovedContact.localId()).detail<QContactGuid>().guid();
+    QVERIFY(not otherGuid.isEmpty());
+
+    // tombstones only have a precision of seconds
+    const QDateTime start = QDateTime::currentDateTime().addSecs(-1);
+    QVERIFY(manager.removeContacts(QList<QContactLocalId>()
+                                   << removedContact.localId()
+                                   << otherRemovedContact.localId()));
+
+    QContactChangeLogFilter filter(QContactChangeLogFilter::EventRemoved);
+    filter.setSince(start);
+
+    const QList<QContactLocalId> removedIds = manager.contactIds(filter);
+    QCOMPARE(manager.error(), QContactManager::NoError);
+    QVERIFY(removedIds.contains(removedContact.localId()));
+    QVERIFY(removedIds.contains(otherRemovedContact.localId()));
+    QVERIFY(not removedIds.contains(keptContact.localId()));
+
+    // each tombstone keeps the GUID of its removed contact
+    const QString guidQuery = QString::fromLatin1
+            ("ASK { GRAPH <%1> { <urn:x-maemo-contacts-tombstone:%2> nie:identifier \"%3\" } }");
+
+    QScopedPointer<QSparqlResult> result
+            (executeQuery(guidQuery.arg(QtContactsTrackerTombstoneGraphIri).
+                          arg(removedContact.localId()).arg(guid),
+                          QSparqlQuery::AskStatement));
+    QVERIFY(not result.isNull());
+    QVERIFY(result->next());
+    QCOMPARE(result->value(0).toBool(), true);
+
+    result.reset(executeQuery(guidQuery.arg(QtContactsTrackerTombstoneGraphIri).
+                              arg(otherRemovedContact.localId()).arg(otherGuid),
+                              QSparqlQuery::AskStatement));
+    QVERIFY(not result.isNull());
+    QVERIFY(result->next());
+    QCOMPARE(result->value(0).toBool(), true);
+
+    // removing ids which are not contacts neither records nor drops tombstones
+    const QContactLocalId bogusId = 0x7fffffff;
+    manager.removeContacts(QList<QContactLocalId>() << removedContact.localId() << bogusId);
+
+    filter.setSince(start);
+    const QList<QContactLocalId> removedAgainIds = manager.contactIds(filter);
+    QCOMPARE(manager.error(), QContactManager::NoError);
+    QVERIFY(removedAgainIds.contains(removedContact.localId()));
+    QVERIFY(not removedAgainIds.contains(bogusId));
+
+    const QString tombstoneQuery = QString::fromLatin1
+            ("ASK { GRAPH <%1> { <urn:x-maemo-contacts-tombstone:%2> a nie:InformationElement } }").
+            arg(QtContactsTrackerTombstoneGraphIri).arg(bogusId);
+
+    result.reset(executeQuery(tombstoneQuery, QSparqlQuery::AskStatement));
+    QVERIFY(not result.isNull());
+    QVERIFY(result->next());
+    QCOMPARE(result->value(0).toBool(), false);
+
+    // removals before the given date are not reported
+    filter.setSince(QDateTime::currentDateTime().addSecs(60));
+    QCOMPARE(manager.contactIds(filter), QList<QContactLocalId>());
+    QCOMPARE(manager.error(), QContactManager::NoError);
+}
+
+void
+ut_qtcontacts_trackerplugin::testFetchThreads()
+{
+    // enough contacts to get post-processed in several chunks
+    QList<QContact> contacts;
+
+    for(int i = 0; i < 150; ++i) {
+        QContactName name;
+        name.setFirstName(QString::fromLatin1("%1 %2").arg(QLatin1String(__func__)).arg(i));
+
+        QContactAvatar avatar;
+        avatar.setImageUrl(QUrl(QString::fromLatin1("file:///tmp/%1-%2.png").
+                                arg(QLatin1String(__func__)).arg(i)));
+
+        QContact contact;
+        QVERIFY(contact.saveDetail(&name));
+        QVERIFY(contact.saveDetail(&avatar));
+        contacts.append(contact);
+    }
+
+    QContactManager::Error error = QContactManager::UnspecifiedError;
+    QVERIFY(engine()->saveContacts(&contacts, 0, &error));
+    QCOMPARE(error, QContactManager::NoError);
+
+    QList<QContactLocalId> contactIds;
+
+    foreach(const QContact &contact, contacts) {
+        contactIds.append(contact.localId());
+        addedContacts.append(contact.localId());
+    }
+
+    QContactLocalIdFilter filter;
+    filter.setIds(contactIds);
+
+    QMap<QString, QString> params = makeEngineParams();
+    params.insert(QLatin1String("fetch-threads"), QLatin1String("1"));
+    const QList<QContact> singleThreaded = QContactManager(QLatin1String("tracker"), params).contacts(filter);
+    QCOMPARE(singleThreaded.count(), contacts.count());
+
+    params.insert(QLatin1String("fetch-threads"), QLatin1String("4"));
+    const QList<QContact> multiThreaded = QContactManager(QLatin1String("tracker"), params).contacts(filter);
+    QCOMPARE(multiThreaded.count(), contacts.count());
+
+    QHash<QContactLocalId, QContact> expectedContacts;
+
+    foreach(const QContact &contact, singleThreaded) {
+        expectedContacts.insert(contact.localId(), contact);
+    }
+
+    foreach(const QContact &contact, multiThreaded) {
+        QVERIFY(expectedContacts.contains(contact.localId()));
+        const QContact &expected = expectedContacts[contact.localId()];
+
+        QVERIFY(not contact.displayLabel().isEmpty());
+        QCOMPARE(contact.displayLabel(), expected.displayLabel());
+
+        QVERIFY(not contact.detail<QContactAvatar>().imageUrl().isEmpty());
+        QCOMPARE(contact.detail<QContactAvatar>().imageUrl(),
+                 expected.detail<QContactAvatar>().imageUrl());
+        QCOMPARE(contact.details<QContactAvatar>().count(),
+                 expected.details<QContactAvatar>().count());
+    }
+}
+
+void
+ut_qtcontacts_trackerplugin::testMergeSingleValuedPredicates()
+{
+    // two targets, each with a source carrying different single-valued properties
+    QList<QContact> contacts;
+
+    for(int i = 0; i < 4; ++i) {
+        QContactName name;
+        name.setFirstName(QString::fromLatin1("%1 %2").arg(QLatin1String(__func__)).arg(i));
+
+        QContact contact;
+        QVERIFY(contact.saveDetail(&name));
+        contacts.append(contact);
+    }
+
+    QContactBirthday firstBirthday;
+    firstBirthday.setDate(QDate(1980, 1, 1));
+    QVERIFY(contacts[1].saveDetail(&firstBirthday));
+
+    QContactBirthday secondBirthday;
+    secondBirthday.setDate(QDate(1990, 2, 2));
+    QVERIFY(contacts[3].saveDetail(&secondBirthday));
+
+    QContactGender gender;
+    gender.setGender(QContactGender::GenderFemale);
+    QVERIFY(contacts[3].saveDetail(&gender));
+
+    QContactManager::Error error = QContactManager::UnspecifiedError;
+    QVERIFY(engine()->saveContacts(&contacts, 0, &error));
+    QCOMPARE(error, QContactManager::NoError);
+
+    foreach(const QContact &contact, contacts) {
+        addedContacts.append(contact.localId());
+    }
+
+    const QContactLocalId firstTargetId = contacts[0].localId();
+    const QContactLocalId secondTargetId = contacts[2].localId();
+
+    QMultiMap<QContactLocalId, QContactLocalId> mergeIds;
+    mergeIds.insert(firstTargetId, contacts[1].localId());
+    mergeIds.insert(secondTargetId, contacts[3].localId());
+
+    QctContactMergeRequest request;
+    request.setMergeIds(mergeIds);
+
+    QVERIFY(engine()->startRequest(&request));
+    QVERIFY(engine()->waitForRequestFinished(&request, 0));
+    QCOMPARE(request.error(), QContactManager::NoError);
+
+    const QStringList definitionNames = QStringList()
+            << QContactBirthday::DefinitionName << QContactGender::DefinitionName;
+
+    // each target only got the properties of its own source
+    const QContact firstTarget = contact(firstTargetId, definitionNames);
+    QCOMPARE(firstTarget.localId(), firstTargetId);
+    QCOMPARE(firstTarget.detail<QContactBirthday>().date(), firstBirthday.date());
+    QVERIFY(firstTarget.detail<QContactGender>().isEmpty());
+
+    const QContact secondTarget = contact(secondTargetId, definitionNames);
+    QCOMPARE(secondTarget.localId(), secondTargetId);
+    QCOMPARE(secondTarget.detail<QContactBirthday>().date(), secondBirthday.date());
+    QCOMPARE(secondTarget.detail<QContactGender>().gender(), gender.gender());
+
+    // the sources are gone
+    QCOMPARE(contact(contacts[1].localId()).localId(), 0U);
+    QCOMPARE(contact(contacts[3].localId()).localId(), 0U);
+}
+
+void
+ut_qtcontacts_trackerplugin::testRemoveManyContacts()
+{
+    QContactManager::Error error = QContactManager::UnspecifiedError;
+    const QContactLocalId selfId = engine()->selfContactId(&error);
+    QCOMPARE(error, QContactManager::NoError);
+
+    // more contacts than fit into a single chunk of the remove update
+    const int contactCount = QctSparqlResolver::ColumnLimit + 10;
+
+    for(int round = 0; round < 2; ++round) {
+        QList<QContact> contacts;
+
+        for(int i = 0; i < contactCount; ++i) {
+            QContactName name;
+            name.setFirstName(QString::fromLatin1("%1 %2 %3").
+                              arg(QLatin1String(__func__)).arg(round).arg(i));
+
+            QContact contact;
+            QVERIFY(contact.saveDetail(&name));
+            contacts.append(contact);
+        }
+
+        error = QContactManager::UnspecifiedError;
+        QVERIFY(engine()->saveContacts(&contacts, 0, &error));
+        QCOMPARE(error, QContactManager::NoError);
+
+        QList<QContactLocalId> existingIds;
+
+        foreach(const QContact &contact, contacts) {
+            existingIds.append(contact.localId());
+            addedContacts.append(contact.localId());
+        }
+
+        QList<QContactLocalId> idsToRemove = existingIds;
+
+        // in the second round some of the ids don't refer to any contact
+        if (1 == round) {
+            for(int i = 0; i < idsToRemove.count(); i += 50) {
+                idsToRemove.insert(i, 0x7fffff00 + i);
+            }
+        }
+
+        // the self contact is rejected in the second chunk
+        const int selfIndex = QctSparqlResolver::ColumnLimit + 5;
+        idsToRemove.insert(selfIndex, selfId);
+
+        QContactRemoveRequest request;
+        request.setContactIds(idsToRemove);
+
+        QVERIFY(engine()->startRequest(&request));
+        QVERIFY(engine()->waitForRequestFinishedImpl(&request, 0));
+        QCOMPARE(request.error(), QContactManager::PermissionsError);
+
+        // missing contacts are not reported, see QTrackerContactRemoveRequest::run()
+        for(int i = 0; i < idsToRemove.count(); ++i) {
+            const QContactManager::Error expectedError = (selfIndex == i
+                                                          ? QContactManager::PermissionsError
+                                                          : QContactManager::NoError);
+            QCOMPARE(request.errorMap().value(i, QContactManager::NoError), expectedError);
+        }
+
+        foreach(QContactLocalId id, existingIds) {
+            error = QContactManager::UnspecifiedError;
+            engine()->contact(id, QContactFetchHint(), &error);
+            QCOMPARE(error, QContactManager::DoesNotExistError);
+        }
+    }
+}
+
+void
+ut_qtcontacts_trackerplugin::testSaveManyThumbnails()
+{
+    // enough contacts to spread the thumbnails over several threads,
+    // with a thumbnail that cannot be written in the middle
+    const int contactCount = 20;
+    const int failingIndex = contactCount / 2;
+
+    QList<QContact> contacts;
+    QList<QRgb> colors;
+
+    for(int i = 0; i < contactCount; ++i) {
+        QContactName name;
+        name.setFirstName(QString::fromLatin1("%1 %2").arg(QLatin1String(__func__)).arg(i));
+
+        const QRgb color = qRgb(10 * i, 255 - 10 * i, 128);
+        QImage image;
+
+        if (failingIndex != i) {
+            image = QImage(8, 8, QImage::Format_RGB32);
+            image.fill(color);
+        }
+
+        QContactThumbnail thumbnail;
+        thumbnail.setThumbnail(image);
+
+        QContact contact;
+        QVERIFY(contact.saveDetail(&name));
+        QVERIFY(contact.saveDetail(&thumbnail));
+
+        contacts.append(contact);
+        colors.append(color);
+    }
+
+    QMap<int, QContactManager::Error> errorMap;
+    QContactManager::Error error = QContactManager::NoError;
+    QVERIFY(not engine()->saveContacts(&contacts, &errorMap, &error));
+    QCOMPARE(error, QContactManager::UnspecifiedError);
+
+    // only the contact with the broken thumbnail failed
+    QCOMPARE(errorMap.count(), 1);
+    QCOMPARE(errorMap.value(failingIndex, QContactManager::NoError), QContactManager::UnspecifiedError);
+    QCOMPARE(contacts.at(failingIndex).localId(), 0U);
+
+    // each saved contact got the avatar of its own thumbnail
+    for(int i = 0; i < contactCount; ++i) {
+        if (failingIndex == i) {
+            continue;
+        }
+
+        QVERIFY(0 != contacts.at(i).localId());
+        addedContacts.append(contacts.at(i).localId());
+
+        const QContact fetchedContact = contact(contacts.at(i).localId(),
+                                                QStringList(QContactAvatar::DefinitionName));
+        const QUrl imageUrl = fetchedContact.detail<QContactAvatar>().imageUrl();
+        QVERIFY2(not imageUrl.isEmpty(), qPrintable(QString::number(i)));
+        QCOMPARE(contacts.at(i).detail<QContactAvatar>().imageUrl(), imageUrl);
+
+        const QImage image = qctReadThumbnail(imageUrl);
+        QVERIFY2(not image.isNull(), qPrintable(imageUrl.toString()));
+        QCOMPARE(image.pixel(4, 4), colors.at(i));
+    }
+}
+
 void
 ut_qtcontacts_trackerplugin::testDetailUriEncoding()
 {
@@ -121,6 +121,7 @@ private slots:
 //    void testGroupsModifiedSince();
 //    void testGroupsRemovedSince();
     void testMergeOnlineContacts();
+    void testBulkUnmergeOnlineContacts();
     void testMergingContacts();
     void testMergingGarbage();
     void testMergeSyncTarget_data();
@@ -139,6 +140,10 @@ private slots:
     void testNormalizePhoneNumber_data();
     void testNormalizePhoneNumber();
     void testFilterDTMFNumber();
+    void testPhoneNumberMatchRequest();
+    void testMakeKeypadDigits_data();
+    void testMakeKeypadDigits();
+    void testKeypadMatchRequest();
 
 // NB#208065
     void testFilterContactsMatchPhoneNumberWithShortNumber_data();
@@ -235,6 +240,23 @@ private slots:
 
     void testDeleteFromStateChangedHandler_data();
     void testDeleteFromStateChangedHandler();
+    void testRequestPriority();
+    void testIdenticalFetchRequests();
+    void testCancelQueuedRequest();
+    void testSearchSession();
+    void testNameIndex();
+    void testMembershipIndex();
+    void testScopedGarbageCollection();
+    void testGarbageCollectorCoalescing();
+    void testCascadeRemove();
+    void testSaveRequestCombining();
+    void testAvatarPack();
+    void testCompactCustomDetails();
+    void testTombstones();
+    void testFetchThreads();
+    void testMergeSingleValuedPredicates();
+    void testRemoveManyContacts();
+    void testSaveManyThumbnails();
 
     void testDetailUriEncoding();
 
@@ -278,6 +300,22 @@ private:
     QList<QContactLocalId> addedContacts;
 };
 
+class RequestFinishRecorder : QObject
+{
+    Q_OBJECT
+
+public:
+    RequestFinishRecorder(QList<QContactAbstractRequest *> &finishedRequests,
+                          QContactAbstractRequest *request);
+
+private slots:
+    void onStateChanged(QContactAbstractRequest::State state);
+
+private:
+    QList<QContactAbstractRequest *> &m_finishedRequests;
+    QContactAbstractRequest *const m_request;
+};
+
 class EvilRequestKiller : QObject
 {
     Q_OBJECT
@@ -950,6 +950,86 @@ ut_qtcontacts_trackerplugin_groups::testRemoveSavedHasMemberRelationship()
     QCOMPARE(savedRelationships.count(), 0);
 }
 
+void
+ut_qtcontacts_trackerplugin_groups::testSaveAndRemoveManyHasMemberRelationships()
+{
+    // more members than fit into one query chunk
+    static const int memberCount = 300;
+    static const int keptMemberCount = 20;
+
+    // setup contacts
+    QContact group1;
+    SETUP_TEST_GROUPCONTACT(group1);
+    CHECK_CURRENT_TEST_FAILED;
+
+    QContact group2;
+    SETUP_TEST_GROUPCONTACT(group2);
+    CHECK_CURRENT_TEST_FAILED;
+
+    saveContact(group1);
+    CHECK_CURRENT_TEST_FAILED;
+
+    saveContact(group2);
+    CHECK_CURRENT_TEST_FAILED;
+
+    QList<QContact> members;
+
+    for(int i = 0; i < memberCount; ++i) {
+        QContact contact;
+        SET_TESTNICKNAME_TO_CONTACT(contact);
+        CHECK_CURRENT_TEST_FAILED;
+        members += contact;
+    }
+
+    saveContacts(members);
+    CHECK_CURRENT_TEST_FAILED;
+
+    // add all contacts to the first group, every other contact to the second group
+    QList<QContactRelationship> firstGroupMemberships;
+    QList<QContactRelationship> secondGroupMemberships;
+
+    for(int i = 0; i < members.count(); ++i) {
+        QContactRelationship relationship;
+        setupTestHasMemberRelationship(relationship, group1, members.at(i));
+        CHECK_CURRENT_TEST_FAILED;
+        firstGroupMemberships += relationship;
+
+        if (i % 2 == 0) {
+            setupTestHasMemberRelationship(relationship, group2, members.at(i));
+            CHECK_CURRENT_TEST_FAILED;
+            secondGroupMemberships += relationship;
+        }
+    }
+
+    saveRelationships(firstGroupMemberships + secondGroupMemberships);
+    CHECK_CURRENT_TEST_FAILED;
+
+    QList<QContactRelationship> savedRelationships;
+    fetchRelationships(QContactRelationship::HasMember, group1.id(), QContactRelationship::First, savedRelationships);
+    CHECK_CURRENT_TEST_FAILED;
+    QCOMPARE(savedRelationships.count(), firstGroupMemberships.count());
+
+    fetchRelationships(QContactRelationship::HasMember, group2.id(), QContactRelationship::First, savedRelationships);
+    CHECK_CURRENT_TEST_FAILED;
+    QCOMPARE(savedRelationships.count(), secondGroupMemberships.count());
+
+    // remove most of the relationships at once
+    removeRelationships(firstGroupMemberships.mid(keptMemberCount) + secondGroupMemberships);
+    CHECK_CURRENT_TEST_FAILED;
+
+    fetchRelationships(QContactRelationship::HasMember, group1.id(), QContactRelationship::First, savedRelationships);
+    CHECK_CURRENT_TEST_FAILED;
+    QCOMPARE(savedRelationships.count(), keptMemberCount);
+
+    foreach(const QContactRelationship &relationship, savedRelationships) {
+        QVERIFY(firstGroupMemberships.mid(0, keptMemberCount).contains(relationship));
+    }
+
+    fetchRelationships(QContactRelationship::HasMember, group2.id(), QContactRelationship::First, savedRelationships);
+    CHECK_CURRENT_TEST_FAILED;
+    QCOMPARE(savedRelationships.count(), 0);
+}
+
 static void
 checkRelationships(const QList<QContactRelationship> &relationships,
                    const QContactId &expectedParentId, QList<QContactId> expectedChildIds,
@@ -63,6 +63,8 @@ private slots:
     void testRemoveSavedHasMemberRelationship_data();
     void testRemoveSavedHasMemberRelationship();
 
+    void testSaveAndRemoveManyHasMemberRelationships();
+
     void testFetchContactsOfGivenGroup_data();
     void testFetchContactsOfGivenGroup();
 
@@ -0,0 +1,118 @@
+/*********************************************************************************
+ ** This file is part of QtContacts tracker storage plugin
+ **
+ ** Copyright (c) 2010-2011 Nokia Corporation and/or its subsidiary(-ies).
+ **
+ ** Contact:  Nokia Corporation (info@qt.nokia.com)
+ **
+ ** GNU Lesser General Public License Usage
+ ** This file may be used under the terms of the GNU Lesser General Public License
+ ** version 2.1 as published by the Free Software Foundation and appearing in the
+ ** file LICENSE.LGPL included in the packaging of this file.  Please review the
+ ** following information to ensure the GNU Lesser General Public License version
+ ** 2.1 requirements will be met:
+ ** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+ **
+ ** In addition, as a special exception, Nokia gives you certain additional rights.
+ ** These rights are described in the Nokia Qt LGPL Exception version 1.1, included
+ ** in the file LGPL_EXCEPTION.txt in this package.
+ **
+ ** Other Usage
+ ** Alternatively, this file may be used in accordance with the terms and
+ ** conditions contained in a signed written agreement between you and Nokia.
+ *********************************************************************************/
+
+#include <QContactManager>
+#include <QCoreApplication>
+#include <QHash>
+#include <QSet>
+#include <QStringList>
+#include <QTextStream>
+
+QTM_USE_NAMESPACE
+
+// Rewrites the custom details of all contacts in the requested encoding, by saving them
+// with a detail definition mask limited to their custom details. Note that this updates
+// the contacts' modification timestamp.
+
+static const int BatchSize = 100;
+
+int main(int argc, char **argv)
+{
+    QCoreApplication app(argc, argv);
+
+    const QStringList arguments = app.arguments();
+
+    if (arguments.count() != 2 || (arguments.at(1) != QLatin1String("--compact") &&
+                                   arguments.at(1) != QLatin1String("--expand"))) {
+        QTextStream(stdout)
+            << "This is a simple tool for migrating custom contact details between the" << endl
+            << "compact encoding and the encoding using one nao:Property per field value." << endl
+            << "Usage: " << argv[0] << " --compact|--expand" << endl;
+        return EXIT_FAILURE;
+    }
+
+    const bool compact = (arguments.at(1) == QLatin1String("--compact"));
+
+    QMap<QString, QString> parameters;
+    parameters.insert(QLatin1String("compact-custom-details"),
+                      compact ? QLatin1String("true") : QLatin1String("false"));
+
+    QContactManager manager(QLatin1String("tracker"), parameters);
+    const QList<QContactLocalId> localIds = manager.contactIds();
+
+    if (manager.error() != QContactManager::NoError) {
+        QTextStream(stderr) << "Cannot list contacts, error " << manager.error() << endl;
+        return EXIT_FAILURE;
+    }
+
+    QHash<QString, QStringList> knownDefinitions;
+    int migratedCount = 0, failureCount = 0;
+
+    for(int i = 0; i < localIds.count(); i += BatchSize) {
+        QList<QContact> contacts;
+        QSet<QString> customDetails;
+
+        foreach(const QContact &contact, manager.contacts(localIds.mid(i, BatchSize))) {
+            QStringList &definitionNames = knownDefinitions[contact.type()];
+
+            if (definitionNames.isEmpty()) {
+                definitionNames = manager.detailDefinitions(contact.type()).keys();
+            }
+
+            bool hasCustomDetails = false;
+
+            foreach(const QContactDetail &detail, contact.details()) {
+                if (not definitionNames.contains(detail.definitionName())) {
+                    customDetails += detail.definitionName();
+                    hasCustomDetails = true;
+                }
+            }
+
+            if (hasCustomDetails) {
+                contacts += contact;
+            }
+        }
+
+        if (contacts.isEmpty()) {
+            continue;
+        }
+
+        QMap<int, QContactManager::Error> errorMap;
+
+        if (not manager.saveContacts(&contacts, customDetails.toList(), &errorMap)) {
+            QTextStream(stderr)
+                << "Failed to migrate " << errorMap.size() << " of "
+                << contacts.count() << " contacts." << endl;
+        }
+
+        migratedCount += contacts.count() - errorMap.size();
+        failureCount += errorMap.size();
+    }
+
+    QTextStream(stdout)
+        << "Migrated custom details of " << migratedCount << " contacts, "
+        << failureCount << " failures." << endl;
+
+    return (failureCount > 0 ? EXIT_FAILURE : EXIT_SUCCESS);
+}
@@ -23,6 +23,7 @@
 TEMPLATE = subdirs
 
 SUBDIRS = \
+    migratecustomdetails.pro \
     vcardreader.pro \
     vcardwriter.pro \
     vcf2xml.pro
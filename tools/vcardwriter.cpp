@@ -22,31 +22,47 @@
  ** conditions contained in a signed written agreement between you and Nokia.
  *********************************************************************************/
 
-#include <QBuffer>
 #include <QContactManager>
 #include <QCoreApplication>
 #include <QFile>
+#include <QStringList>
 #include <QVersitContactExporter>
 #include <QVersitWriter>
 
 QTM_USE_NAMESPACE
 
-int main(int argc, char **argv)
+static const int DefaultPageSize = 100;
+
+static bool
+writeContacts(QIODevice *device, const QList<QContact> &contacts)
 {
-    QCoreApplication app(argc, argv);
+    QVersitContactExporter exporter;
 
-    if (argc < 2) {
-        QTextStream(stdout)
-            << "This is a simple tool for exporting vCard files from tracker." << endl
-            << "Usage: " << argv[0] << " CONTACTID" << endl;
-        return EXIT_FAILURE;
+    if (not exporter.exportContacts(contacts)) {
+        QTextStream(stderr) << "Unable to convert the contact(s) into vcard(s)." << endl;
+        return false;
+    }
+
+    QVersitWriter streamWriter(device);
+
+    if (not streamWriter.startWriting(exporter.documents()) ||
+        not streamWriter.waitForFinished() ||
+        QVersitWriter::NoError != streamWriter.error()) {
+        QTextStream(stderr) << "Unable to write the vcard(s), bailing out." << endl;
+        return false;
     }
 
+    return true;
+}
+
+static int
+exportContact(QIODevice *device, const QString &argument)
+{
     bool isLocalId = false;
-    QContactLocalId localId = QString(argv[1]).toUInt(&isLocalId);
+    QContactLocalId localId = argument.toUInt(&isLocalId);
 
     if (not isLocalId) {
-        QTextStream(stderr) << "Numeric local contact id expected: " << argv[1] << endl;
+        QTextStream(stderr) << "Numeric local contact id expected: " << argument << endl;
         return EXIT_FAILURE;
     }
 
@@ -57,20 +73,104 @@ int main(int argc, char **argv)
         return EXIT_FAILURE;
     }
 
-    QVersitContactExporter exporter;
-    exporter.exportContacts(contacts);
+    return writeContacts(device, contacts) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
 
-    QByteArray buff;
-    QVersitWriter streamWriter(&buff);
+static int
+exportAllContacts(QIODevice *device, int pageSize)
+{
+    QContactManager manager;
 
-    if (not streamWriter.startWriting(exporter.documents())) {
-        QTextStream(stderr) << "Unable to write the vcard(s), bailing out." << endl;
+    // Only the local ids of the whole address book are kept in memory. The contacts
+    // themselves are fetched in id-ordered pages, and each page is serialized to the
+    // output device before the next one is fetched. This keeps memory consumption
+    // bounded by the page size instead of by the size of the database.
+    QList<QContactLocalId> localIds = manager.contactIds();
+    qSort(localIds);
+
+    QContactFetchHint fetchHint;
+    fetchHint.setOptimizationHints(QContactFetchHint::NoRelationships);
+
+    for(int offset = 0; offset < localIds.count(); offset += pageSize) {
+        const QList<QContact> contacts = manager.contacts(localIds.mid(offset, pageSize), fetchHint);
+
+        if (QContactManager::NoError != manager.error()) {
+            QTextStream(stderr) << "Cannot fetch contacts: error " << manager.error() << endl;
+            return EXIT_FAILURE;
+        }
+
+        if (not writeContacts(device, contacts)) {
+            return EXIT_FAILURE;
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
+
+int main(int argc, char **argv)
+{
+    QCoreApplication app(argc, argv);
+
+    const QString allOption = QLatin1String("--all");
+    const QString pageSizeOption = QLatin1String("--page-size=");
+    const QString outputOption = QLatin1String("--output=");
+
+    QString contactId;
+    QString outputFileName;
+    int pageSize = DefaultPageSize;
+    bool exportAll = false;
+
+    foreach(const QString &argument, app.arguments().mid(1)) {
+        if (argument == allOption) {
+            exportAll = true;
+        } else if (argument.startsWith(pageSizeOption)) {
+            bool success = false;
+            pageSize = argument.mid(pageSizeOption.length()).toInt(&success);
+
+            if (not success || pageSize < 1) {
+                QTextStream(stderr) << "Positive page size expected: " << argument << endl;
+                return EXIT_FAILURE;
+            }
+        } else if (argument.startsWith(outputOption)) {
+            outputFileName = argument.mid(outputOption.length());
+        } else if (contactId.isEmpty() && not argument.startsWith(QLatin1String("--"))) {
+            contactId = argument;
+        } else {
+            contactId.clear();
+            exportAll = false;
+            break;
+        }
+    }
+
+    if (exportAll == not contactId.isEmpty()) {
+        QTextStream(stdout)
+            << "This is a simple tool for exporting vCard files from tracker." << endl
+            << "Usage: " << argv[0] << " [--output=FILE] CONTACTID" << endl
+            << "       " << argv[0] << " [--output=FILE] [--page-size=N] --all" << endl;
         return EXIT_FAILURE;
     }
 
-    streamWriter.waitForFinished();
+    QFile output;
 
-    QTextStream(stdout) << buff;
+    if (outputFileName.isEmpty()) {
+        if (not output.open(stdout, QFile::WriteOnly)) {
+            QTextStream(stderr) << "Cannot open STDOUT for writing: "
+                                << output.errorString() << endl;
+            return EXIT_FAILURE;
+        }
+    } else {
+        output.setFileName(outputFileName);
 
-    return EXIT_SUCCESS;
+        if (not output.open(QFile::WriteOnly | QFile::Truncate)) {
+            QTextStream(stderr) << "Cannot open " << outputFileName << " for writing: "
+                                << output.errorString() << endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (exportAll) {
+        return exportAllContacts(&output, pageSize);
+    }
+
+    return exportContact(&output, contactId);
 }